@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "rpn_program.h"
+#include "rpn_batch.h"
+#include "bench.h"
+
+/* One formula over many rows of two input columns, evaluated a row at a time
+ * with rpn_eval and a batch at a time with rpn_run_batch.
+ * Usage: bench_batch [rows] [formula]
+ */
+
+int main ( int argc, char ** argv ) {
+
+    int n = argc > 1 ? atoi(argv[1]) : 10000000;
+    const char * formula = argc > 2 ? argv[2] : "x0 1.5 * x1 + x0 x1 * 0.25 * neg + x0 x0 * +";
+
+    RPN_ERROR error;
+    RpnProgram * p = rpn_compile(formula, &error);
+    if ( p == NULL ) {
+        printf("cannot compile %s (error %d)\n", formula, error);
+        return 1;
+    }
+
+    double * x0 = (double *) malloc(n * sizeof(double)),
+           * x1 = (double *) malloc(n * sizeof(double)),
+           * out = (double *) malloc(n * sizeof(double));
+    unsigned char * overflow = (unsigned char *) malloc(n);
+    for ( int i=0; i<n; i++ ) {
+        x0[i] = 1e-3 * ( i % 1000 );
+        x1[i] = 20 + 1e-4 * ( i % 777 );
+    }
+    const double * columns[2] = { x0, x1 };
+
+    double t = bench_now(), sum = 0;
+    int overflows = 0;
+    for ( int i=0; i<n; i++ ) {
+        double row[2] = { x0[i], x1[i] };
+        out[i] = rpn_eval(p, row, &error);
+        overflow[i] = error == OVERFLOW_ERROR;
+        overflows += overflow[i];
+    }
+    double per_row = bench_now() - t;
+    sum += out[n/2];
+
+    t = bench_now();
+    overflows += rpn_run_batch(p, columns, n, out, overflow);
+    double batch = bench_now() - t;
+    sum += out[n/2];
+    bench_sink = sum + overflows;
+
+    printf("%s: %d ops, %d rows\n", formula, p->num_ops, n);
+    printf("per row    %8.1f M rows/s  %8.1f M ops/s\n", 1e-6 * n / per_row, 1e-6 * n * p->num_ops / per_row);
+    printf("batch      %8.1f M rows/s  %8.1f M ops/s  (%.1fx)\n", 1e-6 * n / batch,
+           1e-6 * n * p->num_ops / batch, per_row / batch);
+
+    rpn_program_free(p);
+    free(x0);
+    free(x1);
+    free(out);
+    free(overflow);
+    return 0;
+
+}
@@ -0,0 +1,69 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "rpn_program.h"
+#include "rpn_batch.h"
+#include "bench.h"
+
+/* One formula evaluated over many rows, as compiled and after rpn_optimize,
+ * a row at a time and in batches. The default is a polynomial in Horner form
+ * with constant subexpressions in its coefficients.
+ * Usage: bench_optimize [rows] [formula]
+ */
+
+static const char * horner =
+    "x0 2 0.5 * * 1 3 + neg neg + x0 * 0.25 neg neg + x0 * 1 0.5 ~ * + x0 * x1 x1 * +";
+
+static void run ( const char * name, const RpnProgram * p, const double * const * columns,
+                  int n, double * out, unsigned char * overflow ) {
+    RPN_ERROR error;
+    double t = bench_now(), sum = 0;
+    for ( int i=0; i<n; i++ ) {
+        double row[2] = { columns[0][i], columns[1][i] };
+        sum += rpn_eval(p, row, &error);
+    }
+    double per_row = bench_now() - t;
+    t = bench_now();
+    rpn_run_batch(p, columns, n, out, overflow);
+    double batch = bench_now() - t;
+    bench_sink = sum + out[n/2];
+    printf("%-10s %3d ops, depth %2d   per row %7.1f M rows/s   batch %7.1f M rows/s\n",
+           name, p->num_ops, p->max_depth, 1e-6 * n / per_row, 1e-6 * n / batch);
+}
+
+int main ( int argc, char ** argv ) {
+
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    const char * formula = argc > 2 ? argv[2] : horner;
+
+    RPN_ERROR error;
+    RpnProgram * p = rpn_compile(formula, &error),
+               * q = rpn_compile(formula, &error);
+    if ( p == NULL ) {
+        printf("cannot compile %s (error %d)\n", formula, error);
+        return 1;
+    }
+    rpn_optimize(q);
+
+    double * x0 = (double *) malloc(n * sizeof(double)),
+           * x1 = (double *) malloc(n * sizeof(double)),
+           * out = (double *) malloc(n * sizeof(double));
+    unsigned char * overflow = (unsigned char *) malloc(n);
+    for ( int i=0; i<n; i++ ) {
+        x0[i] = 1e-3 * ( i % 1000 );
+        x1[i] = 20 + 1e-4 * ( i % 777 );
+    }
+    const double * columns[2] = { x0, x1 };
+
+    printf("%s: %d rows\n", formula, n);
+    run("compiled", p, columns, n, out, overflow);
+    run("optimized", q, columns, n, out, overflow);
+
+    rpn_program_free(p);
+    rpn_program_free(q);
+    free(x0);
+    free(x1);
+    free(out);
+    free(overflow);
+    return 0;
+
+}
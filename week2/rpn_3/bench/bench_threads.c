@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "rpn.h"
+#include "bench.h"
+
+/* Throughput of evaluating the formula -(x + 1) * (x + 2) on RpnContexts, one
+ * per thread, for 1, 2, 4, ... threads up to twice the number of CPUs, next to
+ * the global interface on one thread.
+ * Usage: bench_threads [evaluations per thread]
+ */
+
+#define OPS_PER_EVALUATION 9 /* four pushes, two adds, a multiply, a negate, a pop */
+
+typedef struct {
+    long n;
+    double sum;
+} Work;
+
+static void * evaluate ( void * arg ) {
+    Work * w = (Work *) arg;
+    RpnContext * ctx = rpn_ctx_new();
+    double sum = 0;
+    for ( long i=0; i<w->n; i++ ) {
+        double x = (double) ( i & 1023 );
+        rpn_ctx_push(ctx, x);
+        rpn_ctx_push(ctx, 1);
+        rpn_ctx_add(ctx);
+        rpn_ctx_push(ctx, x);
+        rpn_ctx_push(ctx, 2);
+        rpn_ctx_add(ctx);
+        rpn_ctx_multiply(ctx);
+        rpn_ctx_negate(ctx);
+        sum += rpn_ctx_pop(ctx);
+    }
+    rpn_ctx_free(ctx);
+    w->sum = sum;
+    return NULL;
+}
+
+int main ( int argc, char ** argv ) {
+
+    long n = argc > 1 ? atol(argv[1]) : 10000000;
+    int cpus = (int) sysconf(_SC_NPROCESSORS_ONLN);
+
+    double t = bench_now(), sum = 0;
+    rpn_init();
+    for ( long i=0; i<n; i++ ) {
+        double x = (double) ( i & 1023 );
+        rpn_push(x);
+        rpn_push(1);
+        rpn_add();
+        rpn_push(x);
+        rpn_push(2);
+        rpn_add();
+        rpn_multiply();
+        rpn_negate();
+        sum += rpn_pop();
+    }
+    rpn_free();
+    t = bench_now() - t;
+    printf("global API, 1 thread    %8.1f M evaluations/s  %8.1f M ops/s\n",
+           1e-6 * n / t, 1e-6 * n * OPS_PER_EVALUATION / t);
+
+    for ( int threads=1; threads <= 2 * cpus; threads *= 2 ) {
+        pthread_t * ids = (pthread_t *) malloc(threads * sizeof(pthread_t));
+        Work * work = (Work *) malloc(threads * sizeof(Work));
+        t = bench_now();
+        for ( int i=0; i<threads; i++ ) {
+            work[i].n = n;
+            pthread_create(&ids[i], NULL, evaluate, &work[i]);
+        }
+        for ( int i=0; i<threads; i++ ) {
+            pthread_join(ids[i], NULL);
+            sum += work[i].sum;
+        }
+        t = bench_now() - t;
+        printf("contexts, %2d thread%s    %8.1f M evaluations/s  %8.1f M ops/s\n", threads,
+               threads > 1 ? "s" : " ", 1e-6 * n * threads / t, 1e-6 * n * threads * OPS_PER_EVALUATION / t);
+        free(ids);
+        free(work);
+    }
+
+    bench_sink = sum;
+    return 0;
+
+}
@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rpn.h"
+#include "rpn_program.h"
+#include "bench.h"
+
+/* Operations per second through the call-per-op interfaces, global and
+ * RpnContext, and through a compiled program, for a short formula evaluated
+ * many times and a long one of alternating pushes, adds, multiplies and
+ * negates.
+ * Usage: bench_vm [operations]
+ */
+
+/* Makes a formula of n pushes and the operators that combine them, and the
+   same formula as a list of ops for the call-per-op interfaces */
+static char * long_formula ( int n, unsigned char * ops, double * values, int * num_ops ) {
+    char * s = (char *) malloc(16 * (size_t) n + 1);
+    int len = 0, k = 0;
+    for ( int i=0; i<n; i++ ) {
+        values[i] = 1.0 + ( i % 7 ) * 1e-3;
+        len += sprintf(s + len, "%g ", values[i]);
+        ops[k++] = RPN_OP_PUSH;
+        if ( i > 0 ) {
+            unsigned char op = i % 3 == 0 ? RPN_OP_MULTIPLY : RPN_OP_ADD;
+            len += sprintf(s + len, "%s ", op == RPN_OP_ADD ? "+" : "*");
+            ops[k++] = op;
+        }
+        if ( i % 5 == 0 ) {
+            len += sprintf(s + len, "neg ");
+            ops[k++] = RPN_OP_NEGATE;
+        }
+    }
+    *num_ops = k;
+    return s;
+}
+
+static void report ( const char * name, double seconds, double ops ) {
+    printf("%-28s %8.1f M ops/s\n", name, 1e-6 * ops / seconds);
+}
+
+int main ( int argc, char ** argv ) {
+
+    long total = argc > 1 ? atol(argv[1]) : 100000000;
+    RPN_ERROR error;
+    double sum = 0, t;
+
+    /* A short formula: -(3 + 1) * (3 + 2), 8 ops */
+    long reps = total / 8;
+    RpnProgram * p = rpn_compile("3 1 + 3 2 + * neg", &error);
+
+    t = bench_now();
+    rpn_init();
+    for ( long r=0; r<reps; r++ ) {
+        rpn_push(3); rpn_push(1); rpn_add();
+        rpn_push(3); rpn_push(2); rpn_add();
+        rpn_multiply(); rpn_negate();
+        sum += rpn_pop();
+    }
+    rpn_free();
+    report("short, global calls", bench_now() - t, 8.0 * reps);
+
+    RpnContext * ctx = rpn_ctx_new();
+    t = bench_now();
+    for ( long r=0; r<reps; r++ ) {
+        rpn_ctx_push(ctx, 3); rpn_ctx_push(ctx, 1); rpn_ctx_add(ctx);
+        rpn_ctx_push(ctx, 3); rpn_ctx_push(ctx, 2); rpn_ctx_add(ctx);
+        rpn_ctx_multiply(ctx); rpn_ctx_negate(ctx);
+        sum += rpn_ctx_pop(ctx);
+    }
+    report("short, context calls", bench_now() - t, 8.0 * reps);
+
+    t = bench_now();
+    for ( long r=0; r<reps; r++ ) {
+        sum += rpn_run(p, &error);
+    }
+    report("short, compiled", bench_now() - t, 8.0 * reps);
+    rpn_program_free(p);
+
+    /* A long formula, run through the ops in a loop for the call-per-op interfaces */
+    int n = 10000, num_ops;
+    unsigned char * ops = (unsigned char *) malloc(3 * n);
+    double * values = (double *) malloc(n * sizeof(double));
+    char * source = long_formula(n, ops, values, &num_ops);
+    p = rpn_compile(source, &error);
+    reps = total / num_ops;
+
+    t = bench_now();
+    for ( long r=0; r<reps; r++ ) {
+        const double * v = values;
+        rpn_ctx_reset(ctx);
+        for ( int i=0; i<num_ops; i++ ) {
+            switch ( ops[i] ) {
+                case RPN_OP_PUSH:     rpn_ctx_push(ctx, *v++); break;
+                case RPN_OP_ADD:      rpn_ctx_add(ctx); break;
+                case RPN_OP_MULTIPLY: rpn_ctx_multiply(ctx); break;
+                case RPN_OP_NEGATE:   rpn_ctx_negate(ctx); break;
+            }
+        }
+        sum += rpn_ctx_pop(ctx);
+    }
+    report("long, context calls", bench_now() - t, (double) num_ops * reps);
+
+    t = bench_now();
+    for ( long r=0; r<reps; r++ ) {
+        sum += rpn_run(p, &error);
+    }
+    report("long, compiled", bench_now() - t, (double) num_ops * reps);
+
+    rpn_program_free(p);
+    rpn_ctx_free(ctx);
+    free(source);
+    free(ops);
+    free(values);
+    bench_sink = sum;
+    return 0;
+
+}
@@ -1,101 +1,162 @@
 #include <stdio.h>
 #include <math.h>
+#include <limits.h>
 
 #include "rpn.h"
 
 #define INITIAL_STACK_SIZE 100
 
-static double * stack;
-static int initialized = 0;
-static int top = 0;
-static RPN_ERROR error = OK;
+/* The context behind the global functions, NULL until rpn_init */
+static RpnContext * global = NULL;
+static RPN_ERROR error = OK;   /* errors raised while there is no global context */
 
 void rpn_show() {
     printf("--->\n");
-    for ( int i=0; i<top; i++ ) {
-        printf("  %lf\n", stack[i]);
+    for ( int i=0; global != NULL && i<global->top; i++ ) {
+        printf("  %lf\n", global->stack[i]);
     }
     printf("<---\n");
 }
 
+/* Contexts ******************************************************************/
+
+RpnContext * rpn_ctx_new() {
+    RpnContext * ctx = (RpnContext *) malloc(sizeof(RpnContext));
+    ctx->capacity = INITIAL_STACK_SIZE;
+    ctx->stack = (double *) calloc(ctx->capacity, sizeof(double));
+    ctx->top = 0;
+    ctx->error = OK;
+    return ctx;
+}
+
+void rpn_ctx_push(RpnContext * ctx, double x) {
+    if ( ctx->top == ctx->capacity ) {
+        double * stack = ctx->capacity <= INT_MAX / 2
+                       ? (double *) realloc(ctx->stack, 2 * (size_t) ctx->capacity * sizeof(double))
+                       : NULL;
+        if ( stack == NULL ) {
+            ctx->error = MEMORY_ERROR;
+            return;
+        }
+        ctx->stack = stack;
+        ctx->capacity *= 2;
+    }
+    ctx->stack[ctx->top] = x;
+    ctx->top++;
+}
+
+void rpn_ctx_add(RpnContext * ctx) {
+    if ( ctx->top < 2 ) {
+        ctx->error = BINARY_ERROR;
+    } else {
+        double x = ctx->stack[ctx->top-1]+ctx->stack[ctx->top-2];
+        if ( x == INFINITY ) {
+            ctx->error = OVERFLOW_ERROR;
+        }
+        ctx->top--;
+        ctx->stack[ctx->top-1] = x;
+    }
+}
+
+void rpn_ctx_negate(RpnContext * ctx) {
+    if ( ctx->top < 1 ) {
+        ctx->error = UNARY_ERROR;
+    } else {
+        ctx->stack[ctx->top-1] = -ctx->stack[ctx->top-1];
+    }
+}
+
+void rpn_ctx_multiply(RpnContext * ctx) {
+    if ( ctx->top < 2 ) {
+        ctx->error = BINARY_ERROR;
+    } else {
+        double x = ctx->stack[ctx->top-1]*ctx->stack[ctx->top-2];
+        if ( x == INFINITY || x == -INFINITY ) {
+            ctx->error = OVERFLOW_ERROR;
+        }
+        ctx->top--;
+        ctx->stack[ctx->top-1] = x;
+    }
+}
+
+double rpn_ctx_pop(RpnContext * ctx) {
+    if ( ctx->top == 0 ) {
+        ctx->error = POP_ERROR;
+        return 0;
+    } else {
+        ctx->top--;
+        return ctx->stack[ctx->top];
+    }
+}
+
+RPN_ERROR rpn_ctx_error(const RpnContext * ctx) { return ctx->error; }
+
+void rpn_ctx_reset(RpnContext * ctx) {
+    ctx->top = 0;
+    ctx->error = OK;
+}
+
+void rpn_ctx_free(RpnContext * ctx) {
+    free(ctx->stack);
+    free(ctx);
+}
+
+/* The global context *******************************************************/
+
 void rpn_init() {
-  if ( ! initialized ) {
-      stack = (double *) calloc(INITIAL_STACK_SIZE, sizeof(double));
-      initialized = 1;
-      top = 0;
-      error = OK;
-  }
+    if ( global == NULL ) {
+        global = rpn_ctx_new();
+        error = OK;
+    }
 }
 
 void rpn_push(double x) {
-    if ( !initialized ) {
+    if ( global == NULL ) {
         error = NOT_INITIALIZED_ERROR;
     } else {
-        stack[top] = x;
-        top++;
+        rpn_ctx_push(global, x);
     }
 }
 
-void rpn_add() {  
-    if ( !initialized ) {
+void rpn_add() {
+    if ( global == NULL ) {
         error = NOT_INITIALIZED_ERROR;
-    } else if ( top < 2 ) {
-        error = BINARY_ERROR;
-    } else {    
-        double x = stack[top-1]+stack[top-2];
-        if ( x == INFINITY ) {
-            error = OVERFLOW_ERROR;
-        } 
-        top--;
-        stack[top-1] = x;
+    } else {
+        rpn_ctx_add(global);
     }
 }
 
 void rpn_negate() {
-    if ( !initialized ) {
+    if ( global == NULL ) {
         error = NOT_INITIALIZED_ERROR;
-    } else if ( top < 1 ) {
-        error = UNARY_ERROR;
-    } else {    
-      stack[top-1] = -stack[top-1];
+    } else {
+        rpn_ctx_negate(global);
     }
 }
 
 void rpn_multiply() {
-    if ( !initialized ) {
+    if ( global == NULL ) {
         error = NOT_INITIALIZED_ERROR;
-    } else if ( top < 2 ) {
-        error = BINARY_ERROR;
-    } else {    
-        double x = stack[top-1]*stack[top-2];
-        if ( x == INFINITY || x == -INFINITY ) {
-            error = OVERFLOW_ERROR;
-        } 
-        top--;
-        stack[top-1] = x;
+    } else {
+        rpn_ctx_multiply(global);
     }
 }
 
-double rpn_pop() { 
-    if ( !initialized ) {
+double rpn_pop() {
+    if ( global == NULL ) {
         error = NOT_INITIALIZED_ERROR;
         return 0;
-    } else if ( top == 0 ) {
-        error = POP_ERROR;
-        return 0;        
     } else {
-        double result = stack[top-1];
-        top--;
-        return result;
+        return rpn_ctx_pop(global);
     }
- }
+}
 
-RPN_ERROR rpn_error() { return error; }
+RPN_ERROR rpn_error() { return global != NULL ? global->error : error; }
 
 void rpn_free() {
-    if ( initialized ) {
-        free(stack);
-        initialized = 0;
+    if ( global != NULL ) {
+        rpn_ctx_free(global);
+        global = NULL;
     }
     error = OK;
-}
\ No newline at end of file
+}
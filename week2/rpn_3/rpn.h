@@ -9,9 +9,42 @@ typedef enum {
     POP_ERROR, 
     UNARY_ERROR, 
     BINARY_ERROR, 
-    OVERFLOW_ERROR
+    OVERFLOW_ERROR,
+    SYNTAX_ERROR,    /* an unknown token, from rpn_compile */
+    MEMORY_ERROR     /* the stack could not grow, and the push was dropped */
 } RPN_ERROR;
 
+/*! An evaluation stack with its own error state. Contexts share nothing, so
+ *  each thread can evaluate with its own context without locking. The stack
+ *  grows as needed. As with the global functions, an error stays set until
+ *  the context is reset or freed.
+ */
+typedef struct {
+    double * stack;
+    int top,
+        capacity;
+    RPN_ERROR error;
+} RpnContext;
+
+RpnContext * rpn_ctx_new();
+
+/*! Pushes x, growing the stack if it is full. If there is no memory to grow
+ *  it, sets MEMORY_ERROR and leaves the stack as it was.
+ */
+void rpn_ctx_push(RpnContext * ctx, double x);
+void rpn_ctx_add(RpnContext * ctx);
+void rpn_ctx_negate(RpnContext * ctx);
+void rpn_ctx_multiply(RpnContext * ctx);
+double rpn_ctx_pop(RpnContext * ctx);
+RPN_ERROR rpn_ctx_error(const RpnContext * ctx);
+
+/*! Empties the stack and clears the error, keeping the memory for reuse
+ */
+void rpn_ctx_reset(RpnContext * ctx);
+void rpn_ctx_free(RpnContext * ctx);
+
+/* The original interface, which works on a single context shared by the
+   whole process. It is not safe to use from more than one thread. */
 void rpn_init();
 void rpn_push(double x);
 void rpn_add();
@@ -21,4 +54,4 @@ double rpn_pop();
 RPN_ERROR rpn_error();
 void rpn_free();
 
-#endif
\ No newline at end of file
+#endif
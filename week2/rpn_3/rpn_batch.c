@@ -0,0 +1,551 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "rpn_batch.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RPN_X86
+#include <immintrin.h>
+#endif
+
+#define ROWS RPN_BATCH_ROWS
+
+/* column kernels ************************************************************/
+
+/* The part of the scratch space that belongs to stack slot d */
+static double * own ( double * scratch, int d ) {
+    return scratch + (size_t) d * ROWS;
+}
+
+/* The result of an operation may be written over one of its operands, so the
+   pointers are not restrict; the loops run forward, element by element, which
+   keeps that safe. The _constant forms take a number for the second operand,
+   so pushing a constant never fills a column.
+
+   The arithmetic kernels do not look for overflow. With only adds, multiplies
+   and negations, a row whose value once becomes infinite stays infinite or NaN
+   in everything computed from it, so it is enough to test the values the
+   program computed once, at the end, with nonfinite or copy. That flags a superset of
+   the rows rpn_eval would, and those batches are run again a row at a time. */
+
+typedef struct {
+    void (*add) ( double * out, const double * a, const double * b, int m );
+    void (*multiply) ( double * out, const double * a, const double * b, int m );
+    void (*add_constant) ( double * out, const double * a, double c, int m );
+    void (*multiply_constant) ( double * out, const double * a, double c, int m );
+    void (*negate) ( double * out, const double * a, int m );
+    void (*multiply_add) ( double * out, const double * a, const double * b, const double * c, int m );
+    void (*multiply_constant_add) ( double * out, const double * a, double b, const double * c, int m );
+    int (*nonfinite) ( const double * a, int m );
+    int (*copy) ( double * out, const double * a, int m );
+} Kernels;
+
+static void add_scalar ( double * out, const double * a, const double * b, int m ) {
+    for ( int i=0; i<m; i++ ) {
+        out[i] = a[i] + b[i];
+    }
+}
+
+static void multiply_scalar ( double * out, const double * a, const double * b, int m ) {
+    for ( int i=0; i<m; i++ ) {
+        out[i] = a[i] * b[i];
+    }
+}
+
+static void add_constant_scalar ( double * out, const double * a, double c, int m ) {
+    for ( int i=0; i<m; i++ ) {
+        out[i] = a[i] + c;
+    }
+}
+
+static void multiply_constant_scalar ( double * out, const double * a, double c, int m ) {
+    for ( int i=0; i<m; i++ ) {
+        out[i] = a[i] * c;
+    }
+}
+
+static void negate_scalar ( double * out, const double * a, int m ) {
+    for ( int i=0; i<m; i++ ) {
+        out[i] = -a[i];
+    }
+}
+
+/* The product is rounded before the add, as in rpn_eval, so these give the
+   same results as a multiply followed by an add */
+static void multiply_add_scalar ( double * out, const double * a, const double * b,
+                                  const double * c, int m ) {
+    for ( int i=0; i<m; i++ ) {
+        double product = a[i] * b[i];
+        out[i] = product + c[i];
+    }
+}
+
+static void multiply_constant_add_scalar ( double * out, const double * a, double b,
+                                           const double * c, int m ) {
+    for ( int i=0; i<m; i++ ) {
+        double product = a[i] * b;
+        out[i] = product + c[i];
+    }
+}
+
+/* Non-zero if any of the m values is infinite or NaN */
+static int nonfinite_scalar ( const double * a, int m ) {
+    int any = 0;
+    for ( int i=0; i<m; i++ ) {
+        any |= !isfinite(a[i]);
+    }
+    return any;
+}
+
+/* Copies the m values to out, and tests them as nonfinite does on the way */
+static int copy_scalar ( double * out, const double * a, int m ) {
+    int any = 0;
+    for ( int i=0; i<m; i++ ) {
+        out[i] = a[i];
+        any |= !isfinite(a[i]);
+    }
+    return any;
+}
+
+static const Kernels scalar_kernels = {
+    add_scalar, multiply_scalar, add_constant_scalar, multiply_constant_scalar, negate_scalar,
+    multiply_add_scalar, multiply_constant_add_scalar, nonfinite_scalar, copy_scalar
+};
+
+#ifdef RPN_X86
+
+/* AVX2 kernels: 4 rows per register, with the scalar ones for the last few */
+
+__attribute__((target("avx2")))
+static void add_avx2 ( double * out, const double * a, const double * b, int m ) {
+    int i = 0;
+    for ( ; i + 4 <= m; i += 4 ) {
+        _mm256_storeu_pd(out+i, _mm256_add_pd(_mm256_loadu_pd(a+i), _mm256_loadu_pd(b+i)));
+    }
+    add_scalar(out+i, a+i, b+i, m-i);
+}
+
+__attribute__((target("avx2")))
+static void multiply_avx2 ( double * out, const double * a, const double * b, int m ) {
+    int i = 0;
+    for ( ; i + 4 <= m; i += 4 ) {
+        _mm256_storeu_pd(out+i, _mm256_mul_pd(_mm256_loadu_pd(a+i), _mm256_loadu_pd(b+i)));
+    }
+    multiply_scalar(out+i, a+i, b+i, m-i);
+}
+
+__attribute__((target("avx2")))
+static void add_constant_avx2 ( double * out, const double * a, double c, int m ) {
+    __m256d b = _mm256_set1_pd(c);
+    int i = 0;
+    for ( ; i + 4 <= m; i += 4 ) {
+        _mm256_storeu_pd(out+i, _mm256_add_pd(_mm256_loadu_pd(a+i), b));
+    }
+    add_constant_scalar(out+i, a+i, c, m-i);
+}
+
+__attribute__((target("avx2")))
+static void multiply_constant_avx2 ( double * out, const double * a, double c, int m ) {
+    __m256d b = _mm256_set1_pd(c);
+    int i = 0;
+    for ( ; i + 4 <= m; i += 4 ) {
+        _mm256_storeu_pd(out+i, _mm256_mul_pd(_mm256_loadu_pd(a+i), b));
+    }
+    multiply_constant_scalar(out+i, a+i, c, m-i);
+}
+
+__attribute__((target("avx2")))
+static void negate_avx2 ( double * out, const double * a, int m ) {
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    int i = 0;
+    for ( ; i + 4 <= m; i += 4 ) {
+        _mm256_storeu_pd(out+i, _mm256_xor_pd(_mm256_loadu_pd(a+i), sign));
+    }
+    negate_scalar(out+i, a+i, m-i);
+}
+
+__attribute__((target("avx2")))
+static void multiply_add_avx2 ( double * out, const double * a, const double * b,
+                                const double * c, int m ) {
+    int i = 0;
+    for ( ; i + 4 <= m; i += 4 ) {
+        __m256d product = _mm256_mul_pd(_mm256_loadu_pd(a+i), _mm256_loadu_pd(b+i));
+        _mm256_storeu_pd(out+i, _mm256_add_pd(product, _mm256_loadu_pd(c+i)));
+    }
+    multiply_add_scalar(out+i, a+i, b+i, c+i, m-i);
+}
+
+__attribute__((target("avx2")))
+static void multiply_constant_add_avx2 ( double * out, const double * a, double b,
+                                         const double * c, int m ) {
+    __m256d k = _mm256_set1_pd(b);
+    int i = 0;
+    for ( ; i + 4 <= m; i += 4 ) {
+        __m256d product = _mm256_mul_pd(_mm256_loadu_pd(a+i), k);
+        _mm256_storeu_pd(out+i, _mm256_add_pd(product, _mm256_loadu_pd(c+i)));
+    }
+    multiply_constant_add_scalar(out+i, a+i, b, c+i, m-i);
+}
+
+/* |x| is not below infinity only for infinities and NaNs, which compare unordered */
+__attribute__((target("avx2")))
+static int nonfinite_avx2 ( const double * a, int m ) {
+    const __m256d sign = _mm256_set1_pd(-0.0),
+                  inf = _mm256_set1_pd(INFINITY);
+    __m256d any = _mm256_setzero_pd();
+    int i = 0;
+    for ( ; i + 4 <= m; i += 4 ) {
+        __m256d x = _mm256_andnot_pd(sign, _mm256_loadu_pd(a+i));
+        any = _mm256_or_pd(any, _mm256_cmp_pd(x, inf, _CMP_NLT_UQ));
+    }
+    return _mm256_movemask_pd(any) | nonfinite_scalar(a+i, m-i);
+}
+
+__attribute__((target("avx2")))
+static int copy_avx2 ( double * out, const double * a, int m ) {
+    const __m256d sign = _mm256_set1_pd(-0.0),
+                  inf = _mm256_set1_pd(INFINITY);
+    __m256d any = _mm256_setzero_pd();
+    int i = 0;
+    for ( ; i + 4 <= m; i += 4 ) {
+        __m256d x = _mm256_loadu_pd(a+i);
+        _mm256_storeu_pd(out+i, x);
+        any = _mm256_or_pd(any, _mm256_cmp_pd(_mm256_andnot_pd(sign, x), inf, _CMP_NLT_UQ));
+    }
+    return _mm256_movemask_pd(any) | copy_scalar(out+i, a+i, m-i);
+}
+
+static const Kernels avx2_kernels = {
+    add_avx2, multiply_avx2, add_constant_avx2, multiply_constant_avx2, negate_avx2,
+    multiply_add_avx2, multiply_constant_add_avx2, nonfinite_avx2, copy_avx2
+};
+
+/* AVX-512 kernels: 8 rows per register, with masked loads and stores for the
+   last few */
+
+__attribute__((target("avx512f")))
+static void add_avx512 ( double * out, const double * a, const double * b, int m ) {
+    int i = 0;
+    for ( ; i + 8 <= m; i += 8 ) {
+        _mm512_storeu_pd(out+i, _mm512_add_pd(_mm512_loadu_pd(a+i), _mm512_loadu_pd(b+i)));
+    }
+    if ( i < m ) {
+        __mmask8 tail = (__mmask8) ((1u << (m - i)) - 1);
+        _mm512_mask_storeu_pd(out+i, tail, _mm512_add_pd(_mm512_maskz_loadu_pd(tail, a+i),
+                                                         _mm512_maskz_loadu_pd(tail, b+i)));
+    }
+}
+
+__attribute__((target("avx512f")))
+static void multiply_avx512 ( double * out, const double * a, const double * b, int m ) {
+    int i = 0;
+    for ( ; i + 8 <= m; i += 8 ) {
+        _mm512_storeu_pd(out+i, _mm512_mul_pd(_mm512_loadu_pd(a+i), _mm512_loadu_pd(b+i)));
+    }
+    if ( i < m ) {
+        __mmask8 tail = (__mmask8) ((1u << (m - i)) - 1);
+        _mm512_mask_storeu_pd(out+i, tail, _mm512_mul_pd(_mm512_maskz_loadu_pd(tail, a+i),
+                                                         _mm512_maskz_loadu_pd(tail, b+i)));
+    }
+}
+
+__attribute__((target("avx512f")))
+static void add_constant_avx512 ( double * out, const double * a, double c, int m ) {
+    __m512d b = _mm512_set1_pd(c);
+    int i = 0;
+    for ( ; i + 8 <= m; i += 8 ) {
+        _mm512_storeu_pd(out+i, _mm512_add_pd(_mm512_loadu_pd(a+i), b));
+    }
+    if ( i < m ) {
+        __mmask8 tail = (__mmask8) ((1u << (m - i)) - 1);
+        _mm512_mask_storeu_pd(out+i, tail, _mm512_add_pd(_mm512_maskz_loadu_pd(tail, a+i), b));
+    }
+}
+
+__attribute__((target("avx512f")))
+static void multiply_constant_avx512 ( double * out, const double * a, double c, int m ) {
+    __m512d b = _mm512_set1_pd(c);
+    int i = 0;
+    for ( ; i + 8 <= m; i += 8 ) {
+        _mm512_storeu_pd(out+i, _mm512_mul_pd(_mm512_loadu_pd(a+i), b));
+    }
+    if ( i < m ) {
+        __mmask8 tail = (__mmask8) ((1u << (m - i)) - 1);
+        _mm512_mask_storeu_pd(out+i, tail, _mm512_mul_pd(_mm512_maskz_loadu_pd(tail, a+i), b));
+    }
+}
+
+__attribute__((target("avx512f")))
+static void negate_avx512 ( double * out, const double * a, int m ) {
+    const __m512i sign = _mm512_set1_epi64((long long) 0x8000000000000000ULL);
+    int i = 0;
+    for ( ; i + 8 <= m; i += 8 ) {
+        _mm512_storeu_si512(out+i, _mm512_xor_si512(_mm512_loadu_si512(a+i), sign));
+    }
+    negate_scalar(out+i, a+i, m-i);
+}
+
+__attribute__((target("avx512f")))
+static void multiply_add_avx512 ( double * out, const double * a, const double * b,
+                                  const double * c, int m ) {
+    int i = 0;
+    for ( ; i + 8 <= m; i += 8 ) {
+        __m512d product = _mm512_mul_pd(_mm512_loadu_pd(a+i), _mm512_loadu_pd(b+i));
+        _mm512_storeu_pd(out+i, _mm512_add_pd(product, _mm512_loadu_pd(c+i)));
+    }
+    multiply_add_scalar(out+i, a+i, b+i, c+i, m-i);
+}
+
+__attribute__((target("avx512f")))
+static void multiply_constant_add_avx512 ( double * out, const double * a, double b,
+                                           const double * c, int m ) {
+    __m512d k = _mm512_set1_pd(b);
+    int i = 0;
+    for ( ; i + 8 <= m; i += 8 ) {
+        __m512d product = _mm512_mul_pd(_mm512_loadu_pd(a+i), k);
+        _mm512_storeu_pd(out+i, _mm512_add_pd(product, _mm512_loadu_pd(c+i)));
+    }
+    multiply_constant_add_scalar(out+i, a+i, b, c+i, m-i);
+}
+
+__attribute__((target("avx512f")))
+static int nonfinite_avx512 ( const double * a, int m ) {
+    const __m512d inf = _mm512_set1_pd(INFINITY);
+    __mmask8 any = 0;
+    int i = 0;
+    for ( ; i + 8 <= m; i += 8 ) {
+        any |= _mm512_cmp_pd_mask(_mm512_abs_pd(_mm512_loadu_pd(a+i)), inf, _CMP_NLT_UQ);
+    }
+    return any | nonfinite_scalar(a+i, m-i);
+}
+
+__attribute__((target("avx512f")))
+static int copy_avx512 ( double * out, const double * a, int m ) {
+    const __m512d inf = _mm512_set1_pd(INFINITY);
+    __mmask8 any = 0;
+    int i = 0;
+    for ( ; i + 8 <= m; i += 8 ) {
+        __m512d x = _mm512_loadu_pd(a+i);
+        _mm512_storeu_pd(out+i, x);
+        any |= _mm512_cmp_pd_mask(_mm512_abs_pd(x), inf, _CMP_NLT_UQ);
+    }
+    return any | copy_scalar(out+i, a+i, m-i);
+}
+
+static const Kernels avx512_kernels = {
+    add_avx512, multiply_avx512, add_constant_avx512, multiply_constant_avx512, negate_avx512,
+    multiply_add_avx512, multiply_constant_add_avx512, nonfinite_avx512, copy_avx512
+};
+
+#endif
+
+/* The best kernels the CPU supports */
+static const Kernels * kernels ( void ) {
+#ifdef RPN_X86
+    if ( __builtin_cpu_supports("avx512f") ) {
+        return &avx512_kernels;
+    } else if ( __builtin_cpu_supports("avx2") ) {
+        return &avx2_kernels;
+    }
+#endif
+    return &scalar_kernels;
+}
+
+/* Combines the values at depths d and d+1 into depth d, where either may be
+   a constant */
+static void binary ( const Kernels * kernel, int op, double * scratch, const double ** slot,
+                     double * value, int d, int m ) {
+    const double * a = slot[d],
+                 * b = slot[d+1];
+    double * out = own(scratch, d);
+    if ( a == NULL && b == NULL ) {
+        /* Both constant: one scalar result, for every row */
+        value[d] = op == RPN_OP_ADD ? value[d] + value[d+1] : value[d] * value[d+1];
+        return;
+    } else if ( a == NULL || b == NULL ) {
+        /* Add and multiply commute, so the constant can go second */
+        const double * column = a != NULL ? a : b;
+        double c = a != NULL ? value[d+1] : value[d];
+        if ( op == RPN_OP_ADD ) {
+            kernel->add_constant(out, column, c, m);
+        } else {
+            kernel->multiply_constant(out, column, c, m);
+        }
+    } else if ( op == RPN_OP_ADD ) {
+        kernel->add(out, a, b, m);
+    } else {
+        kernel->multiply(out, a, b, m);
+    }
+    slot[d] = out;
+}
+
+/* Sets depth d to the product of the values at depths f and f+1 plus the
+   addend column, in one pass over the batch. Returns 0, having done nothing,
+   if the addend is a constant, which has no column. */
+static int multiply_add ( const Kernels * kernel, double * scratch, const double ** slot,
+                          double * value, int d, int f, const double * addend, int m ) {
+    const double * a = slot[f],
+                 * b = slot[f+1];
+    double * out = own(scratch, d);
+    if ( addend == NULL ) {
+        return 0;
+    } else if ( a == NULL && b == NULL ) {
+        kernel->add_constant(out, addend, value[f] * value[f+1], m);
+    } else if ( a == NULL || b == NULL ) {
+        kernel->multiply_constant_add(out, a != NULL ? a : b, a != NULL ? value[f+1] : value[f],
+                                      addend, m);
+    } else {
+        kernel->multiply_add(out, a, b, addend, m);
+    }
+    slot[d] = out;
+    return 1;
+}
+
+/* public functions **********************************************************/
+
+int rpn_run_batch(const RpnProgram * p, const double * const * columns, int n,
+                  double * out, unsigned char * overflow) {
+
+    /* Stack slot d holds the values at depth d: in its own part of scratch,
+       in the input column for a variable, or, where slot is NULL, the single
+       number in value[d] for a constant. inputs holds one row, for batches
+       that are run again a row at a time. */
+    double * scratch;
+    if ( posix_memalign((void **) &scratch, 64, (size_t) p->max_depth * ROWS * sizeof(double)) != 0 ) {
+        return -1;
+    }
+    const double ** slot = (const double **) malloc(p->max_depth * sizeof(double *));
+    double * value = (double *) malloc(p->max_depth * sizeof(double)),
+           * inputs = (double *) malloc(( p->num_variables > 0 ? p->num_variables : 1 ) * sizeof(double));
+    if ( slot == NULL || value == NULL || inputs == NULL ) {
+        free(inputs);
+        free(value);
+        free(slot);
+        free(scratch);
+        return -1;
+    }
+    int overflows = 0;
+    const Kernels * kernel = kernels();
+
+    for ( int start = 0; start < n; start += ROWS ) {
+
+        int m = n - start < ROWS ? n - start : ROWS,
+            d = 0;
+        const double * k = p->constants;
+        const int * v = p->variables;
+
+        for ( int i=0; i<p->num_ops; i++ ) {
+            switch ( p->ops[i] ) {
+                case RPN_OP_PUSH:
+                    slot[d] = NULL;
+                    value[d++] = *k++;
+                    break;
+                case RPN_OP_LOAD:
+                    slot[d++] = columns[*v++] + start;
+                    break;
+                case RPN_OP_MULTIPLY:
+                    /* Each pass over the batch reads and writes its columns, so
+                       a multiply is joined to the op after it where it can be:
+                       c a b * + is an ADD_PRODUCT and a b * x + a MULTIPLY_ADD
+                       that have not been through rpn_optimize. Negating a
+                       product is exact, so it can negate a constant factor. */
+                    if ( p->ops[i+1] == RPN_OP_ADD && d >= 3
+                         && multiply_add(kernel, scratch, slot, value, d-3, d-2, slot[d-3], m) ) {
+                        d -= 2;
+                        i++;
+                        break;
+                    } else if ( p->ops[i+1] == RPN_OP_LOAD && p->ops[i+2] == RPN_OP_ADD ) {
+                        multiply_add(kernel, scratch, slot, value, d-2, d-2, columns[*v++] + start, m);
+                        d--;
+                        i += 2;
+                        break;
+                    } else if ( p->ops[i+1] == RPN_OP_NEGATE
+                                && ( slot[d-2] == NULL || slot[d-1] == NULL ) ) {
+                        value[slot[d-1] == NULL ? d-1 : d-2] *= -1;
+                        i++;
+                    }
+                    d--;
+                    binary(kernel, RPN_OP_MULTIPLY, scratch, slot, value, d-1, m);
+                    break;
+                case RPN_OP_ADD:
+                    d--;
+                    binary(kernel, RPN_OP_ADD, scratch, slot, value, d-1, m);
+                    break;
+                case RPN_OP_MULTIPLY_ADD:
+                    /* a b c: the product goes where a was, then c just above it */
+                    d -= 2;
+                    if ( multiply_add(kernel, scratch, slot, value, d-1, d-1, slot[d+1], m) ) {
+                        break;
+                    }
+                    binary(kernel, RPN_OP_MULTIPLY, scratch, slot, value, d-1, m);
+                    slot[d] = slot[d+1];
+                    value[d] = value[d+1];
+                    binary(kernel, RPN_OP_ADD, scratch, slot, value, d-1, m);
+                    break;
+                case RPN_OP_ADD_PRODUCT:
+                    d -= 2;
+                    if ( multiply_add(kernel, scratch, slot, value, d-1, d, slot[d-1], m) ) {
+                        break;
+                    }
+                    binary(kernel, RPN_OP_MULTIPLY, scratch, slot, value, d, m);
+                    binary(kernel, RPN_OP_ADD, scratch, slot, value, d-1, m);
+                    break;
+                case RPN_OP_NEGATE:
+                    if ( slot[d-1] == NULL ) {
+                        value[d-1] = -value[d-1];
+                    } else {
+                        kernel->negate(own(scratch, d-1), slot[d-1], m);
+                        slot[d-1] = own(scratch, d-1);
+                    }
+                    break;
+            }
+        }
+
+        /* Every value the program computed is still in its slot, the top one and
+           any left below it. Overflow is rare, so the few batches where one of
+           them is not finite are run again a row at a time to find which rows
+           overflowed. The top is tested as it is copied out. */
+        int any;
+        if ( slot[d-1] != NULL ) {
+            any = kernel->copy(out + start, slot[d-1], m);
+        } else {
+            for ( int i=0; i<m; i++ ) {
+                out[start + i] = value[d-1];
+            }
+            any = !isfinite(value[d-1]);
+        }
+        for ( int j=0; j<d-1 && !any; j++ ) {
+            if ( slot[j] == NULL ) {
+                any = !isfinite(value[j]);
+            } else if ( slot[j] == own(scratch, j) ) {
+                any = kernel->nonfinite(slot[j], m);
+            }
+        }
+        if ( !any ) {
+            if ( overflow != NULL ) {
+                memset(overflow + start, 0, m);
+            }
+            continue;
+        }
+        for ( int i=0; i<m; i++ ) {
+            RPN_ERROR error;
+            for ( int j=0; j<p->num_variables; j++ ) {
+                inputs[j] = columns[j][start + i];
+            }
+            rpn_eval(p, inputs, &error);
+            overflows += error == OVERFLOW_ERROR;
+            if ( overflow != NULL ) {
+                overflow[start + i] = error == OVERFLOW_ERROR;
+            }
+        }
+
+    }
+
+    free(inputs);
+    free(value);
+    free(slot);
+    free(scratch);
+    return overflows;
+
+}
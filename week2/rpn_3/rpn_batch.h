@@ -0,0 +1,37 @@
+#ifndef RPN_BATCH_H
+#define RPN_BATCH_H
+
+#include "rpn_program.h"
+
+/*! @file
+ *  Evaluates one compiled formula over many rows of inputs. The inputs come as
+ *  columns: column i holds the value of xi for every row. Rows are processed
+ *  RPN_BATCH_ROWS at a time, and each stack slot holds one value per row of the
+ *  batch. Each operation is dispatched once per batch rather than once per row, and
+ *  runs as a loop over the batch, with AVX-512 or AVX2 instructions on CPUs that
+ *  have them. A variable needs no copy; its slot points into the input column. A
+ *  multiply and the add that takes its product run as one loop, as does a multiply
+ *  by a constant and the negation after it, giving the same bits as running them
+ *  one at a time.
+ *
+ *  The loops do not look for overflow. An infinity, once computed, leaves every
+ *  value that depends on it infinite or NaN, so each batch only tests the values
+ *  left on the stack at the end, the top one as it is copied out. The rare batch
+ *  with one that is not finite is run again a row at a time to find which rows
+ *  overflowed.
+ */
+
+#define RPN_BATCH_ROWS 512
+
+/*! Evaluates a program over n rows and returns the number of rows that overflowed,
+ *  or -1, having written nothing, if there is no memory for its working space.
+ *  \param program The program
+ *  \param columns num_variables columns of n values each
+ *  \param n The number of rows
+ *  \param out Receives the n results
+ *  \param overflow Receives, for each row, 1 if it overflowed and 0 otherwise, or NULL
+ */
+int rpn_run_batch(const RpnProgram * program, const double * const * columns, int n,
+                  double * out, unsigned char * overflow);
+
+#endif
@@ -0,0 +1,354 @@
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <assert.h>
+
+#include "rpn_program.h"
+
+/* Define RPN_NO_THREADING to use the switch even where computed goto works */
+#if defined(__GNUC__) && !defined(RPN_NO_THREADING)
+#define RPN_THREADED 1
+#else
+#define RPN_THREADED 0
+#endif
+
+/* Programs needing no more stack than this run on a local array */
+#define LOCAL_STACK_SIZE 64
+
+/* the virtual machine *******************************************************/
+
+/* Runs a program, or, given NULL, returns the address of each op's code so
+   the compiler can thread programs. The top of the stack is kept in tos and
+   the rest below sp; the first push saves a meaningless tos, so the stack
+   needs one slot more than the program's depth. */
+static const void * const * execute ( const RpnProgram * p, const double * inputs, double * result, RPN_ERROR * error ) {
+
+#if RPN_THREADED
+    static const void * const labels[RPN_NUM_OPS] = {
+        &&op_PUSH, &&op_LOAD, &&op_ADD, &&op_MULTIPLY, &&op_NEGATE,
+        &&op_MULTIPLY_ADD, &&op_ADD_PRODUCT, &&op_END
+    };
+    if ( p == NULL ) {
+        return labels;
+    }
+#define OP(name) op_##name
+#define DISPATCH() goto *(*ip++)
+    const void * const * ip = p->threaded;
+#else
+    if ( p == NULL ) {
+        return NULL;
+    }
+#define OP(name) case RPN_OP_##name
+#define DISPATCH() goto dispatch
+    const unsigned char * ip = p->ops;
+#endif
+
+    double local[LOCAL_STACK_SIZE],
+           * stack = p->max_depth < LOCAL_STACK_SIZE ? local
+                   : (double *) malloc((p->max_depth + 1) * sizeof(double)),
+           * sp = stack,
+           tos = 0,
+           product;
+    const double * k = p->constants;
+    const int * v = p->variables;
+    int overflow = 0;
+
+#if RPN_THREADED
+    DISPATCH();
+    {
+#else
+  dispatch:
+    switch ( *ip++ ) {
+#endif
+        OP(PUSH):
+            *sp++ = tos;
+            tos = *k++;
+            DISPATCH();
+        OP(LOAD):
+            *sp++ = tos;
+            tos = inputs[*v++];
+            DISPATCH();
+        OP(ADD):
+            tos = *--sp + tos;
+            overflow |= tos == INFINITY;
+            DISPATCH();
+        OP(MULTIPLY):
+            tos = *--sp * tos;
+            overflow |= tos == INFINITY || tos == -INFINITY;
+            DISPATCH();
+        OP(NEGATE):
+            tos = -tos;
+            DISPATCH();
+        OP(MULTIPLY_ADD):
+            sp -= 2;
+            product = sp[0] * sp[1];
+            tos = product + tos;
+            overflow |= product == INFINITY || product == -INFINITY || tos == INFINITY;
+            DISPATCH();
+        OP(ADD_PRODUCT):
+            sp -= 2;
+            product = sp[1] * tos;
+            tos = sp[0] + product;
+            overflow |= product == INFINITY || product == -INFINITY || tos == INFINITY;
+            DISPATCH();
+        OP(END):
+            goto done;
+    }
+  done:
+#undef OP
+#undef DISPATCH
+
+    if ( stack != local ) {
+        free(stack);
+    }
+    *result = tos;
+    *error = overflow ? OVERFLOW_ERROR : OK;
+    return NULL;
+
+}
+
+/* the compiler **************************************************************/
+
+/* The op a token names, or -1 if it is not an operator */
+static int operator_code ( const char * token, int length ) {
+    if ( length == 1 && token[0] == '+' ) {
+        return RPN_OP_ADD;
+    } else if ( length == 1 && token[0] == '*' ) {
+        return RPN_OP_MULTIPLY;
+    } else if ( ( length == 1 && token[0] == '~' ) || ( length == 3 && strncmp(token, "neg", 3) == 0 ) ) {
+        return RPN_OP_NEGATE;
+    } else {
+        return -1;
+    }
+}
+
+/* The index of a variable token xi, or -1 if the token is not one */
+static int variable_index ( const char * token, int length ) {
+    if ( length < 2 || token[0] != 'x' ) {
+        return -1;
+    }
+    int index = 0;
+    for ( int i=1; i<length; i++ ) {
+        if ( !isdigit((unsigned char) token[i]) || index > 100000 ) {
+            return -1;
+        }
+        index = 10 * index + ( token[i] - '0' );
+    }
+    return index;
+}
+
+static void emit ( RpnProgram * p, int * capacity, unsigned char op ) {
+    if ( p->num_ops == *capacity ) {
+        *capacity *= 2;
+        p->ops = (unsigned char *) realloc(p->ops, *capacity);
+    }
+    p->ops[p->num_ops++] = op;
+}
+
+/* Sets the address of each op's code, where computed goto is used */
+static void thread ( RpnProgram * p ) {
+    const void * const * labels = execute(NULL, NULL, NULL, NULL);
+    if ( labels != NULL ) {
+        p->threaded = (const void **) realloc(p->threaded, ( p->num_ops + 1 ) * sizeof(void *));
+        for ( int i=0; i<=p->num_ops; i++ ) {
+            p->threaded[i] = labels[p->ops[i]];
+        }
+    }
+}
+
+RpnProgram * rpn_compile(const char * source, RPN_ERROR * error) {
+
+    RpnProgram * p = (RpnProgram *) calloc(1, sizeof(RpnProgram));
+    int op_capacity = 16,
+        constant_capacity = 8,
+        load_capacity = 8,
+        depth = 0;
+    p->ops = (unsigned char *) malloc(op_capacity);
+    p->constants = (double *) malloc(constant_capacity * sizeof(double));
+    p->variables = (int *) malloc(load_capacity * sizeof(int));
+    *error = OK;
+
+    const char * s = source;
+    while ( *error == OK ) {
+        while ( isspace((unsigned char) *s) ) {
+            s++;
+        }
+        if ( *s == '\0' ) {
+            break;
+        }
+        const char * start = s;
+        while ( *s != '\0' && !isspace((unsigned char) *s) ) {
+            s++;
+        }
+        int op = operator_code(start, (int) ( s - start )),
+            variable = variable_index(start, (int) ( s - start ));
+        if ( variable >= 0 ) {
+            if ( p->num_loads == load_capacity ) {
+                load_capacity *= 2;
+                p->variables = (int *) realloc(p->variables, load_capacity * sizeof(int));
+            }
+            p->variables[p->num_loads++] = variable;
+            if ( variable >= p->num_variables ) {
+                p->num_variables = variable + 1;
+            }
+            op = RPN_OP_LOAD;
+            depth++;
+        } else if ( op == RPN_OP_NEGATE ) {
+            if ( depth < 1 ) {
+                *error = UNARY_ERROR;
+            }
+        } else if ( op >= 0 ) {
+            if ( depth < 2 ) {
+                *error = BINARY_ERROR;
+            }
+            depth--;
+        } else {
+            char * end;
+            double x = strtod(start, &end);
+            if ( end != s ) {
+                *error = SYNTAX_ERROR;
+            }
+            if ( p->num_constants == constant_capacity ) {
+                constant_capacity *= 2;
+                p->constants = (double *) realloc(p->constants, constant_capacity * sizeof(double));
+            }
+            p->constants[p->num_constants++] = x;
+            op = RPN_OP_PUSH;
+            depth++;
+        }
+        if ( depth > p->max_depth ) {
+            p->max_depth = depth;
+        }
+        emit(p, &op_capacity, (unsigned char) op);
+    }
+
+    if ( *error == OK && depth == 0 ) {
+        *error = POP_ERROR;
+    }
+    if ( *error != OK ) {
+        rpn_program_free(p);
+        return NULL;
+    }
+
+    emit(p, &op_capacity, RPN_OP_END);
+    p->num_ops--;
+    thread(p);
+
+    return p;
+
+}
+
+/* the optimizer *************************************************************/
+
+/* Whether running an add or a multiply that gives x reports an overflow */
+static int overflows ( int op, double x ) {
+    return op == RPN_OP_ADD ? x == INFINITY : x == INFINITY || x == -INFINITY;
+}
+
+/* The change in stack depth an op makes */
+static int stack_effect ( int op ) {
+    switch ( op ) {
+        case RPN_OP_PUSH:
+        case RPN_OP_LOAD:
+            return 1;
+        case RPN_OP_ADD:
+        case RPN_OP_MULTIPLY:
+            return -1;
+        case RPN_OP_MULTIPLY_ADD:
+        case RPN_OP_ADD_PRODUCT:
+            return -2;
+        default:
+            return 0;
+    }
+}
+
+/* public functions **********************************************************/
+
+double rpn_run(const RpnProgram * program, RPN_ERROR * error) {
+    assert(program->num_variables == 0);
+    double result;
+    execute(program, NULL, &result, error);
+    return result;
+}
+
+double rpn_eval(const RpnProgram * program, const double * inputs, RPN_ERROR * error) {
+    double result;
+    execute(program, inputs, &result, error);
+    return result;
+}
+
+int rpn_optimize(RpnProgram * p) {
+
+    /* One pass, copying each op down to the end of the output unless it
+       combines with the ops just before it there. The output never gets ahead
+       of the input, so ops and constants are rewritten in place; loads are
+       never removed or reordered, so the variables stay as they are. */
+    unsigned char * ops = p->ops;
+    double * k = p->constants;
+    int n = 0,          /* ops out */
+        num_k = 0,      /* constants out */
+        next_k = 0;     /* the next constant in */
+
+    for ( int i=0; i<p->num_ops; i++ ) {
+        int op = ops[i];
+        if ( op == RPN_OP_PUSH ) {
+            k[num_k++] = k[next_k++];
+        } else if ( op == RPN_OP_NEGATE && n > 0 && ops[n-1] == RPN_OP_PUSH ) {
+            k[num_k-1] = -k[num_k-1];
+            continue;
+        } else if ( op == RPN_OP_NEGATE && n > 0 && ops[n-1] == RPN_OP_NEGATE ) {
+            n--;
+            continue;
+        } else if ( op == RPN_OP_ADD || op == RPN_OP_MULTIPLY ) {
+            /* Two pushes in a row put their constants on top of the stack */
+            if ( n >= 2 && ops[n-1] == RPN_OP_PUSH && ops[n-2] == RPN_OP_PUSH ) {
+                double x = op == RPN_OP_ADD ? k[num_k-2] + k[num_k-1] : k[num_k-2] * k[num_k-1];
+                if ( !overflows(op, x) ) {
+                    k[num_k-2] = x;
+                    num_k--;
+                    n--;
+                    continue;
+                }
+            }
+            /* c a b * + */
+            if ( op == RPN_OP_ADD && n >= 1 && ops[n-1] == RPN_OP_MULTIPLY ) {
+                ops[n-1] = RPN_OP_ADD_PRODUCT;
+                continue;
+            }
+            /* a b * c +, with c pushed before the multiply instead */
+            if ( op == RPN_OP_ADD && n >= 2 && ops[n-2] == RPN_OP_MULTIPLY
+                 && ( ops[n-1] == RPN_OP_PUSH || ops[n-1] == RPN_OP_LOAD ) ) {
+                ops[n-2] = ops[n-1];
+                ops[n-1] = RPN_OP_MULTIPLY_ADD;
+                continue;
+            }
+        }
+        ops[n++] = (unsigned char) op;
+    }
+
+    ops[n] = RPN_OP_END;
+    p->num_ops = n;
+    p->num_constants = num_k;
+
+    int depth = 0;
+    p->max_depth = 0;
+    for ( int i=0; i<n; i++ ) {
+        depth += stack_effect(ops[i]);
+        if ( depth > p->max_depth ) {
+            p->max_depth = depth;
+        }
+    }
+    thread(p);
+
+    return p->max_depth;
+
+}
+
+void rpn_program_free(RpnProgram * program) {
+    free(program->ops);
+    free(program->constants);
+    free(program->variables);
+    free(program->threaded);
+    free(program);
+}
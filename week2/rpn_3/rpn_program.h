@@ -0,0 +1,87 @@
+#ifndef RPN_PROGRAM_H
+#define RPN_PROGRAM_H
+
+#include "rpn.h"
+
+/*! @file
+ *  Compiled RPN formulas. rpn_compile tokenizes a formula such as
+ *  "0.5 x0 1 + * neg" once, into a byte per operation and tables of the
+ *  constants and variables pushed. rpn_run and rpn_eval then evaluate it
+ *  without a call or an initialization check per operation.
+ *
+ *  The compiler tracks the stack depth of every operation. A formula that
+ *  would pop an empty stack is rejected there, so the virtual machine needs
+ *  no underflow checks and knows the largest stack it will use. The machine
+ *  keeps the top of the stack in a local, which the compiler can hold in a
+ *  register. With GCC or Clang it jumps straight from one operation's code
+ *  to the next through computed gotos (direct threading); elsewhere it uses
+ *  a switch.
+ *
+ *  rpn_optimize rewrites a compiled program into a shorter one with exactly the
+ *  same results, overflow included.
+ */
+
+/*! The operations, one byte each */
+typedef enum {
+    RPN_OP_PUSH,          /* push the next constant */
+    RPN_OP_LOAD,          /* push the input named by the next variable */
+    RPN_OP_ADD,
+    RPN_OP_MULTIPLY,
+    RPN_OP_NEGATE,
+    RPN_OP_MULTIPLY_ADD,  /* a b c: a * b + c, made by rpn_optimize */
+    RPN_OP_ADD_PRODUCT,   /* c a b: c + a * b, made by rpn_optimize */
+    RPN_OP_END,
+    RPN_NUM_OPS
+} RpnOpcode;
+
+typedef struct {
+    int num_ops;               /* not counting the final RPN_OP_END */
+    unsigned char * ops;
+    double * constants;        /* in the order the pushes use them */
+    int * variables;           /* the input each load reads, in the order of the loads */
+    int num_constants,
+        num_loads,
+        num_variables,         /* one more than the largest input index used */
+        max_depth;             /* the deepest the stack gets */
+    const void ** threaded;    /* the address of each op's code, or NULL without computed goto */
+} RpnProgram;
+
+/*! Compiles a formula of numbers, variables x0, x1, ..., and the operators +, * and
+ *  neg (or ~), separated by white space. Returns NULL and sets error if the formula is not valid: SYNTAX_ERROR
+ *  for an unknown token, UNARY_ERROR or BINARY_ERROR for an operator with too few
+ *  operands, and POP_ERROR if there is no value left to return.
+ *  \param source The formula
+ *  \param error Receives OK or the reason the formula was rejected
+ */
+RpnProgram * rpn_compile(const char * source, RPN_ERROR * error);
+
+/*! Evaluates a program without variables and returns the value on top of the stack.
+ *  Sets error to OVERFLOW_ERROR if an add or a multiply overflowed, as rpn_add and
+ *  rpn_multiply do, and to OK otherwise. Programs are not changed by running them,
+ *  so threads can share one.
+ *  \param program The program
+ *  \param error Receives OK or OVERFLOW_ERROR
+ */
+double rpn_run(const RpnProgram * program, RPN_ERROR * error);
+
+/*! Like rpn_run, with xi taking the value inputs[i].
+ *  \param program The program
+ *  \param inputs At least num_variables values
+ *  \param error Receives OK or OVERFLOW_ERROR
+ */
+double rpn_eval(const RpnProgram * program, const double * inputs, RPN_ERROR * error);
+
+/*! Optimizes a program in place and returns the stack depth it needs now, which is
+ *  also its new max_depth. Adds, multiplies and negations of constants are done
+ *  once, here, unless an add or a multiply would overflow, so that running the
+ *  program still reports it. Pairs of negations cancel, and a multiply whose
+ *  product is then added becomes one multiply-add op. That op rounds after the
+ *  multiply, as the two ops did, rather than being a fused multiply-add, so the
+ *  results are the same to the last bit. It can need one more stack slot.
+ *  \param program A program from rpn_compile
+ */
+int rpn_optimize(RpnProgram * program);
+
+void rpn_program_free(RpnProgram * program);
+
+#endif
@@ -1,5 +1,54 @@
+#include <math.h>
+#include <limits.h>
+#include <pthread.h>
 #include "gtest/gtest.h"
 #include "rpn.h"
+#include "rpn_program.h"
+#include "rpn_batch.h"
+
+/* Writes a random formula of about length tokens over x0, x1 and x2 into source,
+   with constants that make some rows overflow */
+static void random_formula ( char * source, int length, unsigned * seed ) {
+    static const char * constants[] = { "0", "1", "-1", "0.5", "3", "0.1", "1e200", "-1e200", "1.7e308" };
+    int depth = 0;
+    source[0] = '\0';
+    for ( int i=0; i<length || depth > 1; i++ ) {
+        *seed = *seed * 1103515245 + 12345;
+        int r = ( *seed >> 16 ) % 10;
+        if ( i >= length || ( depth >= 2 && r < 4 ) ) {
+            strcat(source, r % 2 ? "+ " : "* ");
+            depth--;
+        } else if ( depth >= 1 && r < 5 ) {
+            strcat(source, "neg ");
+        } else if ( r < 7 ) {
+            sprintf(source + strlen(source), "x%d ", r % 3);
+            depth++;
+        } else {
+            sprintf(source + strlen(source), "%s ", constants[( *seed >> 8 ) % 9]);
+            depth++;
+        }
+    }
+}
+
+/* Same bits, or both NaN, whose payloads may differ */
+static int same_double ( double a, double b ) {
+    return memcmp(&a, &b, sizeof(double)) == 0 || ( a != a && b != b );
+}
+
+/* Sums 1..n by pushing them all first, on a context of its own */
+static void * sum_on_own_context ( void * arg ) {
+    long n = (long) arg;
+    RpnContext * ctx = rpn_ctx_new();
+    for ( long i=1; i<=n; i++ ) {
+        rpn_ctx_push(ctx, i);
+    }
+    for ( long i=1; i<n; i++ ) {
+        rpn_ctx_add(ctx);
+    }
+    long sum = rpn_ctx_error(ctx) == OK ? (long) rpn_ctx_pop(ctx) : -1;
+    rpn_ctx_free(ctx);
+    return (void *) sum;
+}
 
 namespace {
 
@@ -75,6 +124,257 @@ namespace {
         ASSERT_EQ(rpn_error(), OVERFLOW_ERROR);
         rpn_free();        
 
-    }    
+    }
+
+    TEST(HW2,RPN_CONTEXTS) {
+
+        /* Contexts are independent of each other and of the global one */
+        RpnContext * a = rpn_ctx_new(),
+                   * b = rpn_ctx_new();
+        rpn_ctx_push(a, 2);
+        rpn_ctx_push(a, 3);
+        rpn_ctx_multiply(b);
+        ASSERT_EQ(rpn_ctx_error(b), BINARY_ERROR);
+        ASSERT_EQ(rpn_ctx_error(a), OK);
+        ASSERT_EQ(rpn_error(), OK);
+        rpn_ctx_multiply(a);
+        rpn_ctx_negate(a);
+        ASSERT_EQ(rpn_ctx_pop(a), -6);
+        rpn_ctx_pop(a);
+        ASSERT_EQ(rpn_ctx_error(a), POP_ERROR);
+        rpn_ctx_reset(a);
+        ASSERT_EQ(rpn_ctx_error(a), OK);
+        rpn_ctx_free(a);
+        rpn_ctx_free(b);
+
+        /* The stack grows past its initial size */
+        rpn_init();
+        for ( int i=0; i<1000; i++ ) {
+            rpn_push(i);
+        }
+        for ( int i=999; i>=0; i-- ) {
+            ASSERT_EQ(rpn_pop(), i);
+        }
+        ASSERT_EQ(rpn_error(), OK);
+        rpn_free();
+
+        /* A stack that cannot grow keeps its contents and reports the error */
+        a = rpn_ctx_new();
+        rpn_ctx_push(a, 1);
+        int capacity = a->capacity;
+        a->top = a->capacity = INT_MAX / 2 + 1;
+        rpn_ctx_push(a, 2);
+        ASSERT_EQ(rpn_ctx_error(a), MEMORY_ERROR);
+        ASSERT_EQ(a->top, INT_MAX / 2 + 1);
+        a->top = 1;
+        a->capacity = capacity;
+        ASSERT_EQ(rpn_ctx_pop(a), 1);
+        rpn_ctx_free(a);
+
+        /* Threads evaluating at once */
+        pthread_t threads[8];
+        for ( long t=0; t<8; t++ ) {
+            pthread_create(&threads[t], NULL, sum_on_own_context, (void *) (1000 + t));
+        }
+        for ( long t=0; t<8; t++ ) {
+            void * sum;
+            pthread_join(threads[t], &sum);
+            ASSERT_EQ((long) sum, (1000 + t) * (1001 + t) / 2);
+        }
+
+    }
+
+    TEST(HW2,RPN_PROGRAMS) {
+
+        RPN_ERROR error;
+        RpnProgram * p = rpn_compile("0.5 2.0 1.0 + * neg", &error);
+        ASSERT_EQ(error, OK);
+        ASSERT_EQ(p->num_ops, 6);
+        ASSERT_EQ(p->max_depth, 3);
+        ASSERT_EQ(rpn_run(p, &error), -1.5);
+        ASSERT_EQ(error, OK);
+        rpn_program_free(p);
+
+        /* Deep stacks, past the machine's local array */
+        char source[2000] = "";
+        for ( int i=1; i<=100; i++ ) {
+            sprintf(source + strlen(source), "%d ", i);
+        }
+        for ( int i=1; i<100; i++ ) {
+            strcat(source, i % 2 ? "+ " : "~ + ");
+        }
+        p = rpn_compile(source, &error);
+        ASSERT_EQ(p->max_depth, 100);
+        RpnContext * ctx = rpn_ctx_new();
+        for ( int i=1; i<=100; i++ ) {
+            rpn_ctx_push(ctx, i);
+        }
+        for ( int i=1; i<100; i++ ) {
+            if ( i % 2 == 0 ) {
+                rpn_ctx_negate(ctx);
+            }
+            rpn_ctx_add(ctx);
+        }
+        ASSERT_EQ(rpn_run(p, &error), rpn_ctx_pop(ctx));
+        rpn_ctx_free(ctx);
+        rpn_program_free(p);
+
+        /* Errors are found when compiling, except overflow */
+        ASSERT_EQ(rpn_compile("1 +", &error), (RpnProgram *) NULL);
+        ASSERT_EQ(error, BINARY_ERROR);
+        ASSERT_EQ(rpn_compile("neg", &error), (RpnProgram *) NULL);
+        ASSERT_EQ(error, UNARY_ERROR);
+        ASSERT_EQ(rpn_compile("  ", &error), (RpnProgram *) NULL);
+        ASSERT_EQ(error, POP_ERROR);
+        ASSERT_EQ(rpn_compile("1 2 -", &error), (RpnProgram *) NULL);
+        ASSERT_EQ(error, SYNTAX_ERROR);
+        ASSERT_EQ(rpn_compile("1 2x +", &error), (RpnProgram *) NULL);
+        ASSERT_EQ(error, SYNTAX_ERROR);
+        p = rpn_compile("1.7e308 1.7e308 ~ *", &error);
+        rpn_run(p, &error);
+        ASSERT_EQ(error, OVERFLOW_ERROR);
+        rpn_program_free(p);
+
+    }
+
+    TEST(HW2,RPN_BATCH) {
+
+        RPN_ERROR error;
+        RpnProgram * p = rpn_compile("x0 1 + x1 2 + * neg x0 ~ x0 * +", &error);
+        ASSERT_EQ(p->num_variables, 2);
+        ASSERT_EQ(p->num_loads, 4);
+        double inputs[2] = { 3, 4 };
+        ASSERT_EQ(rpn_eval(p, inputs, &error), -24 - 9);
+
+        /* Rows past a whole number of batches, some of them overflowing */
+        int n = 2 * RPN_BATCH_ROWS + 7;
+        double * x0 = (double *) malloc(n * sizeof(double)),
+               * x1 = (double *) malloc(n * sizeof(double)),
+               * out = (double *) malloc(n * sizeof(double));
+        unsigned char * overflow = (unsigned char *) malloc(n);
+        int expected = 0;
+        for ( int i=0; i<n; i++ ) {
+            x0[i] = i * 0.25 - 100;
+            x1[i] = i % 97 == 0 ? DBL_MAX : -i;
+            expected += i % 97 == 0;
+        }
+        const double * columns[2] = { x0, x1 };
+        ASSERT_EQ(rpn_run_batch(p, columns, n, out, overflow), expected);
+        for ( int i=0; i<n; i++ ) {
+            double row[2] = { x0[i], x1[i] };
+            ASSERT_EQ(out[i], rpn_eval(p, row, &error));
+            ASSERT_EQ(overflow[i], error == OVERFLOW_ERROR);
+        }
+        rpn_program_free(p);
+
+        /* A constant formula, and no rows at all */
+        p = rpn_compile("1.7e308 10 *", &error);
+        ASSERT_EQ(rpn_run_batch(p, NULL, 5, out, NULL), 5);
+        ASSERT_EQ(out[4], INFINITY);
+        ASSERT_EQ(rpn_run_batch(p, NULL, 0, out, NULL), 0);
+        rpn_program_free(p);
+
+        free(x0);
+        free(x1);
+        free(out);
+        free(overflow);
+
+    }
+
+    TEST(HW2,RPN_OPTIMIZE) {
+
+        /* Folds, a cancelled pair of negations, and a multiply-add */
+        RPN_ERROR error;
+        RpnProgram * p = rpn_compile("2 3 + x0 * neg neg 4 1 neg * +", &error);
+        ASSERT_EQ(rpn_optimize(p), 3);
+        ASSERT_EQ(p->num_ops, 4);
+        ASSERT_EQ(p->num_constants, 2);
+        ASSERT_EQ(p->ops[3], RPN_OP_MULTIPLY_ADD);
+        double x0 = 2;
+        ASSERT_EQ(rpn_eval(p, &x0, &error), 6);
+        ASSERT_EQ(error, OK);
+        rpn_program_free(p);
+
+        p = rpn_compile("x0 x1 x2 * +", &error);
+        rpn_optimize(p);
+        ASSERT_EQ(p->num_ops, 4);
+        ASSERT_EQ(p->ops[3], RPN_OP_ADD_PRODUCT);
+        rpn_program_free(p);
+
+        /* A constant overflow is left for the run to report */
+        p = rpn_compile("1.7e308 10 * 0 *", &error);
+        rpn_optimize(p);
+        ASSERT_EQ(p->num_ops, 5);
+        rpn_run(p, &error);
+        ASSERT_EQ(error, OVERFLOW_ERROR);
+        rpn_program_free(p);
+
+        /* Adds only overflow to +INF, so this one folds */
+        p = rpn_compile("-1e308 -1e308 +", &error);
+        rpn_optimize(p);
+        ASSERT_EQ(p->num_ops, 1);
+        ASSERT_EQ(rpn_run(p, &error), -INFINITY);
+        ASSERT_EQ(error, OK);
+        rpn_program_free(p);
+
+    }
+
+    TEST(HW2,RPN_OPTIMIZE_SAME_RESULTS) {
+
+        /* Random formulas give the same bits and the same overflows optimized as
+           not, evaluated a row at a time and in batches, and in batches as a row
+           at a time */
+        unsigned seed = 7;
+        char source[4000];
+        int n = RPN_BATCH_ROWS + 3;
+        double * columns[3],
+               * out = (double *) malloc(n * sizeof(double)),
+               * optimized_out = (double *) malloc(n * sizeof(double));
+        unsigned char * overflow = (unsigned char *) malloc(n),
+                      * optimized_overflow = (unsigned char *) malloc(n);
+        for ( int j=0; j<3; j++ ) {
+            columns[j] = (double *) malloc(n * sizeof(double));
+            for ( int i=0; i<n; i++ ) {
+                columns[j][i] = i % 50 == j ? INFINITY : i % 50 == j + 3 ? -DBL_MAX : ( i - 200 ) * 0.37 + j;
+            }
+        }
+
+        for ( int f=0; f<300; f++ ) {
+            RPN_ERROR error, optimized_error;
+            random_formula(source, 1 + f % 60, &seed);
+            RpnProgram * p = rpn_compile(source, &error),
+                       * q = rpn_compile(source, &error);
+            ASSERT_EQ(error, OK);
+            rpn_optimize(q);
+            ASSERT_LE(q->num_ops, p->num_ops);
+            for ( int i=0; i<n; i++ ) {
+                double row[3] = { columns[0][i], columns[1][i], columns[2][i] };
+                double x = rpn_eval(p, row, &error),
+                       y = rpn_eval(q, row, &optimized_error);
+                ASSERT_TRUE(same_double(x, y)) << source;
+                ASSERT_EQ(error, optimized_error) << source;
+            }
+            ASSERT_EQ(rpn_run_batch(p, columns, n, out, overflow),
+                      rpn_run_batch(q, columns, n, optimized_out, optimized_overflow)) << source;
+            for ( int i=0; i<n; i++ ) {
+                double row[3] = { columns[0][i], columns[1][i], columns[2][i] };
+                ASSERT_TRUE(same_double(out[i], rpn_eval(p, row, &error))) << source;
+                ASSERT_EQ(overflow[i], error == OVERFLOW_ERROR) << source;
+                ASSERT_TRUE(same_double(out[i], optimized_out[i])) << source;
+                ASSERT_EQ(overflow[i], optimized_overflow[i]) << source;
+            }
+            rpn_program_free(p);
+            rpn_program_free(q);
+        }
+
+        for ( int j=0; j<3; j++ ) {
+            free(columns[j]);
+        }
+        free(out);
+        free(optimized_out);
+        free(overflow);
+        free(optimized_overflow);
+
+    }
 
 }
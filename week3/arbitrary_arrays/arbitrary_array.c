@@ -13,40 +13,53 @@ static int index_to_offset ( const ArbitraryArray * da, int index ) {
     return da->element_size * index + da->origin;
 }
 
-/* Position of the element at buffer position 'offset' */
-static int offset_to_index ( const ArbitraryArray * da, int offset ) {
-    return ( offset - da->origin ) / da->element_size;
-}
-
 /* Non-zero if and only if offset lies ouside the buffer */
 static int out_of_buffer ( ArbitraryArray * da, int offset ) {
     return offset < 0 || offset >= da->capacity * da->element_size;
 }
 
-/* Makes a new buffer that is twice the size of the old buffer,
-   copies the old information into the new buffer, and deletes
-   the old buffer */
-static void extend_buffer ( ArbitraryArray * da ) {
-
-    char * temp = (char *) calloc ( 2 * da->capacity, da->element_size );
-    // int new_origin = da->element_size * ( da->capacity - (da->end - da->origin)/2 ),
-    //        new_end = new_origin + da->element_size * (da->end - da->origin);
-
-    int new_origin = da->element_size * (da->capacity - (offset_to_index(da,da->end) - offset_to_index(da,da->origin))/2);
-    int new_end = new_origin + (da->end - da->origin);           
-
-    for ( int i=0; i<ArbitraryArray_size(da); i++ ) {
-        memcpy(temp + new_origin + i * da->element_size,
-               da->buffer + da->origin + i * da->element_size,
-               da->element_size);
+/* Copies one element. The common sizes get fixed-size copies, which the
+   compiler turns into a few moves instead of a call to memcpy. */
+static inline void copy_element ( char * dst, const char * src, int element_size ) {
+    switch ( element_size ) {
+        case 4:  memcpy(dst, src, 4);  break;
+        case 8:  memcpy(dst, src, 8);  break;
+        case 16: memcpy(dst, src, 16); break;
+        case 32: memcpy(dst, src, 32); break;
+        default: memcpy(dst, src, element_size);
     }
+}
 
-    free(da->buffer);
+/* Makes a new buffer, doubling the capacity as many times as needed for the
+   element at position index to fit with the elements centered as before,
+   copies the old information into the new buffer with one memcpy, and
+   deletes the old buffer */
+static void extend_buffer ( ArbitraryArray * da, int index ) {
+
+    int size = ArbitraryArray_size(da),
+        capacity = da->capacity,
+        new_origin;
+
+    do {
+        capacity = 2 * capacity;
+        new_origin = capacity / 2 - size / 2;
+    } while ( new_origin + index >= capacity );
+
+    char * temp = da->arena != NULL
+                ? (char *) arena_calloc ( da->arena, (size_t) capacity * da->element_size )
+                : (char *) calloc ( capacity, da->element_size );
+    memcpy(temp + new_origin * da->element_size,
+           da->buffer + da->origin,
+           da->end - da->origin);
+
+    if ( da->arena == NULL ) {
+        free(da->buffer);
+    }
     da->buffer = temp;
 
-    da->capacity = 2 * da->capacity;
-    da->origin = new_origin;
-    da->end = new_end;
+    da->capacity = capacity;
+    da->origin = new_origin * da->element_size;
+    da->end = da->origin + size * da->element_size;
 
     return;
 
@@ -64,11 +77,39 @@ ArbitraryArray * ArbitraryArray_new(int element_size) {
     ); 
     da->origin = ( da->capacity / 2 ) * da->element_size;
     da->end = da->origin;
+    da->arena = NULL;
+    return da;
+}
+
+ArbitraryArray * ArbitraryArray_new_in(Arena * arena, int element_size) {
+    assert(arena != NULL);
+    ArbitraryArray * da = (ArbitraryArray *) arena_alloc(arena, sizeof(ArbitraryArray));
+    da->element_size = element_size;
+    da->capacity = ARBITRARY_ARRAY_INITIAL_CAPACITY;
+    da->buffer = (char *) arena_calloc ( arena, (size_t) da->capacity * element_size );
+    da->origin = ( da->capacity / 2 ) * da->element_size;
+    da->end = da->origin;
+    da->arena = arena;
+    return da;
+}
+
+ArbitraryArray * ArbitraryArray_new_zeros(int element_size, int n) {
+    ArbitraryArray * da = (ArbitraryArray *) malloc(sizeof(ArbitraryArray));
+    da->element_size = element_size;
+    da->capacity = n > 0 ? n : 1;
+    da->buffer = (char *) calloc ( da->capacity, element_size );
+    da->origin = 0;
+    da->end = n * element_size;
+    da->arena = NULL;
     return da;
 }
 
 void ArbitraryArray_destroy(ArbitraryArray * da) {
-    free(da->buffer);
+    if ( da->arena != NULL ) {
+        arena_free(da->arena, da->buffer);
+    } else {
+        free(da->buffer);
+    }
     da->buffer = NULL;
     return;
 }
@@ -93,15 +134,48 @@ void ArbitraryArray_set_from_ptr(ArbitraryArray * da, int index, void * ptr) {
     assert(da->buffer != NULL);
     assert ( index >= 0 );
 
-    while ( out_of_buffer(da, index_to_offset(da, index) ) ) {
-        extend_buffer(da);
+    if ( out_of_buffer(da, index_to_offset(da, index) ) ) {
+        extend_buffer(da, index);
     }
 
-    memcpy(da->buffer + index_to_offset(da, index), ptr, da->element_size);
-    if ( index >= ArbitraryArray_size(da) ) {
-        da->end = index_to_offset(da,index+1);
+    /* Comparing offsets rather than indices avoids dividing by the element size */
+    int offset = index_to_offset(da, index);
+    copy_element(da->buffer + offset, (const char *) ptr, da->element_size);
+    if ( offset >= da->end ) {
+        da->end = offset + da->element_size;
+    }
+
+}
+
+void ArbitraryArray_set_range(ArbitraryArray * da, int index, const void * ptr, int count) {
+
+    assert(da->buffer != NULL);
+    assert ( index >= 0 && count >= 0 );
+
+    if ( count == 0 ) {
+        return;
     }
 
+    if ( out_of_buffer(da, index_to_offset(da, index + count - 1) ) ) {
+        extend_buffer(da, index + count - 1);
+    }
+
+    memcpy(da->buffer + index_to_offset(da, index), ptr, count * da->element_size);
+    if ( index + count > ArbitraryArray_size(da) ) {
+        da->end = index_to_offset(da, index + count);
+    }
+
+}
+
+void ArbitraryArray_get_range(const ArbitraryArray * da, int index, void * ptr, int count) {
+    assert(da->buffer != NULL);
+    assert ( index >= 0 && count >= 0 );
+    assert ( index + count <= ArbitraryArray_size(da) );
+    memcpy(ptr, da->buffer + index_to_offset(da, index), count * da->element_size);
+}
+
+void ArbitraryArray_push_many(ArbitraryArray * da, const void * ptr, int count) {
+    ArbitraryArray_set_range(da, ArbitraryArray_size(da), ptr, count);
 }
 
 void ArbitraryArray_print_debug_info(const ArbitraryArray * da) {
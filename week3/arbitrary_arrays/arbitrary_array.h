@@ -1,6 +1,8 @@
 #ifndef _ARBITRARY_ARRAY
 #define _ARBITRARY_ARRAY
 
+#include "arena.h"
+
 #define ARBITRARY_ARRAY_INITIAL_CAPACITY 10
 
 typedef struct {
@@ -9,11 +11,29 @@ typedef struct {
         end,
         element_size;
     char * buffer;
+    Arena * arena;  /* holds the header and buffer, NULL if they come from the heap */
 } ArbitraryArray;
 
 /* Constructors / Destructors ************************************************/
 
 ArbitraryArray * ArbitraryArray_new(int);
+
+/*! Makes an array of n zeroed elements, in a buffer of exactly that size, for
+ *  structures that index into a table of fixed size.
+ *  \param element_size The size of an element in bytes
+ *  \param n The number of elements
+ */
+ArbitraryArray * ArbitraryArray_new_zeros(int element_size, int n);
+
+/*! Makes an array whose header and buffers come from an arena instead of the heap.
+ *  Growing it takes a new buffer from the arena, and arena_reset releases the array
+ *  with everything else in the arena, so neither destroy nor free is needed. The
+ *  header must not be passed to free.
+ *  \param arena The arena
+ *  \param element_size The size of an element in bytes
+ */
+ArbitraryArray * ArbitraryArray_new_in(Arena * arena, int element_size);
+
 void ArbitraryArray_destroy(ArbitraryArray *);
 
 /* Getters / Setters *********************************************************/
@@ -22,12 +42,37 @@ void ArbitraryArray_set_from_ptr(ArbitraryArray *, int, void *);
 void * ArbitraryArray_get_ptr(const ArbitraryArray *, int);
 int ArbitraryArray_size(const ArbitraryArray *);
 
+/*! Copies count elements from ptr into the array, starting at index. The array is
+ *  extended if needed, with any gap before index filled with zeros, and the buffer
+ *  grows at most once.
+ *  \param da The array
+ *  \param index The position of the first element to set
+ *  \param ptr The elements, count * element_size bytes
+ *  \param count The number of elements
+ */
+void ArbitraryArray_set_range(ArbitraryArray * da, int index, const void * ptr, int count);
+
+/*! Copies count elements, starting at index, into ptr. The elements must all be in the array.
+ *  \param da The array
+ *  \param index The position of the first element to get
+ *  \param ptr Receives the elements, count * element_size bytes
+ *  \param count The number of elements
+ */
+void ArbitraryArray_get_range(const ArbitraryArray * da, int index, void * ptr, int count);
+
 /* Printing ******************************************************************/
 
 void ArbitraryArray_print_debug_info(const ArbitraryArray *);
 
 /* Operations ****************************************************************/
 
+/*! Appends count elements from ptr to the end of the array.
+ *  \param da The array
+ *  \param ptr The elements, count * element_size bytes
+ *  \param count The number of elements
+ */
+void ArbitraryArray_push_many(ArbitraryArray * da, const void * ptr, int count);
+
 /* EXERCISES */
 
 /*! Returns a string representation of the array, using a supplied to_string method for the element type.
@@ -0,0 +1,159 @@
+#ifndef _ARENA
+#define _ARENA
+
+/*! @file
+ *  A bump allocator for arrays that live and die together, such as the arrays
+ *  made while handling one request. An allocation just moves a pointer along
+ *  the current chunk, freeing is a no-op, and arena_reset gives all of it back
+ *  at once in constant time, however many arrays were made. Chunks are kept
+ *  across resets, so a reused arena stops calling malloc once it has reached
+ *  its working size.
+ *
+ *  The most recent allocation can grow in place while its chunk has room,
+ *  which is how a buffer pushed to repeatedly avoids copies. It can also be
+ *  given back.
+ *
+ *  DynamicArray and ArbitraryArray in week 3 can take their memory from an
+ *  arena. Each project keeps a copy of this header.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_DEFAULT_CHUNK_SIZE ((size_t) 64 << 10)
+/* A cache line, as for buffers from array_memory.h, so the aligned loads of the
+   SIMD kernels also work on arrays in an arena */
+#define ARENA_ALIGNMENT 64
+
+typedef struct ArenaChunk {
+    struct ArenaChunk * next;
+    size_t size,              /* usable bytes */
+           used;
+} ArenaChunk;
+
+typedef struct {
+    ArenaChunk * first,
+               * current;
+    size_t chunk_size;
+    char * last;              /* the most recent allocation, or NULL */
+} Arena;
+
+/* The usable bytes of a chunk follow its header, aligned */
+#define ARENA_CHUNK_HEADER ( ( sizeof(ArenaChunk) + ARENA_ALIGNMENT - 1 ) & ~( (size_t) ARENA_ALIGNMENT - 1 ) )
+
+static inline char * arena_chunk_data ( ArenaChunk * c ) {
+    return (char *) c + ARENA_CHUNK_HEADER;
+}
+
+static inline size_t arena_round ( size_t bytes ) {
+    return ( bytes + ARENA_ALIGNMENT - 1 ) & ~( (size_t) ARENA_ALIGNMENT - 1 );
+}
+
+static inline ArenaChunk * arena_new_chunk ( size_t size ) {
+    void * p = NULL;
+    if ( posix_memalign(&p, ARENA_ALIGNMENT, ARENA_CHUNK_HEADER + size) != 0 ) {
+        abort();
+    }
+    ArenaChunk * c = (ArenaChunk *) p;
+    c->next = NULL;
+    c->size = size;
+    c->used = 0;
+    return c;
+}
+
+/*! Makes an empty arena.
+ *  \param chunk_size The size of the blocks it takes from malloc, or 0 for the default.
+ *  Larger allocations get a block of their own.
+ */
+static inline Arena * arena_new ( size_t chunk_size ) {
+    Arena * a = (Arena *) malloc(sizeof(Arena));
+    a->chunk_size = chunk_size > 0 ? arena_round(chunk_size) : ARENA_DEFAULT_CHUNK_SIZE;
+    a->first = a->current = arena_new_chunk(a->chunk_size);
+    a->last = NULL;
+    return a;
+}
+
+/*! Frees the arena and everything allocated from it.
+ */
+static inline void arena_destroy ( Arena * a ) {
+    ArenaChunk * c = a->first;
+    while ( c != NULL ) {
+        ArenaChunk * next = c->next;
+        free(c);
+        c = next;
+    }
+    free(a);
+}
+
+/*! Frees everything allocated from the arena, in constant time. The chunks are kept for
+ *  reuse.
+ */
+static inline void arena_reset ( Arena * a ) {
+    a->current = a->first;
+    a->first->used = 0;
+    a->last = NULL;
+}
+
+/*! Returns bytes of uninitialized memory, aligned to ARENA_ALIGNMENT.
+ */
+static inline void * arena_alloc ( Arena * a, size_t bytes ) {
+    size_t size = arena_round(bytes > 0 ? bytes : 1);
+    ArenaChunk * c = a->current;
+    if ( c->used + size > c->size ) {
+        /* Move on to the next chunk, which was emptied by a reset, or put a
+           new one, big enough, in front of it */
+        if ( c->next == NULL || c->next->size < size ) {
+            ArenaChunk * fresh = arena_new_chunk(size > a->chunk_size ? size : a->chunk_size);
+            fresh->next = c->next;
+            c->next = fresh;
+        }
+        c = a->current = c->next;
+        c->used = 0;
+    }
+    a->last = arena_chunk_data(c) + c->used;
+    c->used += size;
+    return a->last;
+}
+
+/*! Returns bytes of zeroed memory, aligned to ARENA_ALIGNMENT.
+ */
+static inline void * arena_calloc ( Arena * a, size_t bytes ) {
+    void * p = arena_alloc(a, bytes);
+    memset(p, 0, bytes);
+    return p;
+}
+
+/*! Resizes an allocation, keeping the first min(old_bytes, new_bytes) bytes. The most
+ *  recent allocation is resized in place if its chunk has room; any other is copied
+ *  to a new allocation. The bytes past old_bytes are not initialized.
+ *  \param a The arena
+ *  \param p The allocation
+ *  \param old_bytes Its current size
+ *  \param new_bytes The new size
+ */
+static inline void * arena_realloc ( Arena * a, void * p, size_t old_bytes, size_t new_bytes ) {
+    ArenaChunk * c = a->current;
+    if ( p == a->last ) {
+        size_t start = (char *) p - arena_chunk_data(c),
+               size = arena_round(new_bytes > 0 ? new_bytes : 1);
+        if ( start + size <= c->size ) {
+            c->used = start + size;
+            return p;
+        }
+    }
+    void * q = arena_alloc(a, new_bytes);
+    memcpy(q, p, old_bytes < new_bytes ? old_bytes : new_bytes);
+    return q;
+}
+
+/*! Gives back an allocation. Only the most recent one is actually reclaimed, the rest
+ *  waits for arena_reset.
+ */
+static inline void arena_free ( Arena * a, void * p ) {
+    if ( p != NULL && p == a->last ) {
+        a->current->used = (char *) p - arena_chunk_data(a->current);
+        a->last = NULL;
+    }
+}
+
+#endif
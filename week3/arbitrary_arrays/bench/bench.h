@@ -0,0 +1,16 @@
+#ifndef _DYNAMIC_ARRAY_BENCH
+#define _DYNAMIC_ARRAY_BENCH
+
+#include <time.h>
+
+/* Monotonic wall clock time in seconds */
+static inline double bench_now ( void ) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+/* Keeps the optimizer from discarding a computed value */
+static volatile double bench_sink;
+
+#endif
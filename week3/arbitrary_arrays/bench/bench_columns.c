@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "arbitrary_array.h"
+#include "column_array.h"
+#include "bench.h"
+
+/* Summing one field of n Points {x,y,z}, stored as records in an
+ * ArbitraryArray and as columns in a ColumnArray, plus the cost of
+ * gathering whole records back out of the columns.
+ * Usage: bench_columns [n] [repetitions]
+ */
+
+typedef struct {
+    double x, y, z;
+} Point;
+
+int main ( int argc, char ** argv ) {
+
+    int n = argc > 1 ? atoi(argv[1]) : 10000000,
+        reps = argc > 2 ? atoi(argv[2]) : 10;
+
+    RecordField fields[] = { RECORD_FIELD(Point, x), RECORD_FIELD(Point, y), RECORD_FIELD(Point, z) };
+    ArbitraryArray * records = ArbitraryArray_new(sizeof(Point));
+    ColumnArray * columns = ColumnArray_new(sizeof(Point), fields, 3);
+    for ( int i=0; i<n; i++ ) {
+        Point p = { (double) i, 2.0 * i, 3.0 * i };
+        ArbitraryArray_set_from_ptr(records, i, &p);
+        ColumnArray_push(columns, &p);
+    }
+
+    double sum = 0, t = bench_now();
+    for ( int r=0; r<reps; r++ ) {
+        const Point * p = (const Point *) ArbitraryArray_get_ptr(records, 0);
+        for ( int i=0; i<n; i++ ) {
+            sum += p[i].x;
+        }
+    }
+    double aos = ( bench_now() - t ) / reps;
+
+    t = bench_now();
+    for ( int r=0; r<reps; r++ ) {
+        const double * x = (const double *) ColumnArray_column(columns, 0);
+        for ( int i=0; i<n; i++ ) {
+            sum += x[i];
+        }
+    }
+    double soa = ( bench_now() - t ) / reps;
+
+    t = bench_now();
+    for ( int i=0; i<n; i++ ) {
+        Point p;
+        ColumnArray_get(columns, i, &p);
+        sum += p.y;
+    }
+    double gather = bench_now() - t;
+    bench_sink = sum;
+
+    printf("sum of x, records  %8.2f ms  %6.2f GB/s touched\n", 1e3 * aos, 1e-9 * n * sizeof(Point) / aos);
+    printf("sum of x, column   %8.2f ms  %6.2f GB/s touched\n", 1e3 * soa, 1e-9 * n * sizeof(double) / soa);
+    printf("gather records     %8.2f ns per record\n", 1e9 * gather / n);
+
+    ColumnArray_destroy(columns);
+    ArbitraryArray_destroy(records);
+    free(records);
+    return 0;
+
+}
@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "hash_map.h"
+#include "bench.h"
+
+/* Insertion into a HashMap of 64-bit keys and values, with the longest single
+ * put, which stays short because growth is spread over later puts, and random
+ * lookups one at a time and in batches.
+ * Usage: bench_hash_map [num_keys]
+ */
+
+static void report ( const char * name, double seconds, int n ) {
+    printf("%-22s %8.2f ms  %8.2f Mop/s\n", name, 1e3 * seconds, 1e-6 * n / seconds);
+}
+
+int main ( int argc, char ** argv ) {
+
+    int n = argc > 1 ? atoi(argv[1]) : 10000000;
+    HashMap * map = HashMap_new(sizeof(int64_t), sizeof(int64_t), NULL, NULL);
+
+    double longest = 0, t = bench_now();
+    for ( int64_t i=0; i<n; i++ ) {
+        double s = bench_now();
+        int64_t key = i * 2654435761LL, value = i;
+        HashMap_put(map, &key, &value);
+        s = bench_now() - s;
+        if ( s > longest ) longest = s;
+    }
+    report("put", bench_now() - t, n);
+    printf("%-22s %8.3f ms\n", "longest put", 1e3 * longest);
+
+    int64_t * keys = (int64_t *) malloc(n * sizeof(int64_t));
+    void ** values = (void **) malloc(n * sizeof(void *));
+    srand(42);
+    for ( int i=0; i<n; i++ ) {
+        keys[i] = (int64_t) ( ( (unsigned) rand() * 2654435761u ) % n ) * 2654435761LL;
+    }
+
+    t = bench_now();
+    int64_t sum = 0;
+    for ( int i=0; i<n; i++ ) {
+        int64_t * value = (int64_t *) HashMap_get(map, keys + i);
+        if ( value != NULL ) sum += *value;
+    }
+    report("get", bench_now() - t, n);
+
+    t = bench_now();
+    HashMap_get_many(map, keys, n, values);
+    for ( int i=0; i<n; i++ ) {
+        if ( values[i] != NULL ) sum -= *(int64_t *) values[i];
+    }
+    report("get_many", bench_now() - t, n);
+    bench_sink = (double) sum;
+
+    free(keys);
+    free(values);
+    HashMap_destroy(map);
+    return 0;
+
+}
@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "heap.h"
+#include "bench.h"
+
+/* A binary heap against 4-ary and 8-ary heaps of 16-byte records with random
+ * priorities: n pushes then n pops, and building the heap from an array.
+ * Usage: bench_heap [n ...], by default 1M and 10M
+ */
+
+typedef struct {
+    double priority;
+    int id;
+} Record;
+
+static int compare_records ( const void * a, const void * b ) {
+    double p = ((const Record *) a)->priority,
+           q = ((const Record *) b)->priority;
+    return p < q ? -1 : p > q;
+}
+
+static void run ( const ArbitraryArray * records, int arity ) {
+
+    int n = ArbitraryArray_size(records);
+    Heap * h = Heap_new(sizeof(Record), arity, compare_records, NULL);
+    Record r;
+    double sum = 0;
+
+    double t = bench_now();
+    for ( int i=0; i<n; i++ ) {
+        Heap_push(h, ArbitraryArray_get_ptr(records, i));
+    }
+    double push = bench_now() - t;
+
+    t = bench_now();
+    while ( Heap_pop(h, &r) ) {
+        sum += r.priority;
+    }
+    double pop = bench_now() - t;
+    Heap_destroy(h);
+
+    t = bench_now();
+    h = Heap_from_array(records, arity, compare_records, NULL);
+    double heapify = bench_now() - t;
+    sum += ((Record *) Heap_peek(h))->priority;
+    Heap_destroy(h);
+
+    bench_sink = sum;
+    printf("%9d  arity %d  push %7.1f ns  pop %7.1f ns  heapify %7.1f ms\n",
+           n, arity, 1e9 * push / n, 1e9 * pop / n, 1e3 * heapify);
+
+}
+
+int main ( int argc, char ** argv ) {
+
+    int sizes[] = { 1000000, 10000000 },
+        num_sizes = 2;
+
+    for ( int s=0; s < (argc > 1 ? argc - 1 : num_sizes); s++ ) {
+        int n = argc > 1 ? atoi(argv[s+1]) : sizes[s];
+        ArbitraryArray * records = ArbitraryArray_new(sizeof(Record));
+        srand(42);
+        for ( int i=0; i<n; i++ ) {
+            Record r = { (double) rand() / RAND_MAX, i };
+            ArbitraryArray_set_from_ptr(records, i, &r);
+        }
+        run(records, 2);
+        run(records, 4);
+        run(records, 8);
+        ArbitraryArray_destroy(records);
+        free(records);
+    }
+
+    return 0;
+
+}
@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arbitrary_array.h"
+#include "bench.h"
+
+/* Loading and reading back 24-byte Point records one element per call and in
+ * bulk, and single-element copies for a size with its own copy path.
+ * Usage: bench_ranges [num_elements]
+ */
+
+typedef struct {
+    double x, y, z;
+} Point;
+
+static void report ( const char * name, double seconds, int n, int element_size ) {
+    printf("%-26s %8.2f ms  %8.2f Melem/s  %6.2f GB/s\n", name, 1e3 * seconds,
+           1e-6 * n / seconds, 1e-9 * n * element_size / seconds);
+}
+
+int main ( int argc, char ** argv ) {
+
+    int n = argc > 1 ? atoi(argv[1]) : 10000000;
+    Point * points = (Point *) malloc(n * sizeof(Point)),
+          * out = (Point *) malloc(n * sizeof(Point));
+    for ( int i=0; i<n; i++ ) {
+        points[i].x = i;
+        points[i].y = -i;
+        points[i].z = 0.5 * i;
+    }
+
+    ArbitraryArray * a = ArbitraryArray_new(sizeof(Point));
+    double t = bench_now();
+    for ( int i=0; i<n; i++ ) ArbitraryArray_set_from_ptr(a, i, points + i);
+    report("set_from_ptr", bench_now() - t, n, sizeof(Point));
+    ArbitraryArray_destroy(a);
+    free(a);
+
+    a = ArbitraryArray_new(sizeof(Point));
+    t = bench_now();
+    ArbitraryArray_push_many(a, points, n);
+    report("push_many", bench_now() - t, n, sizeof(Point));
+
+    t = bench_now();
+    for ( int i=0; i<n; i++ ) memcpy(out + i, ArbitraryArray_get_ptr(a, i), sizeof(Point));
+    report("get_ptr", bench_now() - t, n, sizeof(Point));
+
+    t = bench_now();
+    ArbitraryArray_get_range(a, 0, out, n);
+    report("get_range", bench_now() - t, n, sizeof(Point));
+    bench_sink = out[n-1].z;
+
+    t = bench_now();
+    ArbitraryArray_set_range(a, 0, out, n);
+    report("set_range (in place)", bench_now() - t, n, sizeof(Point));
+    ArbitraryArray_destroy(a);
+    free(a);
+
+    /* The same 24 bytes per element as three 8-byte elements, which take the
+       fixed-size copy path */
+    a = ArbitraryArray_new(sizeof(double));
+    const double * values = (const double *) points;
+    t = bench_now();
+    for ( int i=0; i<3*n; i++ ) ArbitraryArray_set_from_ptr(a, i, (void *) (values + i));
+    report("set_from_ptr (8 bytes)", bench_now() - t, 3 * n, sizeof(double));
+    ArbitraryArray_destroy(a);
+    free(a);
+
+    free(points);
+    free(out);
+    return 0;
+
+}
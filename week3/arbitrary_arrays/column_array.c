@@ -0,0 +1,63 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "column_array.h"
+
+/* public functions **********************************************************/
+
+ColumnArray * ColumnArray_new(int record_size, const RecordField * fields, int num_fields) {
+    assert(record_size > 0 && num_fields > 0);
+    ColumnArray * ca = (ColumnArray *) malloc(sizeof(ColumnArray));
+    ca->record_size = record_size;
+    ca->num_fields = num_fields;
+    ca->fields = (RecordField *) malloc(num_fields * sizeof(RecordField));
+    memcpy(ca->fields, fields, num_fields * sizeof(RecordField));
+    ca->columns = (ArbitraryArray **) malloc(num_fields * sizeof(ArbitraryArray *));
+    for ( int f=0; f<num_fields; f++ ) {
+        assert(fields[f].size > 0 && fields[f].offset >= 0);
+        assert(fields[f].offset + fields[f].size <= record_size);
+        ca->columns[f] = ArbitraryArray_new(fields[f].size);
+    }
+    return ca;
+}
+
+void ColumnArray_destroy(ColumnArray * ca) {
+    for ( int f=0; f<ca->num_fields; f++ ) {
+        ArbitraryArray_destroy(ca->columns[f]);
+        free(ca->columns[f]);
+    }
+    free(ca->columns);
+    free(ca->fields);
+    free(ca);
+}
+
+int ColumnArray_size(const ColumnArray * ca) {
+    return ArbitraryArray_size(ca->columns[0]);
+}
+
+void ColumnArray_get(const ColumnArray * ca, int index, void * record) {
+    assert(index >= 0 && index < ColumnArray_size(ca));
+    char * r = (char *) record;
+    for ( int f=0; f<ca->num_fields; f++ ) {
+        /* Addressed directly, since get_ptr would divide to check the size of every column */
+        const ArbitraryArray * c = ca->columns[f];
+        memcpy(r + ca->fields[f].offset, c->buffer + c->origin + (size_t) index * c->element_size, c->element_size);
+    }
+}
+
+void ColumnArray_set(ColumnArray * ca, int index, const void * record) {
+    const char * r = (const char *) record;
+    for ( int f=0; f<ca->num_fields; f++ ) {
+        ArbitraryArray_set_from_ptr(ca->columns[f], index, (void *) ( r + ca->fields[f].offset ));
+    }
+}
+
+void * ColumnArray_column(const ColumnArray * ca, int field) {
+    assert(field >= 0 && field < ca->num_fields);
+    return ArbitraryArray_get_ptr(ca->columns[field], 0);
+}
+
+void ColumnArray_push(ColumnArray * ca, const void * record) {
+    ColumnArray_set(ca, ColumnArray_size(ca), record);
+}
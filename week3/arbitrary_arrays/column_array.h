@@ -0,0 +1,75 @@
+#ifndef _COLUMN_ARRAY
+#define _COLUMN_ARRAY
+
+#include <stddef.h>
+#include "arbitrary_array.h"
+
+/*! @file
+ *  An array of records stored a field at a time. A record descriptor gives
+ *  the offset and size of each field, and each field lives in its own
+ *  ArbitraryArray column. A scan over one field, such as the x of a Point,
+ *  then reads only that field's bytes. An ArbitraryArray of the same records
+ *  would pull the other fields into the cache too. The column pointers give
+ *  plain arrays, which the compiler can vectorize loops over.
+ *
+ *  Whole records are still read and written through gather (get) and
+ *  scatter (set), which copy each field between a record and its column.
+ */
+
+/*! Where a field lies within a record */
+typedef struct {
+    int offset,
+        size;
+} RecordField;
+
+/*! The descriptor entry for a member of a struct type, e.g. RECORD_FIELD(Point, x) */
+#define RECORD_FIELD(type, member) { (int) offsetof(type, member), (int) sizeof(((type *) 0)->member) }
+
+typedef struct {
+    int record_size,
+        num_fields;
+    RecordField * fields;
+    ArbitraryArray ** columns;  /* one per field, all the same size */
+} ColumnArray;
+
+/* Constructors / Destructors ************************************************/
+
+/*! Makes an empty array of records.
+ *  \param record_size The size of a whole record in bytes
+ *  \param fields The offset and size of each field, which must lie within a record
+ *  \param num_fields The number of fields
+ */
+ColumnArray * ColumnArray_new(int record_size, const RecordField * fields, int num_fields);
+void ColumnArray_destroy(ColumnArray *);
+
+/* Getters / Setters *********************************************************/
+
+/*! Gathers the fields of the record at index into record. Bytes of the record
+ *  outside the fields, such as padding, are left alone.
+ *  \param ca The array
+ *  \param index The position of the record, which must be in the array
+ *  \param record Receives the record, record_size bytes
+ */
+void ColumnArray_get(const ColumnArray * ca, int index, void * record);
+
+/*! Scatters the fields of record into the columns at index, extending the
+ *  array with zeroed records if index is past the end.
+ */
+void ColumnArray_set(ColumnArray * ca, int index, const void * record);
+
+int ColumnArray_size(const ColumnArray *);
+
+/*! Returns the address of the first value of a field's column. The values of
+ *  the field for all the records follow one another, so the column can be
+ *  scanned as a plain array. The address stays valid until the array grows.
+ *  Returns NULL if the array is empty.
+ *  \param ca The array
+ *  \param field The index of the field in the descriptor
+ */
+void * ColumnArray_column(const ColumnArray * ca, int field);
+
+/* Operations ****************************************************************/
+
+void ColumnArray_push(ColumnArray *, const void * record);
+
+#endif
@@ -0,0 +1,290 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "hash_map.h"
+
+/* Each bucket starts with the hash of its key. Real hashes are at least 2,
+   leaving 0 for an empty bucket and 1 for a bucket of the old table whose
+   entry has moved; probes stop at the first and skip the second. */
+#define EMPTY 0
+#define MOVED 1
+
+#define KEY_OFFSET sizeof(uint64_t)
+#define BATCH 16
+
+/* private functions *********************************************************/
+
+static int align8 ( int n ) {
+    return ( n + 7 ) & ~7;
+}
+
+static char * bucket ( const HashMap * map, const HashMapTable * t, int i ) {
+    return t->base + (size_t) i * map->bucket_size;
+}
+
+static uint64_t bucket_hash ( const char * b ) {
+    uint64_t h;
+    memcpy(&h, b, sizeof(h));
+    return h;
+}
+
+static void set_bucket_hash ( char * b, uint64_t h ) {
+    memcpy(b, &h, sizeof(h));
+}
+
+static uint64_t hash_key ( const HashMap * map, const void * key ) {
+    uint64_t h = map->hash(key, map->key_size);
+    return h < 2 ? h + 2 : h;
+}
+
+static void table_init ( HashMap * map, HashMapTable * t, int capacity ) {
+    t->buckets = ArbitraryArray_new_zeros(map->bucket_size, capacity);
+    t->base = (char *) ArbitraryArray_get_ptr(t->buckets, 0);
+    t->capacity = capacity;
+    t->count = 0;
+}
+
+static void table_free ( HashMapTable * t ) {
+    ArbitraryArray_destroy(t->buckets);
+    free(t->buckets);
+    t->buckets = NULL;
+    t->base = NULL;
+    t->capacity = 0;
+    t->count = 0;
+}
+
+/* Position of the key in the table, or -1 */
+static int table_find ( const HashMap * map, const HashMapTable * t, const void * key, uint64_t h ) {
+    int mask = t->capacity - 1;
+    for ( int i = (int) ( h & mask ); ; i = ( i + 1 ) & mask ) {
+        const char * b = bucket(map, t, i);
+        uint64_t bh = bucket_hash(b);
+        if ( bh == EMPTY ) {
+            return -1;
+        } else if ( bh == h && map->equal(key, b + KEY_OFFSET, map->key_size) ) {
+            return i;
+        }
+    }
+}
+
+/* Adds an entry that is not in the table, copying the bucket contents */
+static void table_insert ( const HashMap * map, HashMapTable * t, uint64_t h, const void * key, const void * value ) {
+    int mask = t->capacity - 1,
+        i = (int) ( h & mask );
+    while ( bucket_hash(bucket(map, t, i)) != EMPTY ) {
+        i = ( i + 1 ) & mask;
+    }
+    char * b = bucket(map, t, i);
+    set_bucket_hash(b, h);
+    memcpy(b + KEY_OFFSET, key, map->key_size);
+    memcpy(b + map->value_offset, value, map->value_size);
+    t->count++;
+}
+
+/* Empties bucket i of the current table, shifting back the entries after it
+   that probed past it, so no probe sequence is broken */
+static void table_delete ( const HashMap * map, HashMapTable * t, int i ) {
+    int mask = t->capacity - 1;
+    for ( int j = ( i + 1 ) & mask; ; j = ( j + 1 ) & mask ) {
+        char * b = bucket(map, t, j);
+        uint64_t bh = bucket_hash(b);
+        if ( bh == EMPTY ) {
+            break;
+        }
+        int home = (int) ( bh & mask );
+        /* The entry at j may move to i unless its home lies in (i, j] */
+        if ( ( ( j - home ) & mask ) >= ( ( j - i ) & mask ) ) {
+            memcpy(bucket(map, t, i), b, map->bucket_size);
+            i = j;
+        }
+    }
+    set_bucket_hash(bucket(map, t, i), EMPTY);
+    t->count--;
+}
+
+/* Moves up to HASH_MAP_MIGRATE_STEP buckets of the old table to the current one */
+static void migrate ( HashMap * map, int steps ) {
+    HashMapTable * old = &map->old;
+    if ( old->buckets == NULL ) {
+        return;
+    }
+    for ( ; steps > 0 && map->migrated < old->capacity; steps-- ) {
+        char * b = bucket(map, old, map->migrated++);
+        uint64_t h = bucket_hash(b);
+        if ( h != EMPTY && h != MOVED ) {
+            table_insert(map, &map->table, h, b + KEY_OFFSET, b + map->value_offset);
+            set_bucket_hash(b, MOVED);
+            old->count--;
+        }
+    }
+    if ( map->migrated == old->capacity ) {
+        table_free(old);
+    }
+}
+
+/* Starts moving to a table twice the size */
+static void grow ( HashMap * map ) {
+    if ( map->old.buckets != NULL ) {
+        migrate(map, map->old.capacity);
+    }
+    map->old = map->table;
+    map->migrated = 0;
+    table_init(map, &map->table, 2 * map->old.capacity);
+}
+
+static void * find ( const HashMap * map, const void * key, uint64_t h ) {
+    int i = table_find(map, &map->table, key, h);
+    if ( i >= 0 ) {
+        return bucket(map, &map->table, i) + map->value_offset;
+    }
+    if ( map->old.buckets != NULL ) {
+        i = table_find(map, &map->old, key, h);
+        if ( i >= 0 ) {
+            return bucket(map, &map->old, i) + map->value_offset;
+        }
+    }
+    return NULL;
+}
+
+/* public functions **********************************************************/
+
+uint64_t HashMap_hash_bytes(const void * key, int key_size) {
+    const unsigned char * p = (const unsigned char *) key;
+    uint64_t h = 0x9e3779b97f4a7c15ull ^ (uint64_t) key_size;
+    for ( ; key_size >= 8; p += 8, key_size -= 8 ) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        h = ( h ^ word ) * 0xbf58476d1ce4e5b9ull;
+        h ^= h >> 31;
+    }
+    if ( key_size > 0 ) {
+        uint64_t word = 0;
+        memcpy(&word, p, key_size);
+        h = ( h ^ word ) * 0xbf58476d1ce4e5b9ull;
+        h ^= h >> 31;
+    }
+    /* The splitmix64 finalizer, so the low bits used for the bucket are well mixed */
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebull;
+    h ^= h >> 31;
+    return h;
+}
+
+int HashMap_equal_bytes(const void * a, const void * b, int key_size) {
+    return memcmp(a, b, key_size) == 0;
+}
+
+HashMap * HashMap_new(int key_size, int value_size, HashMapHash hash, HashMapEqual equal) {
+    assert(key_size > 0 && value_size >= 0);
+    HashMap * map = (HashMap *) malloc(sizeof(HashMap));
+    map->key_size = key_size;
+    map->value_size = value_size;
+    map->value_offset = align8(KEY_OFFSET + key_size);
+    map->bucket_size = align8(map->value_offset + value_size);
+    map->hash = hash != NULL ? hash : HashMap_hash_bytes;
+    map->equal = equal != NULL ? equal : HashMap_equal_bytes;
+    table_init(map, &map->table, HASH_MAP_INITIAL_CAPACITY);
+    map->old.buckets = NULL;
+    map->old.base = NULL;
+    map->old.capacity = 0;
+    map->old.count = 0;
+    map->migrated = 0;
+    return map;
+}
+
+void HashMap_destroy(HashMap * map) {
+    table_free(&map->table);
+    if ( map->old.buckets != NULL ) {
+        table_free(&map->old);
+    }
+    free(map);
+}
+
+int HashMap_size(const HashMap * map) {
+    return map->table.count + map->old.count;
+}
+
+void HashMap_put(HashMap * map, const void * key, const void * value) {
+
+    migrate(map, HASH_MAP_MIGRATE_STEP);
+
+    uint64_t h = hash_key(map, key);
+    int i = table_find(map, &map->table, key, h);
+    if ( i >= 0 ) {
+        memcpy(bucket(map, &map->table, i) + map->value_offset, value, map->value_size);
+        return;
+    }
+
+    if ( map->old.buckets != NULL ) {
+        i = table_find(map, &map->old, key, h);
+        if ( i >= 0 ) {
+            /* Move the key now rather than keeping it in two places */
+            set_bucket_hash(bucket(map, &map->old, i), MOVED);
+            map->old.count--;
+        }
+    }
+
+    if ( 4 * (map->table.count + 1) > 3 * map->table.capacity ) {
+        grow(map);
+    }
+    table_insert(map, &map->table, h, key, value);
+
+}
+
+void * HashMap_get(const HashMap * map, const void * key) {
+    return find(map, key, hash_key(map, key));
+}
+
+void HashMap_get_many(const HashMap * map, const void * keys, int n, void ** values) {
+    const char * k = (const char *) keys;
+    uint64_t hashes[BATCH];
+    for ( int start = 0; start < n; start += BATCH ) {
+        int m = n - start < BATCH ? n - start : BATCH;
+        for ( int i=0; i<m; i++ ) {
+            uint64_t h = hash_key(map, k + (size_t) (start + i) * map->key_size);
+            hashes[i] = h;
+            __builtin_prefetch(bucket(map, &map->table, (int) ( h & (map->table.capacity - 1) )));
+            if ( map->old.buckets != NULL ) {
+                __builtin_prefetch(bucket(map, &map->old, (int) ( h & (map->old.capacity - 1) )));
+            }
+        }
+        for ( int i=0; i<m; i++ ) {
+            values[start + i] = find(map, k + (size_t) (start + i) * map->key_size, hashes[i]);
+        }
+    }
+}
+
+int HashMap_remove(HashMap * map, const void * key) {
+    migrate(map, HASH_MAP_MIGRATE_STEP);
+    uint64_t h = hash_key(map, key);
+    int i = table_find(map, &map->table, key, h);
+    if ( i >= 0 ) {
+        table_delete(map, &map->table, i);
+        return 1;
+    }
+    if ( map->old.buckets != NULL ) {
+        i = table_find(map, &map->old, key, h);
+        if ( i >= 0 ) {
+            set_bucket_hash(bucket(map, &map->old, i), MOVED);
+            map->old.count--;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void HashMap_foreach(const HashMap * map, void (*f) (const void * key, void * value, void * arg), void * arg) {
+    const HashMapTable * tables[2] = { &map->old, &map->table };
+    for ( int t=0; t<2; t++ ) {
+        for ( int i=0; i<tables[t]->capacity; i++ ) {
+            char * b = bucket(map, tables[t], i);
+            uint64_t h = bucket_hash(b);
+            if ( h != EMPTY && h != MOVED ) {
+                f(b + KEY_OFFSET, b + map->value_offset, arg);
+            }
+        }
+    }
+}
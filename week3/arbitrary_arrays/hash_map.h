@@ -0,0 +1,93 @@
+#ifndef _HASH_MAP
+#define _HASH_MAP
+
+#include <stdint.h>
+#include "arbitrary_array.h"
+
+/*! @file
+ *  A hash map from fixed-size keys to fixed-size values, both copied into the
+ *  map. Buckets are elements of an ArbitraryArray holding the hash of the key,
+ *  the key and the value side by side, and collisions are resolved by linear
+ *  probing. Removal shifts later entries back, so the table has no tombstones.
+ *
+ *  When the table fills past three quarters it doubles, but the entries move to
+ *  the new table a few buckets at a time, on each later put or remove, instead
+ *  of in one long pause. Lookups check both tables while the move is under way.
+ */
+
+#define HASH_MAP_INITIAL_CAPACITY 16
+#define HASH_MAP_MIGRATE_STEP 16  /* old buckets moved per put or remove */
+
+typedef uint64_t (*HashMapHash) ( const void * key, int key_size );
+typedef int (*HashMapEqual) ( const void * a, const void * b, int key_size );
+
+typedef struct {
+    ArbitraryArray * buckets;  /* NULL if the table is not in use */
+    char * base;               /* address of bucket 0 */
+    int capacity,              /* a power of two */
+        count;                 /* entries in the table */
+} HashMapTable;
+
+typedef struct {
+    int key_size,
+        value_size,
+        value_offset,          /* of the value within a bucket */
+        bucket_size;
+    HashMapHash hash;
+    HashMapEqual equal;
+    HashMapTable table,
+                 old;          /* the table being moved from, while growing */
+    int migrated;              /* buckets of the old table moved so far */
+} HashMap;
+
+/* Constructors / Destructors ************************************************/
+
+/*! Makes an empty map.
+ *  \param key_size The size of a key in bytes
+ *  \param value_size The size of a value in bytes
+ *  \param hash Hashes a key, or NULL to hash its bytes
+ *  \param equal Returns non-zero if two keys are equal, or NULL to compare their bytes
+ */
+HashMap * HashMap_new(int key_size, int value_size, HashMapHash hash, HashMapEqual equal);
+void HashMap_destroy(HashMap *);
+
+/* Getters / Setters *********************************************************/
+
+/*! Sets the value of a key, adding the key if it is not there.
+ */
+void HashMap_put(HashMap *, const void * key, const void * value);
+
+/*! Returns the address of the value of a key, or NULL if the key is not there. The
+ *  address stays valid until the next put or remove.
+ */
+void * HashMap_get(const HashMap *, const void * key);
+
+/*! Looks up n keys, stored one after the other, and stores the address of each value,
+ *  or NULL, in values. The buckets for a group of keys are prefetched before any of
+ *  them is probed, so cache misses overlap instead of adding up.
+ *  \param map The map
+ *  \param keys The keys, n * key_size bytes
+ *  \param n The number of keys
+ *  \param values Receives n value addresses
+ */
+void HashMap_get_many(const HashMap * map, const void * keys, int n, void ** values);
+
+/*! Removes a key. Returns 1 if it was there and 0 otherwise.
+ */
+int HashMap_remove(HashMap *, const void * key);
+
+int HashMap_size(const HashMap *);
+
+/* Operations ****************************************************************/
+
+/*! Calls f on every entry, in no particular order. f may change the value but must
+ *  not add or remove keys.
+ */
+void HashMap_foreach(const HashMap *, void (*f) (const void * key, void * value, void * arg), void * arg);
+
+/*! The default hash and equality, over the bytes of the key
+ */
+uint64_t HashMap_hash_bytes(const void * key, int key_size);
+int HashMap_equal_bytes(const void * a, const void * b, int key_size);
+
+#endif
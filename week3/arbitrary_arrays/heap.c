@@ -0,0 +1,186 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "heap.h"
+
+/* private functions *********************************************************/
+
+static char * element ( const Heap * h, int i ) {
+    const ArbitraryArray * a = h->elements;
+    return a->buffer + a->origin + (size_t) i * a->element_size;
+}
+
+/* Makes room in the position index for the given id */
+static void reserve_id ( Heap * h, int id ) {
+    assert(id >= 0);
+    if ( id >= h->num_positions ) {
+        int n = h->num_positions > 0 ? h->num_positions : 16;
+        while ( n <= id ) {
+            n *= 2;
+        }
+        h->positions = (int *) realloc(h->positions, n * sizeof(int));
+        for ( int i=h->num_positions; i<n; i++ ) {
+            h->positions[i] = -1;
+        }
+        h->num_positions = n;
+    }
+}
+
+/* Copies x into position i of the heap, recording its new position */
+static void place ( Heap * h, int i, const char * x ) {
+    memcpy(element(h, i), x, h->elements->element_size);
+    if ( h->id != NULL ) {
+        h->positions[h->id(x)] = i;
+    }
+}
+
+/* Moves the element in scratch up from position i, which is free, until its
+   parent comes out before it. Elements passed over move down a level. */
+static void sift_up ( Heap * h, int i ) {
+    while ( i > 0 ) {
+        int parent = ( i - 1 ) / h->arity;
+        char * p = element(h, parent);
+        if ( h->compare(h->scratch, p) >= 0 ) {
+            break;
+        }
+        place(h, i, p);
+        i = parent;
+    }
+    place(h, i, h->scratch);
+}
+
+/* Moves the element in scratch down from position i, which is free, until no
+   child comes out before it */
+static void sift_down ( Heap * h, int i, int n ) {
+    for ( ;; ) {
+        int first = h->arity * i + 1;
+        if ( first >= n ) {
+            break;
+        }
+        int last = first + h->arity < n ? first + h->arity : n,
+            best = first;
+        for ( int c = first + 1; c < last; c++ ) {
+            if ( h->compare(element(h, c), element(h, best)) < 0 ) {
+                best = c;
+            }
+        }
+        char * b = element(h, best);
+        if ( h->compare(b, h->scratch) >= 0 ) {
+            break;
+        }
+        place(h, i, b);
+        i = best;
+    }
+    place(h, i, h->scratch);
+}
+
+/* public functions **********************************************************/
+
+Heap * Heap_new(int element_size, int arity, HeapCompare compare, HeapId id) {
+    assert(element_size > 0 && arity >= 2 && compare != NULL);
+    Heap * h = (Heap *) malloc(sizeof(Heap));
+    h->elements = ArbitraryArray_new(element_size);
+    h->arity = arity;
+    h->compare = compare;
+    h->id = id;
+    h->positions = NULL;
+    h->num_positions = 0;
+    h->scratch = (char *) malloc(element_size);
+    return h;
+}
+
+Heap * Heap_from_array(const ArbitraryArray * a, int arity, HeapCompare compare, HeapId id) {
+
+    int n = ArbitraryArray_size(a);
+    Heap * h = Heap_new(a->element_size, arity, compare, id);
+    ArbitraryArray_set_range(h->elements, 0, a->buffer + a->origin, n);
+
+    if ( id != NULL ) {
+        for ( int i=0; i<n; i++ ) {
+            int k = id(element(h, i));
+            reserve_id(h, k);
+            h->positions[k] = i;
+        }
+    }
+
+    /* Floyd's method: sift down each parent, from the last one up. Most elements
+       are near the bottom and move only a level or two, so the total is O(n). */
+    for ( int i = ( n - 2 ) / arity; n > 1 && i >= 0; i-- ) {
+        memcpy(h->scratch, element(h, i), a->element_size);
+        sift_down(h, i, n);
+    }
+
+    return h;
+
+}
+
+void Heap_destroy(Heap * h) {
+    ArbitraryArray_destroy(h->elements);
+    free(h->elements);
+    free(h->positions);
+    free(h->scratch);
+    free(h);
+}
+
+int Heap_size(const Heap * h) {
+    return ArbitraryArray_size(h->elements);
+}
+
+void * Heap_peek(const Heap * h) {
+    return ArbitraryArray_get_ptr(h->elements, 0);
+}
+
+int Heap_contains(const Heap * h, int id) {
+    assert(h->id != NULL && id >= 0);
+    return id < h->num_positions && h->positions[id] >= 0;
+}
+
+void Heap_push(Heap * h, const void * x) {
+    int n = Heap_size(h);
+    if ( h->id != NULL ) {
+        reserve_id(h, h->id(x));
+    }
+    /* Extend the array by one element, then fill the hole on the way up */
+    ArbitraryArray_set_from_ptr(h->elements, n, (void *) x);
+    memcpy(h->scratch, x, h->elements->element_size);
+    sift_up(h, n);
+}
+
+int Heap_pop(Heap * h, void * x) {
+
+    int n = Heap_size(h);
+    if ( n == 0 ) {
+        return 0;
+    }
+
+    char * top = element(h, 0);
+    if ( x != NULL ) {
+        memcpy(x, top, h->elements->element_size);
+    }
+    if ( h->id != NULL ) {
+        h->positions[h->id(top)] = -1;
+    }
+
+    /* The last element fills the hole at the top */
+    n--;
+    if ( n > 0 ) {
+        memcpy(h->scratch, element(h, n), h->elements->element_size);
+    }
+    h->elements->end -= h->elements->element_size;
+    if ( n > 0 ) {
+        sift_down(h, 0, n);
+    }
+    return 1;
+
+}
+
+void Heap_decrease_key(Heap * h, const void * x) {
+    assert(h->id != NULL);
+    int k = h->id(x);
+    assert(Heap_contains(h, k));
+    int i = h->positions[k];
+    assert(h->compare(x, element(h, i)) <= 0);
+    memcpy(h->scratch, x, h->elements->element_size);
+    sift_up(h, i);
+}
@@ -0,0 +1,85 @@
+#ifndef _HEAP
+#define _HEAP
+
+#include "arbitrary_array.h"
+
+/*! @file
+ *  A priority queue of fixed-size records, kept as a d-ary heap in an ArbitraryArray.
+ *  The children of element i are elements d*i+1 to d*i+d. A larger arity makes the
+ *  heap shallower, so a push does fewer moves, and the d children a pop compares sit
+ *  next to each other, usually in one or two cache lines. An arity of 4 does better
+ *  than a binary heap on large heaps.
+ *
+ *  To change the priority of an element already in the heap, give each element a
+ *  small non-negative id through a HeapId function. The heap then keeps the position
+ *  of every id, and Heap_decrease_key finds the element without a search.
+ */
+
+#define HEAP_DEFAULT_ARITY 4
+
+/*! Returns a negative number if a comes out of the heap before b, a positive number
+ *  if after, and 0 if either may come first
+ */
+typedef int (*HeapCompare) ( const void * a, const void * b );
+
+/*! Returns the id of an element, a small non-negative integer
+ */
+typedef int (*HeapId) ( const void * element );
+
+typedef struct {
+    ArbitraryArray * elements;
+    int arity;
+    HeapCompare compare;
+    HeapId id;                 /* NULL if there is no position index */
+    int * positions,           /* position of each id in the heap, or -1 */
+        num_positions;
+    char * scratch;            /* holds the element being sifted */
+} Heap;
+
+/* Constructors / Destructors ************************************************/
+
+/*! Makes an empty heap.
+ *  \param element_size The size of an element in bytes
+ *  \param arity The number of children of each element, at least 2
+ *  \param compare Orders the elements
+ *  \param id Gives the id of an element, or NULL if decrease_key is not used
+ */
+Heap * Heap_new(int element_size, int arity, HeapCompare compare, HeapId id);
+
+/*! Makes a heap of the elements of an array, which is not changed. Takes O(n) time,
+ *  rather than the O(n log n) of pushing the elements one at a time.
+ */
+Heap * Heap_from_array(const ArbitraryArray * a, int arity, HeapCompare compare, HeapId id);
+
+void Heap_destroy(Heap *);
+
+/* Getters / Setters *********************************************************/
+
+int Heap_size(const Heap *);
+
+/*! Returns the address of the element that comes out first, or NULL if the heap is
+ *  empty. The address stays valid until the heap is next changed.
+ */
+void * Heap_peek(const Heap *);
+
+/*! Returns 1 if an element with the given id is in the heap. Needs a HeapId.
+ */
+int Heap_contains(const Heap *, int id);
+
+/* Operations ****************************************************************/
+
+void Heap_push(Heap *, const void * element);
+
+/*! Removes the element that comes out first. Returns 1 and copies it into element
+ *  if the heap was not empty, and returns 0 otherwise.
+ *  \param h The heap
+ *  \param element Receives the element, or NULL to discard it
+ */
+int Heap_pop(Heap * h, void * element);
+
+/*! Replaces the element with the same id as element, which must be in the heap,
+ *  by element, which must not come out after it. Needs a HeapId.
+ */
+void Heap_decrease_key(Heap *, const void * element);
+
+#endif
@@ -1,6 +1,11 @@
 #include <math.h>
 #include <float.h> /* defines DBL_EPSILON */
+#include <ctype.h>
+#include <strings.h>
 #include "arbitrary_array.h"
+#include "hash_map.h"
+#include "heap.h"
+#include "column_array.h"
 #include "gtest/gtest.h"
 
 #define X 1.2345
@@ -16,10 +21,272 @@ char * point_to_string ( void * p ) {
     return str;
 }
 
+/* Keys of 16 chars, compared without regard to case */
+static uint64_t hash_name ( const void * key, int key_size ) {
+    char lower[16];
+    for ( int i=0; i<16; i++ ) {
+        lower[i] = tolower(((const char *) key)[i]);
+    }
+    return HashMap_hash_bytes(lower, key_size);
+}
+
+static int equal_names ( const void * a, const void * b, int key_size ) {
+    return strncasecmp((const char *) a, (const char *) b, key_size) == 0;
+}
+
+static void add_value ( const void * key, void * value, void * arg ) {
+    (void) key;
+    *(long *) arg += *(long *) value;
+}
+
+/* Tasks ordered by priority, with ids for decrease_key */
+typedef struct {
+    double priority;
+    int id;
+} Task;
+
+static int compare_tasks ( const void * a, const void * b ) {
+    double p = ((const Task *) a)->priority,
+           q = ((const Task *) b)->priority;
+    return p < q ? -1 : p > q;
+}
+
+static int task_id ( const void * t ) {
+    return ((const Task *) t)->id;
+}
+
 namespace {
 
     TEST(ArbitraryArray,Basics) {
         // Tests here
-    } 
+    }
+
+    TEST(ArbitraryArray, SetAndGet) {
+        ArbitraryArray * a = ArbitraryArray_new(sizeof(Point));
+        Point p = { 1, 2, 3 };
+        ArbitraryArray_set_from_ptr(a, 0, &p);
+        p.x = X;
+        ArbitraryArray_set_from_ptr(a, 100, &p);
+        ASSERT_EQ(ArbitraryArray_size(a), 101);
+        ASSERT_EQ(((Point *) ArbitraryArray_get_ptr(a, 0))->z, 3);
+        ASSERT_EQ(((Point *) ArbitraryArray_get_ptr(a, 50))->x, 0);
+        ASSERT_EQ(((Point *) ArbitraryArray_get_ptr(a, 100))->x, X);
+        ASSERT_EQ(ArbitraryArray_get_ptr(a, 101), (void *) NULL);
+        ArbitraryArray_destroy(a);
+        free(a);
+        /* One of the sizes with its own copy path */
+        ArbitraryArray * b = ArbitraryArray_new(sizeof(int));
+        for ( int i=0; i<1000; i++ ) {
+            ArbitraryArray_set_from_ptr(b, i, &i);
+        }
+        ASSERT_EQ(*(int *) ArbitraryArray_get_ptr(b, 999), 999);
+        ArbitraryArray_destroy(b);
+        free(b);
+    }
+
+    TEST(ArbitraryArray, Ranges) {
+        Point points[1000];
+        for ( int i=0; i<1000; i++ ) {
+            points[i].x = i;
+            points[i].y = 2 * i;
+            points[i].z = X;
+        }
+        ArbitraryArray * a = ArbitraryArray_new(sizeof(Point));
+        ArbitraryArray_push_many(a, points, 600);
+        ArbitraryArray_push_many(a, points + 600, 400);
+        ASSERT_EQ(ArbitraryArray_size(a), 1000);
+        Point out[10];
+        ArbitraryArray_get_range(a, 990, out, 10);
+        ASSERT_EQ(out[9].x, 999);
+        ASSERT_EQ(out[0].y, 1980);
+        /* Overwriting in the middle, and past the end with a gap */
+        ArbitraryArray_set_range(a, 10, points, 5);
+        ASSERT_EQ(((Point *) ArbitraryArray_get_ptr(a, 14))->x, 4);
+        ASSERT_EQ(((Point *) ArbitraryArray_get_ptr(a, 15))->x, 15);
+        ArbitraryArray_set_range(a, 2000, points, 3);
+        ASSERT_EQ(ArbitraryArray_size(a), 2003);
+        ASSERT_EQ(((Point *) ArbitraryArray_get_ptr(a, 1500))->z, 0);
+        ASSERT_EQ(((Point *) ArbitraryArray_get_ptr(a, 2002))->y, 4);
+        ArbitraryArray_push_many(a, points, 0);
+        ASSERT_EQ(ArbitraryArray_size(a), 2003);
+        ASSERT_DEATH(ArbitraryArray_get_range(a, 2000, out, 4), ".*Assertion.*");
+        ArbitraryArray_destroy(a);
+        free(a);
+    }
+
+    TEST(HashMap, PutGetRemove) {
+        HashMap * map = HashMap_new(sizeof(int), sizeof(long), NULL, NULL);
+        for ( int i=0; i<100000; i++ ) {
+            long value = 10L * i;
+            HashMap_put(map, &i, &value);
+            if ( map->old.buckets != NULL ) {
+                /* Mid-growth, keys in either table are found */
+                int first = 0;
+                ASSERT_EQ(*(long *) HashMap_get(map, &first), 0);
+                ASSERT_EQ(*(long *) HashMap_get(map, &i), value);
+            }
+        }
+        ASSERT_EQ(HashMap_size(map), 100000);
+        for ( int i=0; i<100000; i+=2 ) {
+            ASSERT_TRUE(HashMap_remove(map, &i));
+        }
+        ASSERT_EQ(HashMap_size(map), 50000);
+        for ( int i=0; i<100000; i++ ) {
+            long * value = (long *) HashMap_get(map, &i);
+            if ( i % 2 == 0 ) {
+                ASSERT_EQ(value, (long *) NULL);
+            } else {
+                ASSERT_EQ(*value, 10L * i);
+            }
+        }
+        int missing = -1;
+        ASSERT_FALSE(HashMap_remove(map, &missing));
+        long total = 0;
+        HashMap_foreach(map, add_value, &total);
+        ASSERT_EQ(total, 10L * 50000L * 50000L);
+        /* Overwriting keeps the size */
+        int key = 7;
+        long value = -1;
+        HashMap_put(map, &key, &value);
+        ASSERT_EQ(HashMap_size(map), 50000);
+        ASSERT_EQ(*(long *) HashMap_get(map, &key), -1);
+        HashMap_destroy(map);
+    }
+
+    TEST(HashMap, CallbacksAndBatches) {
+        HashMap * map = HashMap_new(16, sizeof(Point), hash_name, equal_names);
+        char name[16] = "Origin";
+        Point p = { 0, 0, 0 };
+        HashMap_put(map, name, &p);
+        strncpy(name, "UNIT", 16);
+        p.x = 1;
+        HashMap_put(map, name, &p);
+        char other[16] = "origin";
+        ASSERT_EQ(((Point *) HashMap_get(map, other))->x, 0);
+        strncpy(other, "unit", 16);
+        ASSERT_EQ(((Point *) HashMap_get(map, other))->x, 1);
+        ASSERT_EQ(HashMap_size(map), 2);
+        HashMap_destroy(map);
+        /* Batch lookups match single ones, present or not */
+        map = HashMap_new(sizeof(int), sizeof(int), NULL, NULL);
+        for ( int i=0; i<1000; i++ ) {
+            int square = i * i;
+            HashMap_put(map, &i, &square);
+        }
+        int keys[1500];
+        void * values[1500];
+        for ( int i=0; i<1500; i++ ) {
+            keys[i] = 1499 - i;
+        }
+        HashMap_get_many(map, keys, 1500, values);
+        for ( int i=0; i<1500; i++ ) {
+            ASSERT_EQ(values[i], HashMap_get(map, keys + i));
+        }
+        ASSERT_EQ(*(int *) values[1499], 0);
+        ASSERT_EQ(values[0], (void *) NULL);
+        HashMap_destroy(map);
+    }
 
-}
\ No newline at end of file
+    TEST(Heap, PushPopPeek) {
+        for ( int arity=2; arity<=5; arity++ ) {
+            Heap * h = Heap_new(sizeof(Task), arity, compare_tasks, NULL);
+            Task t;
+            ASSERT_EQ(Heap_peek(h), (void *) NULL);
+            ASSERT_EQ(Heap_pop(h, &t), 0);
+            for ( int i=0; i<1000; i++ ) {
+                t.priority = ( i * 7919 ) % 1000;
+                t.id = i;
+                Heap_push(h, &t);
+            }
+            ASSERT_EQ(Heap_size(h), 1000);
+            for ( int i=0; i<1000; i++ ) {
+                ASSERT_EQ(((Task *) Heap_peek(h))->priority, i);
+                ASSERT_EQ(Heap_pop(h, &t), 1);
+                ASSERT_EQ(t.priority, i);
+            }
+            ASSERT_EQ(Heap_size(h), 0);
+            Heap_destroy(h);
+        }
+    }
+
+    TEST(Heap, HeapifyAndDecreaseKey) {
+        ArbitraryArray * a = ArbitraryArray_new(sizeof(Task));
+        for ( int i=0; i<500; i++ ) {
+            Task t = { (double) ( ( i * 31 ) % 500 ), i };
+            ArbitraryArray_set_from_ptr(a, i, &t);
+        }
+        Heap * h = Heap_from_array(a, HEAP_DEFAULT_ARITY, compare_tasks, task_id);
+        ASSERT_EQ(Heap_size(h), 500);
+        ASSERT_EQ(ArbitraryArray_size(a), 500);
+        /* Move every task with an odd id to the front, keeping their order */
+        for ( int i=1; i<500; i+=2 ) {
+            Task t = *(Task *) ArbitraryArray_get_ptr(a, i);
+            t.priority -= 1000;
+            Heap_decrease_key(h, &t);
+        }
+        Task t, last = { -INFINITY, -1 };
+        for ( int i=0; i<500; i++ ) {
+            ASSERT_TRUE(Heap_contains(h, i));
+        }
+        for ( int i=0; i<500; i++ ) {
+            Heap_pop(h, &t);
+            ASSERT_FALSE(Heap_contains(h, t.id));
+            ASSERT_LE(last.priority, t.priority);
+            ASSERT_EQ(t.id % 2, i < 250 ? 1 : 0);
+            last = t;
+        }
+        Heap_destroy(h);
+        ArbitraryArray_destroy(a);
+        free(a);
+    }
+
+    TEST(ColumnArray, GatherScatterAndColumns) {
+        RecordField fields[] = { RECORD_FIELD(Point, x), RECORD_FIELD(Point, y), RECORD_FIELD(Point, z) };
+        ColumnArray * ca = ColumnArray_new(sizeof(Point), fields, 3);
+        ASSERT_EQ(ColumnArray_size(ca), 0);
+        ASSERT_EQ(ColumnArray_column(ca, 0), (void *) NULL);
+        for ( int i=0; i<100; i++ ) {
+            Point p = { (double) i, X * i, (double) -i };
+            ColumnArray_push(ca, &p);
+        }
+        Point p = { 1, 2, 3 };
+        ColumnArray_set(ca, 110, &p);
+        ASSERT_EQ(ColumnArray_size(ca), 111);
+        ColumnArray_get(ca, 105, &p);
+        ASSERT_EQ(p.x, 0);
+        ASSERT_EQ(p.z, 0);
+        ColumnArray_get(ca, 7, &p);
+        ASSERT_EQ(p.x, 7);
+        ASSERT_NEAR(p.y, 7 * X, DBL_EPSILON * 10);
+        ASSERT_EQ(p.z, -7);
+        /* Each column is a plain array of one field */
+        double * x = (double *) ColumnArray_column(ca, 0),
+               * z = (double *) ColumnArray_column(ca, 2),
+               sum = 0;
+        for ( int i=0; i<ColumnArray_size(ca); i++ ) {
+            sum += x[i] + z[i];
+        }
+        ASSERT_EQ(sum, 1 + 3);
+        ColumnArray_destroy(ca);
+    }
+
+    TEST(ArbitraryArray, Arena) {
+        Arena * arena = arena_new(0);
+        for ( int round=0; round<3; round++ ) {
+            ArbitraryArray * points = ArbitraryArray_new_in(arena, sizeof(Point)),
+                           * ids = ArbitraryArray_new_in(arena, sizeof(int));
+            for ( int i=0; i<5000; i++ ) {
+                Point p = { (double) i, 0, (double) round };
+                ArbitraryArray_set_from_ptr(points, i, &p);
+                ArbitraryArray_set_from_ptr(ids, i, &i);
+            }
+            ASSERT_EQ(ArbitraryArray_size(points), 5000);
+            ASSERT_EQ(((Point *) ArbitraryArray_get_ptr(points, 4321))->x, 4321);
+            ASSERT_EQ(((Point *) ArbitraryArray_get_ptr(points, 17))->z, round);
+            ASSERT_EQ(*(int *) ArbitraryArray_get_ptr(ids, 4999), 4999);
+            arena_reset(arena);
+        }
+        arena_destroy(arena);
+    }
+
+}
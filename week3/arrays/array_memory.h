@@ -0,0 +1,140 @@
+#ifndef _ARRAY_MEMORY
+#define _ARRAY_MEMORY
+
+/*! @file
+ *  Buffer allocation for the array containers: DynamicArray in week 3 and
+ *  DoubleArray and TypedArray in week 4. Each project keeps a copy of this header.
+ *
+ *  Buffers are aligned to 64 bytes, a cache line and a full AVX-512 register.
+ *  Buffers of ARRAY_MEMORY_HUGE_THRESHOLD bytes or more are mapped directly,
+ *  aligned to 2 MB and marked with madvise(MADV_HUGEPAGE), so the kernel can back
+ *  them with huge pages and random access over them takes far fewer TLB misses.
+ *  Those come from the kernel already zeroed, so asking for zeros costs nothing;
+ *  smaller buffers are only cleared when the caller asks.
+ *
+ *  Everything is inline so the header can be shared without a library. Frees and
+ *  reallocations take the size of the buffer, since the two kinds are released
+ *  differently.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/mman.h>
+
+#define ARRAY_MEMORY_ALIGNMENT 64
+#define ARRAY_MEMORY_HUGE_PAGE ((size_t) 2 << 20)
+#define ARRAY_MEMORY_HUGE_THRESHOLD ((size_t) 4 << 20)
+
+static inline int array_memory_is_huge ( size_t bytes ) {
+    return bytes >= ARRAY_MEMORY_HUGE_THRESHOLD;
+}
+
+static inline size_t array_memory_huge_size ( size_t bytes ) {
+    return ( bytes + ARRAY_MEMORY_HUGE_PAGE - 1 ) & ~( ARRAY_MEMORY_HUGE_PAGE - 1 );
+}
+
+/* Reserves size bytes of address space aligned to a huge page */
+static inline char * array_memory_reserve_huge ( size_t size ) {
+    char * base = (char *) mmap(NULL, size + ARRAY_MEMORY_HUGE_PAGE, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if ( base == MAP_FAILED ) {
+        return NULL;
+    }
+    char * aligned = (char *) ( ( (uintptr_t) base + ARRAY_MEMORY_HUGE_PAGE - 1 )
+                                & ~( ARRAY_MEMORY_HUGE_PAGE - 1 ) );
+    if ( aligned > base ) {
+        munmap(base, aligned - base);
+    }
+    if ( base + ARRAY_MEMORY_HUGE_PAGE > aligned ) {
+        munmap(aligned + size, base + ARRAY_MEMORY_HUGE_PAGE - aligned);
+    }
+    return aligned;
+}
+
+/*! Allocates an aligned buffer. Returns NULL if there is no memory.
+ *  \param bytes The size of the buffer
+ *  \param zero Non-zero to clear the buffer, zero if the caller overwrites it anyway
+ */
+static inline void * array_memory_alloc ( size_t bytes, int zero ) {
+    if ( array_memory_is_huge(bytes) ) {
+        size_t size = array_memory_huge_size(bytes);
+        char * p = array_memory_reserve_huge(size);
+        if ( p != NULL ) {
+            madvise(p, size, MADV_HUGEPAGE);
+        }
+        return p;
+    }
+    void * p;
+    if ( posix_memalign(&p, ARRAY_MEMORY_ALIGNMENT, bytes > 0 ? bytes : 1) != 0 ) {
+        return NULL;
+    }
+    if ( zero ) {
+        memset(p, 0, bytes);
+    }
+    return p;
+}
+
+/*! Frees a buffer from array_memory_alloc or array_memory_realloc.
+ *  \param p The buffer, or NULL
+ *  \param bytes The size it was allocated with
+ */
+static inline void array_memory_free ( void * p, size_t bytes ) {
+    if ( p == NULL ) {
+        return;
+    } else if ( array_memory_is_huge(bytes) ) {
+        munmap(p, array_memory_huge_size(bytes));
+    } else {
+        free(p);
+    }
+}
+
+/*! Resizes a buffer, keeping the first min(old_bytes, new_bytes) bytes. Huge
+ *  buffers are remapped without copying. Returns NULL if there is no memory, in
+ *  which case the old buffer is left as it was.
+ *  \param p The buffer
+ *  \param old_bytes Its current size
+ *  \param new_bytes The new size
+ *  \param zero Non-zero to clear the bytes past old_bytes
+ */
+static inline void * array_memory_realloc ( void * p, size_t old_bytes, size_t new_bytes, int zero ) {
+    if ( array_memory_is_huge(old_bytes) && array_memory_is_huge(new_bytes) ) {
+        size_t old_size = array_memory_huge_size(old_bytes),
+               new_size = array_memory_huge_size(new_bytes);
+        if ( new_size <= old_size ) {
+            if ( new_size < old_size ) {
+                munmap((char *) p + new_size, old_size - new_size);
+            }
+            if ( new_bytes < old_bytes ) {
+                /* Keep the slack past the end zero, as it is in a fresh mapping */
+                size_t end = old_bytes < new_size ? old_bytes : new_size;
+                memset((char *) p + new_bytes, 0, end - new_bytes);
+            }
+            return p;
+        }
+        /* Move the pages to an aligned region; the added ones read as zeros */
+        char * q = array_memory_reserve_huge(new_size);
+        if ( q == NULL ) {
+            return NULL;
+        }
+        if ( mremap(p, old_size, new_size, MREMAP_MAYMOVE | MREMAP_FIXED, q) == MAP_FAILED ) {
+            munmap(q, new_size);
+            return NULL;
+        }
+        madvise(q, new_size, MADV_HUGEPAGE);
+        return q;
+    }
+    char * q = (char *) array_memory_alloc(new_bytes, 0);
+    if ( q == NULL ) {
+        return NULL;
+    }
+    size_t kept = old_bytes < new_bytes ? old_bytes : new_bytes;
+    memcpy(q, p, kept);
+    if ( zero && new_bytes > kept && !array_memory_is_huge(new_bytes) ) {
+        memset(q + kept, 0, new_bytes - kept);
+    }
+    array_memory_free(p, old_bytes);
+    return q;
+}
+
+#endif
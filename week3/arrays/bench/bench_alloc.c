@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "array_memory.h"
+#include "dynamic_array.h"
+#include "bench.h"
+
+/* Random gathers over a large buffer, which miss the TLB on almost every load
+ * with 4 KB pages, from plain malloc and from array_memory_alloc, which asks for
+ * huge pages. Also times building a large range, which no longer clears memory
+ * it is about to overwrite.
+ * Usage: bench_alloc [megabytes] [num_gathers]
+ */
+
+/* Kilobytes of the process backed by transparent huge pages */
+static long huge_kb ( void ) {
+    FILE * f = fopen("/proc/self/smaps_rollup", "r");
+    char line[256];
+    long kb = -1;
+    while ( f != NULL && fgets(line, sizeof(line), f) ) {
+        if ( sscanf(line, "AnonHugePages: %ld kB", &kb) == 1 ) {
+            break;
+        }
+    }
+    if ( f != NULL ) {
+        fclose(f);
+    }
+    return kb;
+}
+
+static double gather ( const double * x, size_t n, int count ) {
+    uint64_t state = 88172645463325252ull;
+    double s = 0;
+    for ( int i=0; i<count; i++ ) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        s += x[state % n];
+    }
+    return s;
+}
+
+static void run ( const char * name, double * x, size_t n, int count ) {
+    double t = bench_now();
+    for ( size_t i=0; i<n; i++ ) x[i] = (double) i;
+    double fill = bench_now() - t;
+    t = bench_now();
+    bench_sink = gather(x, n, count);
+    t = bench_now() - t;
+    printf("%-22s fill %8.2f ms  gather %8.2f ms  %6.1f ns/load  huge pages %ld MB\n",
+           name, 1e3 * fill, 1e3 * t, 1e9 * t / count, huge_kb() / 1024);
+}
+
+int main ( int argc, char ** argv ) {
+
+    size_t mb = argc > 1 ? atoi(argv[1]) : 1024,
+           bytes = mb << 20,
+           n = bytes / sizeof(double);
+    int count = argc > 2 ? atoi(argv[2]) : 20000000;
+
+    double * x = (double *) malloc(bytes);
+    run("malloc", x, n, count);
+    free(x);
+
+    x = (double *) array_memory_alloc(bytes, 0);
+    run("array_memory_alloc", x, n, count);
+    array_memory_free(x, bytes);
+
+    int m = (int) ( n < 100000000 ? n : 100000000 );
+    double t = bench_now();
+    DynamicArray * da = DynamicArray_range(0, m - 1, 1);
+    printf("%-22s %8.2f ms for %d elements\n", "DynamicArray_range", 1e3 * (bench_now() - t), m);
+    DynamicArray_destroy(da);
+
+    return 0;
+
+}
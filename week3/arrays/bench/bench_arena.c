@@ -0,0 +1,53 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "dynamic_array.h"
+#include "bench.h"
+
+/* Request-scoped arrays: each request makes a few hundred small arrays, fills
+ * them, and drops them all. With the heap each array is destroyed on its own;
+ * with an arena they are all released by one arena_reset.
+ * Usage: bench_arena [requests] [arrays per request] [elements per array]
+ */
+
+static double run ( Arena * arena, int requests, int arrays, int elements ) {
+    DynamicArray ** das = (DynamicArray **) malloc(arrays * sizeof(DynamicArray *));
+    double sum = 0, t = bench_now();
+    for ( int r=0; r<requests; r++ ) {
+        for ( int a=0; a<arrays; a++ ) {
+            das[a] = arena != NULL ? DynamicArray_new_in(arena) : DynamicArray_new();
+            for ( int i=0; i<elements; i++ ) {
+                DynamicArray_push(das[a], i);
+            }
+            sum += DynamicArray_get(das[a], elements - 1);
+        }
+        if ( arena != NULL ) {
+            arena_reset(arena);
+        } else {
+            for ( int a=0; a<arrays; a++ ) {
+                DynamicArray_destroy(das[a]);
+            }
+        }
+    }
+    t = bench_now() - t;
+    bench_sink = sum;
+    free(das);
+    return t;
+}
+
+int main ( int argc, char ** argv ) {
+
+    int requests = argc > 1 ? atoi(argv[1]) : 10000,
+        arrays = argc > 2 ? atoi(argv[2]) : 200,
+        elements = argc > 3 ? atoi(argv[3]) : 50;
+
+    double heap = run(NULL, requests, arrays, elements);
+    Arena * arena = arena_new(0);
+    double bump = run(arena, requests, arrays, elements);
+    arena_destroy(arena);
+
+    printf("%d requests of %d arrays of %d elements\n", requests, arrays, elements);
+    printf("heap    %8.2f us per request\n", 1e6 * heap / requests);
+    printf("arena   %8.2f us per request\n", 1e6 * bump / requests);
+    return 0;
+
+}
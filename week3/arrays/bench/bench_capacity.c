@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dynamic_array.h"
+#include "bench.h"
+
+/* Push and push_front throughput of the capacity policy, compared with the
+ * original regrowth, which doubled the buffer in a loop and copied each
+ * element through DynamicArray_get, and of the range and concat builders,
+ * compared with building the same arrays by pushing one element at a time.
+ * Usage: bench_capacity [num_elements]
+ */
+
+/* The original implementation, kept here as the baseline *******************/
+
+static void legacy_extend ( DynamicArray * da ) {
+    double * temp = (double *) calloc ( 2 * da->capacity, sizeof(double) );
+    int new_origin = da->capacity - (da->end - da->origin)/2,
+           new_end = new_origin + (da->end - da->origin);
+    for ( int i=0; i<DynamicArray_size(da); i++ ) {
+        temp[new_origin+i] = DynamicArray_get(da,i);
+    }
+    free(da->buffer);
+    da->buffer = temp;
+    da->capacity = 2 * da->capacity;
+    da->origin = new_origin;
+    da->end = new_end;
+}
+
+static void legacy_push ( DynamicArray * da, double value ) {
+    int index = DynamicArray_size(da);
+    while ( index + da->origin >= da->capacity ) {
+        legacy_extend(da);
+    }
+    da->buffer[index + da->origin] = value;
+    da->end = da->origin + index + 1;
+}
+
+static void legacy_push_front ( DynamicArray * da, double value ) {
+    while ( da->origin == 0 ) {
+        legacy_extend(da);
+    }
+    da->origin--;
+    da->buffer[da->origin] = value;
+}
+
+/* Benchmarks ****************************************************************/
+
+static void report ( const char * name, double seconds, int n ) {
+    printf("%-28s %8.2f ms  %8.2f Mpush/s\n", name, 1e3 * seconds, 1e-6 * n / seconds);
+}
+
+int main ( int argc, char ** argv ) {
+
+    int n = argc > 1 ? atoi(argv[1]) : 10000000;
+    DynamicArray * da;
+    double t;
+
+    da = DynamicArray_new();
+    t = bench_now();
+    for ( int i=0; i<n; i++ ) legacy_push(da, i);
+    report("push (original)", bench_now() - t, n);
+    DynamicArray_destroy(da);
+
+    da = DynamicArray_new();
+    t = bench_now();
+    for ( int i=0; i<n; i++ ) DynamicArray_push(da, i);
+    report("push", bench_now() - t, n);
+    DynamicArray_destroy(da);
+
+    da = DynamicArray_new();
+    DynamicArray_set_growth_factor(da, 1.5);
+    t = bench_now();
+    for ( int i=0; i<n; i++ ) DynamicArray_push(da, i);
+    report("push (growth 1.5)", bench_now() - t, n);
+    DynamicArray_destroy(da);
+
+    da = DynamicArray_new();
+    t = bench_now();
+    DynamicArray_reserve(da, n);
+    for ( int i=0; i<n; i++ ) DynamicArray_push(da, i);
+    report("push (reserved)", bench_now() - t, n);
+    DynamicArray_destroy(da);
+
+    da = DynamicArray_new();
+    t = bench_now();
+    for ( int i=0; i<n; i++ ) legacy_push_front(da, i);
+    report("push_front (original)", bench_now() - t, n);
+    DynamicArray_destroy(da);
+
+    da = DynamicArray_new();
+    t = bench_now();
+    for ( int i=0; i<n; i++ ) DynamicArray_push_front(da, i);
+    report("push_front", bench_now() - t, n);
+    DynamicArray_destroy(da);
+
+    da = DynamicArray_new();
+    t = bench_now();
+    for ( int i=0; i<n; i++ ) DynamicArray_push(da, 0.5 * i);
+    report("range by push", bench_now() - t, n);
+    DynamicArray_destroy(da);
+
+    t = bench_now();
+    da = DynamicArray_range(0, 0.5 * (n - 1), 0.5);
+    report("range", bench_now() - t, n);
+
+    DynamicArray * other = DynamicArray_new();
+    t = bench_now();
+    for ( int i=0; i<n; i++ ) DynamicArray_push(other, DynamicArray_get(da, i));
+    for ( int i=0; i<n; i++ ) DynamicArray_push(other, DynamicArray_get(da, i));
+    report("concat by push", bench_now() - t, 2 * n);
+    DynamicArray_destroy(other);
+
+    t = bench_now();
+    other = DynamicArray_concat(da, da);
+    report("concat", bench_now() - t, 2 * n);
+    DynamicArray_destroy(other);
+    DynamicArray_destroy(da);
+
+    da = DynamicArray_new();
+    t = bench_now();
+    DynamicArray_set(da, n - 1, 1.0);
+    printf("%-28s %8.2f ms\n", "set far index", 1e3 * (bench_now() - t));
+    DynamicArray_destroy(da);
+
+    return 0;
+
+}
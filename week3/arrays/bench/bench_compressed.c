@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "dynamic_array.h"
+#include "compressed_array.h"
+#include "bench.h"
+
+/* Size and speed of a CompressedArray holding a slowly varying sensor reading,
+ * against a DynamicArray holding the same values.
+ * Usage: bench_compressed [num_elements]
+ */
+
+static void report ( const char * name, double seconds, int n ) {
+    printf("%-28s %8.2f ms  %8.2f Melem/s\n", name, 1e3 * seconds, 1e-6 * n / seconds);
+}
+
+int main ( int argc, char ** argv ) {
+
+    int n = argc > 1 ? atoi(argv[1]) : 10000000;
+
+    /* A temperature sampled often, changing by a hundredth of a degree now and then */
+    DynamicArray * da = DynamicArray_new();
+    DynamicArray_reserve(da, n);
+    double reading = 20;
+    srand(42);
+    for ( int i=0; i<n; i++ ) {
+        if ( rand() % 8 == 0 ) {
+            reading += ( rand() % 3 - 1 ) / 100.0;
+        }
+        DynamicArray_push(da, reading);
+    }
+
+    CompressedArray * ca = CompressedArray_new();
+    double t = bench_now();
+    for ( int i=0; i<n; i++ ) CompressedArray_push(ca, DynamicArray_get(da, i));
+    report("push", bench_now() - t, n);
+    printf("%-28s %8.2f bytes/value (DynamicArray: %d)\n", "size",
+           (double) CompressedArray_bytes(ca) / n, (int) sizeof(double));
+
+    t = bench_now();
+    CompressedArrayIterator it = CompressedArray_blocks(ca);
+    const double * data;
+    int length;
+    double s = 0;
+    while ( CompressedArrayIterator_next(&it, &data, &length) ) {
+        for ( int i=0; i<length; i++ ) s += data[i];
+    }
+    report("decode (iterator)", bench_now() - t, n);
+    bench_sink = s;
+
+    int lookups = 1000000;
+    t = bench_now();
+    for ( int i=0; i<lookups; i++ ) s += CompressedArray_get(ca, (int) ( (long long) i * 7919 % n ));
+    report("get (random)", bench_now() - t, lookups);
+    t = bench_now();
+    for ( int i=0; i<lookups; i++ ) s += CompressedArray_get(ca, i);
+    report("get (sequential)", bench_now() - t, lookups);
+    bench_sink = s;
+
+    t = bench_now();
+    bench_sink = DynamicArray_sum(da);
+    report("sum (DynamicArray)", bench_now() - t, n);
+    t = bench_now();
+    bench_sink = CompressedArray_sum(ca);
+    report("sum (summaries)", bench_now() - t, n);
+    t = bench_now();
+    CompressedSummary summary = CompressedArray_summarize(ca, n / 3, 2 * n / 3);
+    report("summarize a third", bench_now() - t, n / 3);
+    bench_sink = summary.max;
+
+    CompressedArray_destroy(ca);
+    DynamicArray_destroy(da);
+    return 0;
+
+}
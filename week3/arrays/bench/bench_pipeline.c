@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "dynamic_array.h"
+#include "dynamic_array_pipeline.h"
+#include "bench.h"
+
+/* Three chained maps and a map-reduce, first as separate DynamicArray_map
+ * calls and then through a fused pipeline on 1 to N threads.
+ * Usage: bench_pipeline [num_elements] [max_threads]
+ */
+
+static double scale ( double x ) { return 1.0001 * x; }
+static double shift ( double x ) { return x - 0.5; }
+static double square ( double x ) { return x * x; }
+static double add ( double x, double y ) { return x + y; }
+
+int main ( int argc, char ** argv ) {
+
+    int n = argc > 1 ? atoi(argv[1]) : 10000000,
+        max_threads = argc > 2 ? atoi(argv[2]) : ThreadPool_num_processors();
+
+    DynamicArray * da = DynamicArray_new();
+    DynamicArray_reserve(da, n);
+    for ( int i=0; i<n; i++ ) {
+        DynamicArray_push(da, (double) rand() / RAND_MAX);
+    }
+
+    double t = bench_now();
+    DynamicArray * a = DynamicArray_map(da, scale),
+                 * b = DynamicArray_map(a, shift),
+                 * c = DynamicArray_map(b, square);
+    double separate = bench_now() - t;
+    printf("%-24s %8.2f ms\n", "map x3 (separate)", 1e3 * separate);
+    DynamicArray_destroy(a);
+    DynamicArray_destroy(b);
+    DynamicArray_destroy(c);
+
+    DynamicArrayPipeline * p = DynamicArrayPipeline_new();
+    DynamicArrayPipeline_map(p, scale);
+    DynamicArrayPipeline_map(p, shift);
+    DynamicArrayPipeline_map(p, square);
+
+    printf("%-8s %12s %8s %12s %8s\n", "threads", "apply ms", "speedup", "reduce ms", "speedup");
+    double apply1 = 0, reduce1 = 0;
+    for ( int threads=1; threads<=max_threads; threads++ ) {
+        DynamicArrayPipeline_set_threads(p, threads);
+        t = bench_now();
+        DynamicArray * y = DynamicArrayPipeline_apply(p, da);
+        double apply = bench_now() - t;
+        DynamicArray_destroy(y);
+        t = bench_now();
+        bench_sink = DynamicArrayPipeline_reduce(p, da, add, 0);
+        double reduce = bench_now() - t;
+        if ( threads == 1 ) {
+            apply1 = apply;
+            reduce1 = reduce;
+        }
+        printf("%-8d %12.2f %8.2f %12.2f %8.2f\n",
+               threads, 1e3 * apply, apply1 / apply, 1e3 * reduce, reduce1 / reduce);
+    }
+
+    DynamicArrayPipeline_destroy(p);
+    DynamicArray_destroy(da);
+    return 0;
+
+}
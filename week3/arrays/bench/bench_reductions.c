@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "dynamic_array.h"
+#include "bench.h"
+
+/* Compares each reduction kernel against a loop over DynamicArray_get, and
+ * repeated queries with and without the stats cache.
+ * Usage: bench_reductions [num_elements] [repetitions]
+ */
+
+static const char * level_names[] = { "scalar", "sse2", "avx2", "avx512" };
+
+static double get_loop_sum ( const DynamicArray * da ) {
+    double s = 0;
+    for ( int i=0; i<DynamicArray_size(da); i++ ) {
+        s += DynamicArray_get(da, i);
+    }
+    return s;
+}
+
+static double get_loop_min ( const DynamicArray * da ) {
+    double m = DynamicArray_get(da, 0);
+    for ( int i=1; i<DynamicArray_size(da); i++ ) {
+        if ( DynamicArray_get(da, i) < m ) m = DynamicArray_get(da, i);
+    }
+    return m;
+}
+
+static void report ( const char * name, const char * op, double seconds, int n, int reps ) {
+    printf("%-8s %-4s %8.3f ms  %8.2f Melem/s\n",
+           name, op, 1e3 * seconds / reps, 1e-6 * n * reps / seconds);
+}
+
+int main ( int argc, char ** argv ) {
+
+    int n = argc > 1 ? atoi(argv[1]) : 10000000,
+        reps = argc > 2 ? atoi(argv[2]) : 20;
+
+    DynamicArray * da = DynamicArray_new();
+    for ( int i=0; i<n; i++ ) {
+        DynamicArray_push(da, (double) rand() / RAND_MAX);
+    }
+
+    double t = bench_now();
+    for ( int r=0; r<reps; r++ ) bench_sink = get_loop_sum(da);
+    report("get", "sum", bench_now() - t, n, reps);
+
+    t = bench_now();
+    for ( int r=0; r<reps; r++ ) bench_sink = get_loop_min(da);
+    report("get", "min", bench_now() - t, n, reps);
+
+    DynamicArray_simd_level best = DynamicArray_get_simd_level();
+    for ( int level = DYNAMIC_ARRAY_SCALAR; level <= best; level++ ) {
+        DynamicArray_set_simd_level((DynamicArray_simd_level) level);
+        t = bench_now();
+        for ( int r=0; r<reps; r++ ) bench_sink = DynamicArray_sum(da);
+        report(level_names[level], "sum", bench_now() - t, n, reps);
+        t = bench_now();
+        for ( int r=0; r<reps; r++ ) bench_sink = DynamicArray_min(da);
+        report(level_names[level], "min", bench_now() - t, n, reps);
+        t = bench_now();
+        for ( int r=0; r<reps; r++ ) bench_sink = DynamicArray_max(da);
+        report(level_names[level], "max", bench_now() - t, n, reps);
+    }
+
+    /* A dashboard query loop: a few updates between each round of queries */
+    DynamicArray_cache_stats(da, 1);
+    t = bench_now();
+    for ( int r=0; r<reps; r++ ) {
+        DynamicArray_push(da, 0.5);
+        DynamicArray_set(da, r, 0.25);
+        bench_sink = DynamicArray_sum(da) + DynamicArray_mean(da)
+                   + DynamicArray_min(da) + DynamicArray_max(da);
+    }
+    report("cached", "all", bench_now() - t, n, reps);
+    DynamicArray_cache_stats(da, 0);
+    t = bench_now();
+    for ( int r=0; r<reps; r++ ) {
+        DynamicArray_push(da, 0.5);
+        DynamicArray_set(da, r, 0.25);
+        bench_sink = DynamicArray_sum(da) + DynamicArray_mean(da)
+                   + DynamicArray_min(da) + DynamicArray_max(da);
+    }
+    report("uncached", "all", bench_now() - t, n, reps);
+
+    DynamicArray_destroy(da);
+    return 0;
+
+}
@@ -0,0 +1,41 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "dynamic_array.h"
+#include "thread_pool.h"
+#include "bench.h"
+
+/* Creates and destroys short-lived arrays on 1 to N threads at once.
+ * Usage: bench_registry [arrays_per_thread] [max_threads]
+ */
+
+static int per_thread;
+
+static void * churn ( void * arg ) {
+    for ( int i=0; i<per_thread; i++ ) {
+        DynamicArray * da = DynamicArray_new();
+        DynamicArray_push(da, i);
+        DynamicArray_destroy(da);
+    }
+    return arg;
+}
+
+int main ( int argc, char ** argv ) {
+
+    per_thread = argc > 1 ? atoi(argv[1]) : 1000000;
+    int max_threads = argc > 2 ? atoi(argv[2]) : ThreadPool_num_processors();
+    pthread_t * threads = (pthread_t *) malloc(max_threads * sizeof(pthread_t));
+
+    printf("%-8s %10s %14s\n", "threads", "ms", "Marrays/s");
+    for ( int n=1; n<=max_threads; n++ ) {
+        double t = bench_now();
+        for ( int i=0; i<n; i++ ) pthread_create(&threads[i], NULL, churn, NULL);
+        for ( int i=0; i<n; i++ ) pthread_join(threads[i], NULL);
+        t = bench_now() - t;
+        printf("%-8d %10.2f %14.2f\n", n, 1e3 * t, 1e-6 * per_thread * n / t);
+    }
+
+    free(threads);
+    return 0;
+
+}
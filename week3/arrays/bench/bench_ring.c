@@ -0,0 +1,41 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "dynamic_array.h"
+#include "bench.h"
+
+/* A FIFO queue of bounded length, pushed at the back and popped at the front,
+ * in the usual layout and in ring mode. The usual layout never reuses the
+ * slots freed by pop_front, so its buffer keeps growing with the number of
+ * operations, while the ring stays at the queue length.
+ * Usage: bench_ring [num_operations] [queue_length]
+ */
+
+static void run ( const char * name, int ring, int n, int length ) {
+    DynamicArray * da = DynamicArray_new();
+    DynamicArray_set_ring(da, ring);
+    for ( int i=0; i<length; i++ ) {
+        DynamicArray_push(da, i);
+    }
+    double t = bench_now(), s = 0;
+    for ( int i=0; i<n; i++ ) {
+        DynamicArray_push(da, i);
+        s += DynamicArray_pop_front(da);
+    }
+    t = bench_now() - t;
+    bench_sink = s;
+    printf("%-12s %8.2f ms  %8.2f Mop/s  capacity %d\n",
+           name, 1e3 * t, 1e-6 * n / t, da->capacity);
+    DynamicArray_destroy(da);
+}
+
+int main ( int argc, char ** argv ) {
+
+    int n = argc > 1 ? atoi(argv[1]) : 10000000,
+        length = argc > 2 ? atoi(argv[2]) : 1000;
+
+    run("usual", 0, n, length);
+    run("ring", 1, n, length);
+
+    return 0;
+
+}
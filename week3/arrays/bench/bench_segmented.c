@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "dynamic_array.h"
+#include "segmented_array.h"
+#include "bench.h"
+
+/* Per-push latency percentiles of the contiguous DynamicArray against the
+ * segmented array, pushing one element at a time, plus a sum over each.
+ * Usage: bench_segmented [num_elements]
+ */
+
+static int compare_floats ( const void * a, const void * b ) {
+    float x = *(const float *) a, y = *(const float *) b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static void report ( const char * name, float * ns, int n, double total ) {
+    qsort(ns, n, sizeof(float), compare_floats);
+    printf("%-12s %9.1f %9.1f %9.1f %9.1f %12.1f %10.1f\n", name,
+           ns[n / 2], ns[(int) (n * 0.99)], ns[(int) (n * 0.999)], ns[(int) (n * 0.99999)],
+           ns[n - 1] / 1e3, 1e3 * total);
+}
+
+int main ( int argc, char ** argv ) {
+
+    int n = argc > 1 ? atoi(argv[1]) : 20000000;
+    float * ns = (float *) malloc(n * sizeof(float));
+
+    printf("%-12s %9s %9s %9s %9s %12s %10s\n",
+           "push", "p50 ns", "p99 ns", "p99.9 ns", "p99.999", "max us", "total ms");
+
+    DynamicArray * da = DynamicArray_new();
+    double start = bench_now(), t = start;
+    for ( int i=0; i<n; i++ ) {
+        DynamicArray_push(da, i);
+        double now = bench_now();
+        ns[i] = (float) ( 1e9 * (now - t) );
+        t = now;
+    }
+    report("contiguous", ns, n, t - start);
+
+    SegmentedArray * sa = SegmentedArray_new();
+    start = t = bench_now();
+    for ( int i=0; i<n; i++ ) {
+        SegmentedArray_push(sa, i);
+        double now = bench_now();
+        ns[i] = (float) ( 1e9 * (now - t) );
+        t = now;
+    }
+    report("segmented", ns, n, t - start);
+
+    t = bench_now();
+    bench_sink = DynamicArray_sum(da);
+    printf("sum contiguous %8.2f ms\n", 1e3 * (bench_now() - t));
+    t = bench_now();
+    bench_sink = SegmentedArray_sum(sa);
+    printf("sum segmented  %8.2f ms\n", 1e3 * (bench_now() - t));
+
+    SegmentedArray_destroy(sa);
+    DynamicArray_destroy(da);
+    free(ns);
+    return 0;
+
+}
@@ -0,0 +1,54 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "dynamic_array.h"
+#include "bench.h"
+
+/* Export and import throughput: DynamicArray_to_string against the shortest
+ * round-trip text writer and the binary format, all to /dev/null or a temp file.
+ * Usage: bench_serialize [num_elements]
+ */
+
+static void report ( const char * name, double seconds, int n ) {
+    printf("%-28s %8.2f ms  %8.2f Melem/s\n", name, 1e3 * seconds, 1e-6 * n / seconds);
+}
+
+int main ( int argc, char ** argv ) {
+
+    int n = argc > 1 ? atoi(argv[1]) : 2000000;
+
+    DynamicArray * da = DynamicArray_new();
+    DynamicArray_reserve(da, n);
+    for ( int i=0; i<n; i++ ) {
+        DynamicArray_push(da, (double) rand() / RAND_MAX * 1000);
+    }
+
+    FILE * null = fopen("/dev/null", "w");
+
+    double t = bench_now();
+    char * str = DynamicArray_to_string(da);
+    fputs(str, null);
+    report("to_string + fputs", bench_now() - t, n);
+    free(str);
+
+    t = bench_now();
+    DynamicArray_write(da, null);
+    report("write (shortest text)", bench_now() - t, n);
+
+    FILE * tmp = tmpfile();
+    t = bench_now();
+    DynamicArray_save(da, tmp);
+    fflush(tmp);
+    report("save (binary)", bench_now() - t, n);
+
+    rewind(tmp);
+    t = bench_now();
+    DynamicArray * copy = DynamicArray_load(tmp);
+    report("load (binary)", bench_now() - t, n);
+
+    DynamicArray_destroy(copy);
+    fclose(tmp);
+    fclose(null);
+    DynamicArray_destroy(da);
+    return 0;
+
+}
@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dynamic_array.h"
+#include "bench.h"
+
+/* DynamicArray_sort against copying the elements out and sorting them with
+ * qsort, on random readings, and the sorted-array operations that follow a sort.
+ * Usage: bench_sort [num_elements]
+ */
+
+static int compare_doubles ( const void * a, const void * b ) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static void report ( const char * name, double seconds, int n ) {
+    printf("%-24s %8.2f ms  %8.2f Melem/s\n", name, 1e3 * seconds, 1e-6 * n / seconds);
+}
+
+static DynamicArray * readings ( int n ) {
+    DynamicArray * da = DynamicArray_new();
+    DynamicArray_reserve(da, n);
+    srand(42);
+    for ( int i=0; i<n; i++ ) {
+        /* Readings quantized to 0.01 between -50 and 50, so there are duplicates */
+        DynamicArray_push(da, ( rand() % 10000 - 5000 ) / 100.0);
+    }
+    return da;
+}
+
+int main ( int argc, char ** argv ) {
+
+    int n = argc > 1 ? atoi(argv[1]) : 10000000;
+    DynamicArray * da;
+    double t;
+
+    da = readings(n);
+    t = bench_now();
+    double * x = (double *) malloc(n * sizeof(double));
+    for ( int i=0; i<n; i++ ) x[i] = DynamicArray_get(da, i);
+    qsort(x, n, sizeof(double), compare_doubles);
+    for ( int i=0; i<n; i++ ) DynamicArray_set(da, i, x[i]);
+    report("qsort", bench_now() - t, n);
+    free(x);
+    DynamicArray_destroy(da);
+
+    da = readings(n);
+    t = bench_now();
+    DynamicArray_sort(da);
+    report("DynamicArray_sort", bench_now() - t, n);
+
+    DynamicArray * other = readings(n);
+    DynamicArray_sort(other);
+    t = bench_now();
+    DynamicArray * merged = DynamicArray_merge(da, other);
+    report("DynamicArray_merge", bench_now() - t, 2 * n);
+
+    t = bench_now();
+    int found = 0;
+    for ( int i=0; i<n; i++ ) found += DynamicArray_lower_bound(merged, ( i % 10000 - 5000 ) / 100.0);
+    report("DynamicArray_lower_bound", bench_now() - t, n);
+    bench_sink = found;
+
+    t = bench_now();
+    DynamicArray_unique(merged);
+    report("DynamicArray_unique", bench_now() - t, 2 * n);
+    printf("%d distinct values\n", DynamicArray_size(merged));
+
+    DynamicArray_destroy(merged);
+    DynamicArray_destroy(other);
+    DynamicArray_destroy(da);
+
+    return 0;
+
+}
@@ -0,0 +1,348 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+
+#include "compressed_array.h"
+#include "dynamic_array_simd.h"
+
+#define BLOCK_BITS COMPRESSED_ARRAY_BLOCK_BITS
+#define BLOCK_SIZE COMPRESSED_ARRAY_BLOCK_SIZE
+#define INITIAL_INDEX_CAPACITY 8
+
+/* Worst case per value: two control bits, five bits of leading zeros, six bits
+   of length and 64 bits of value, so under ten bytes */
+#define MAX_BLOCK_BYTES (10 * BLOCK_SIZE)
+
+/* Blocks are padded so the reader can always load eight bytes */
+#define PADDING 8
+
+/* bit streams ***************************************************************/
+
+/* Bits are written most significant first */
+typedef struct {
+    unsigned char * out;
+    int pos;           /* bytes written */
+    uint64_t pending;  /* bits not yet written, fewer than 8 */
+    int num_pending;
+} BitWriter;
+
+typedef struct {
+    const unsigned char * in;
+    size_t pos;        /* bits read */
+} BitReader;
+
+static void put_bits ( BitWriter * w, uint64_t value, int n ) {
+    if ( n > 32 ) {
+        put_bits(w, value >> 32, n - 32);
+        value &= 0xffffffffull;
+        n = 32;
+    }
+    w->pending = (w->pending << n) | value;
+    w->num_pending += n;
+    while ( w->num_pending >= 8 ) {
+        w->num_pending -= 8;
+        w->out[w->pos++] = (unsigned char) ( w->pending >> w->num_pending );
+    }
+    w->pending &= ( (uint64_t) 1 << w->num_pending ) - 1;
+}
+
+static void flush_bits ( BitWriter * w ) {
+    if ( w->num_pending > 0 ) {
+        w->out[w->pos++] = (unsigned char) ( w->pending << (8 - w->num_pending) );
+        w->num_pending = 0;
+        w->pending = 0;
+    }
+}
+
+static inline uint64_t load_big_endian ( const unsigned char * p ) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif
+    return word;
+}
+
+static inline uint64_t get_bits ( BitReader * r, int n ) {
+    if ( n > 56 ) {
+        /* One load only reaches 57 bits past an odd bit position */
+        uint64_t high = get_bits(r, n - 32);
+        return (high << 32) | get_bits(r, 32);
+    }
+    uint64_t word = load_big_endian(r->in + (r->pos >> 3)) << (r->pos & 7);
+    r->pos += n;
+    return n == 0 ? 0 : word >> (64 - n);
+}
+
+static inline uint64_t to_bits ( double x ) {
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    return bits;
+}
+
+static inline double from_bits ( uint64_t bits ) {
+    double x;
+    memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+/* blocks ********************************************************************/
+
+static const DynamicArrayKernels * kernels ( void ) {
+    return dynamic_array_kernels(DynamicArray_get_simd_level());
+}
+
+static CompressedSummary empty_summary ( void ) {
+    CompressedSummary s = { 0, INFINITY, -INFINITY, 0 };
+    return s;
+}
+
+static void add_summary ( CompressedSummary * s, const CompressedSummary * t ) {
+    s->count += t->count;
+    s->sum += t->sum;
+    if ( t->min < s->min || isnan(t->min) ) s->min = t->min;
+    if ( t->max > s->max || isnan(t->max) ) s->max = t->max;
+}
+
+static void add_values ( CompressedSummary * s, const double * x, int n ) {
+    if ( n > 0 ) {
+        const DynamicArrayKernels * k = kernels();
+        CompressedSummary t = { n, k->min(x, n), k->max(x, n), k->sum(x, n) };
+        add_summary(s, &t);
+    }
+}
+
+/* Encodes n values. Each value after the first is XORed with the one before.
+   A zero XOR is written as the bit 0. Otherwise the bits 10 mean the nonzero
+   bits fit in the window of leading and trailing zeros of the last value
+   written with 11, and only the bits in that window follow; the bits 11 are
+   followed by a new window, as five bits of leading zeros and six of length,
+   and then the bits in it. */
+static void encode ( const double * x, int n, CompressedBlock * block ) {
+
+    unsigned char scratch[MAX_BLOCK_BYTES];
+    BitWriter w = { scratch, 0, 0, 0 };
+    uint64_t previous = to_bits(x[0]);
+    int leading = -1,
+        trailing = 0;
+
+    put_bits(&w, previous, 64);
+    for ( int i=1; i<n; i++ ) {
+        uint64_t bits = to_bits(x[i]),
+                 delta = bits ^ previous;
+        if ( delta == 0 ) {
+            put_bits(&w, 0, 1);
+        } else {
+            int l = __builtin_clzll(delta),
+                t = __builtin_ctzll(delta);
+            if ( l > 31 ) {
+                l = 31;
+            }
+            if ( leading >= 0 && l >= leading && t >= trailing ) {
+                put_bits(&w, 2, 2);
+                put_bits(&w, delta >> trailing, 64 - leading - trailing);
+            } else {
+                int length = 64 - l - t;
+                leading = l;
+                trailing = t;
+                put_bits(&w, 3, 2);
+                put_bits(&w, l, 5);
+                put_bits(&w, length & 63, 6);
+                put_bits(&w, delta >> t, length);
+            }
+        }
+        previous = bits;
+    }
+    flush_bits(&w);
+
+    block->num_bytes = w.pos;
+    block->bits = (unsigned char *) malloc(w.pos + PADDING);
+    memcpy(block->bits, scratch, w.pos);
+    memset(block->bits + w.pos, 0, PADDING);
+
+}
+
+static void decode ( const CompressedBlock * block, double * out ) {
+
+    BitReader r = { block->bits, 0 };
+    int n = block->summary.count,
+        leading = 0,
+        trailing = 0;
+    uint64_t bits = get_bits(&r, 64);
+
+    out[0] = from_bits(bits);
+    for ( int i=1; i<n; i++ ) {
+        if ( get_bits(&r, 1) ) {
+            if ( get_bits(&r, 1) ) {
+                leading = (int) get_bits(&r, 5);
+                int length = (int) get_bits(&r, 6);
+                trailing = 64 - leading - ( length == 0 ? 64 : length );
+            }
+            bits ^= get_bits(&r, 64 - leading - trailing) << trailing;
+        }
+        out[i] = from_bits(bits);
+    }
+
+}
+
+/* Moves the full tail into a new block */
+static void seal_tail ( CompressedArray * ca ) {
+    if ( ca->num_blocks == ca->blocks_capacity ) {
+        ca->blocks_capacity *= 2;
+        ca->blocks = (CompressedBlock *) realloc(ca->blocks, ca->blocks_capacity * sizeof(CompressedBlock));
+    }
+    CompressedBlock * block = ca->blocks + ca->num_blocks++;
+    block->summary = empty_summary();
+    add_values(&block->summary, ca->tail, ca->tail_size);
+    encode(ca->tail, ca->tail_size, block);
+    ca->tail_size = 0;
+}
+
+/* The values of encoded block b, decoded through the cache */
+static const double * cached_block ( const CompressedArray * ca, int b ) {
+    if ( ca->cache->block != b ) {
+        decode(ca->blocks + b, ca->cache->values);
+        ca->cache->block = b;
+    }
+    return ca->cache->values;
+}
+
+/* public functions **********************************************************/
+
+CompressedArray * CompressedArray_new(void) {
+    CompressedArray * ca = (CompressedArray *) malloc(sizeof(CompressedArray));
+    ca->blocks_capacity = INITIAL_INDEX_CAPACITY;
+    ca->blocks = (CompressedBlock *) malloc(ca->blocks_capacity * sizeof(CompressedBlock));
+    ca->num_blocks = 0;
+    ca->tail = (double *) malloc(BLOCK_SIZE * sizeof(double));
+    ca->tail_size = 0;
+    ca->cache = (CompressedArrayCache *) malloc(sizeof(CompressedArrayCache));
+    ca->cache->block = -1;
+    return ca;
+}
+
+void CompressedArray_destroy(CompressedArray * ca) {
+    for ( int b=0; b<ca->num_blocks; b++ ) {
+        free(ca->blocks[b].bits);
+    }
+    free(ca->blocks);
+    free(ca->tail);
+    free(ca->cache);
+    free(ca);
+}
+
+int CompressedArray_size(const CompressedArray * ca) {
+    return ca->num_blocks * BLOCK_SIZE + ca->tail_size;
+}
+
+size_t CompressedArray_bytes(const CompressedArray * ca) {
+    size_t bytes = ca->tail_size * sizeof(double);
+    for ( int b=0; b<ca->num_blocks; b++ ) {
+        bytes += ca->blocks[b].num_bytes;
+    }
+    return bytes;
+}
+
+double CompressedArray_get(const CompressedArray * ca, int index) {
+    assert(index >= 0);
+    int b = index >> BLOCK_BITS;
+    if ( index >= CompressedArray_size(ca) ) {
+        return 0;
+    } else if ( b == ca->num_blocks ) {
+        return ca->tail[index & (BLOCK_SIZE - 1)];
+    } else {
+        return cached_block(ca, b)[index & (BLOCK_SIZE - 1)];
+    }
+}
+
+void CompressedArray_push(CompressedArray * ca, double value) {
+    ca->tail[ca->tail_size++] = value;
+    if ( ca->tail_size == BLOCK_SIZE ) {
+        seal_tail(ca);
+    }
+}
+
+void CompressedArray_push_array(CompressedArray * ca, const DynamicArray * da) {
+    const double * x = da->buffer + da->origin;
+    int n = DynamicArray_size(da);
+    while ( n > 0 ) {
+        int room = BLOCK_SIZE - ca->tail_size,
+            m = n < room ? n : room;
+        memcpy(ca->tail + ca->tail_size, x, m * sizeof(double));
+        ca->tail_size += m;
+        if ( ca->tail_size == BLOCK_SIZE ) {
+            seal_tail(ca);
+        }
+        x += m;
+        n -= m;
+    }
+}
+
+CompressedArrayIterator CompressedArray_blocks(const CompressedArray * ca) {
+    CompressedArrayIterator it;
+    it.array = ca;
+    it.next = 0;
+    return it;
+}
+
+int CompressedArrayIterator_next(CompressedArrayIterator * it, const double ** data, int * length) {
+    const CompressedArray * ca = it->array;
+    if ( it->next < ca->num_blocks ) {
+        const CompressedBlock * block = ca->blocks + it->next++;
+        decode(block, it->values);
+        *data = it->values;
+        *length = block->summary.count;
+        return 1;
+    } else if ( it->next == ca->num_blocks && ca->tail_size > 0 ) {
+        it->next++;
+        *data = ca->tail;
+        *length = ca->tail_size;
+        return 1;
+    } else {
+        return 0;
+    }
+}
+
+CompressedSummary CompressedArray_summarize(const CompressedArray * ca, int a, int b) {
+    assert(a >= 0);
+    int size = CompressedArray_size(ca);
+    CompressedSummary s = empty_summary();
+    if ( b > size ) {
+        b = size;
+    }
+    while ( a < b ) {
+        int block = a >> BLOCK_BITS,
+            lo = a & (BLOCK_SIZE - 1),
+            hi = b - (block << BLOCK_BITS) < BLOCK_SIZE ? b - (block << BLOCK_BITS) : BLOCK_SIZE;
+        if ( block == ca->num_blocks ) {
+            add_values(&s, ca->tail + lo, hi - lo);
+        } else if ( lo == 0 && hi == BLOCK_SIZE ) {
+            add_summary(&s, &ca->blocks[block].summary);
+        } else {
+            add_values(&s, cached_block(ca, block) + lo, hi - lo);
+        }
+        a = (block << BLOCK_BITS) + hi;
+    }
+    return s;
+}
+
+double CompressedArray_min(const CompressedArray * ca) {
+    assert(CompressedArray_size(ca) > 0);
+    return CompressedArray_summarize(ca, 0, CompressedArray_size(ca)).min;
+}
+
+double CompressedArray_max(const CompressedArray * ca) {
+    assert(CompressedArray_size(ca) > 0);
+    return CompressedArray_summarize(ca, 0, CompressedArray_size(ca)).max;
+}
+
+double CompressedArray_sum(const CompressedArray * ca) {
+    return CompressedArray_summarize(ca, 0, CompressedArray_size(ca)).sum;
+}
+
+double CompressedArray_mean(const CompressedArray * ca) {
+    assert(CompressedArray_size(ca) > 0);
+    return CompressedArray_sum(ca) / CompressedArray_size(ca);
+}
@@ -0,0 +1,114 @@
+#ifndef _COMPRESSED_ARRAY
+#define _COMPRESSED_ARRAY
+
+#include "dynamic_array.h"
+
+/*! @file
+ *  An append-only array of doubles stored in compressed blocks, for long series
+ *  of slowly varying values such as sensor readings. Each value is stored as the
+ *  XOR of its bits with the previous value's, as in Facebook's Gorilla time series
+ *  database: a repeated value takes one bit, and a value that shares its sign,
+ *  exponent and high mantissa bits with the previous one takes only the bits that
+ *  differ. Values are appended to an uncompressed tail, which is encoded as a block
+ *  once it holds COMPRESSED_ARRAY_BLOCK_SIZE values.
+ *
+ *  Every block keeps the count, min, max and sum of its values, so the aggregate
+ *  functions only decode the blocks a range covers partially.
+ */
+
+#define COMPRESSED_ARRAY_BLOCK_BITS 10
+#define COMPRESSED_ARRAY_BLOCK_SIZE (1 << COMPRESSED_ARRAY_BLOCK_BITS) /* values per block */
+
+/* The aggregates of a run of values */
+typedef struct {
+    int count;
+    double min,
+           max,
+           sum;
+} CompressedSummary;
+
+typedef struct {
+    unsigned char * bits;      /* the encoded values */
+    int num_bytes;
+    CompressedSummary summary;
+} CompressedBlock;
+
+/* The block most recently decoded by CompressedArray_get */
+typedef struct {
+    int block;
+    double values[COMPRESSED_ARRAY_BLOCK_SIZE];
+} CompressedArrayCache;
+
+typedef struct {
+    CompressedBlock * blocks;  /* the block index */
+    int num_blocks,
+        blocks_capacity;
+    double * tail;             /* values not yet encoded, fewer than a block */
+    int tail_size;
+    CompressedArrayCache * cache;
+} CompressedArray;
+
+/*! Decodes the values a block at a time. The iterator holds the decoded block, so
+ *  each run can be processed with contiguous (e.g. vectorized) loops.
+ */
+typedef struct {
+    const CompressedArray * array;
+    int next;                  /* the next block, the tail coming after the encoded ones */
+    double values[COMPRESSED_ARRAY_BLOCK_SIZE];
+} CompressedArrayIterator;
+
+/* Constructors / Destructors ************************************************/
+
+CompressedArray * CompressedArray_new(void);
+void CompressedArray_destroy(CompressedArray *);
+
+/* Getters / Setters *********************************************************/
+
+/*! Returns the value at index, or 0 if index is past the end. Finds the block through
+ *  the block index and decodes it, keeping the most recent block decoded, so reading
+ *  nearby values in turn is cheap. Because of that cache, concurrent calls on the same
+ *  array are not safe.
+ */
+double CompressedArray_get(const CompressedArray *, int index);
+
+int CompressedArray_size(const CompressedArray *);
+
+/*! Returns the number of bytes taken by the values, encoded and not
+ */
+size_t CompressedArray_bytes(const CompressedArray *);
+
+/* Operations ****************************************************************/
+
+void CompressedArray_push(CompressedArray *, double);
+
+/*! Appends every element of a DynamicArray
+ */
+void CompressedArray_push_array(CompressedArray *, const DynamicArray *);
+
+/*! Returns an iterator positioned before the first block.
+ */
+CompressedArrayIterator CompressedArray_blocks(const CompressedArray *);
+
+/*! Decodes the next block. Returns 1 and sets data and length if there is one, and
+ *  0 at the end. The data stays valid until the next call.
+ *  \param it The iterator
+ *  \param data Receives the address of the decoded values
+ *  \param length Receives the number of values
+ */
+int CompressedArrayIterator_next(CompressedArrayIterator * it, const double ** data, int * length);
+
+/*! Returns the aggregates of the values with indices in [a,b), clamped to the array.
+ *  Blocks wholly inside the range are answered from their summaries without decoding.
+ *  \param a The first index
+ *  \param b One past the last index
+ */
+CompressedSummary CompressedArray_summarize(const CompressedArray *, int a, int b);
+
+/*! Reductions over the whole array, computed from the block summaries
+ */
+double CompressedArray_min(const CompressedArray *);
+double CompressedArray_max(const CompressedArray *);
+double CompressedArray_sum(const CompressedArray *);
+double CompressedArray_mean(const CompressedArray *);
+
+#endif
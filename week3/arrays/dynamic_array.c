@@ -1,8 +1,18 @@
 #include "dynamic_array.h"
+#include "dynamic_array_simd.h"
+#include "dynamic_array_select.h"
+#include "dynamic_array_sort.h"
+#include "dynamic_array_mapped.h"
+#include "dynamic_array_registry.h"
+#include "dynamic_array_ring.h"
+#include "array_memory.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
 
 /* private functions *********************************************************/
 
@@ -16,50 +26,366 @@ static int offset_to_index ( const DynamicArray * da, int offset ) {
     return offset - da->origin;
 }
 
-/* Non-zero if and only if offset lies ouside the buffer */
-static int out_of_buffer ( DynamicArray * da, int offset ) {
-    return offset < 0 || offset >= da->capacity;
+/* Free slots after the last element. In ring mode the free slots before the
+   first element are reached by wrapping around, so they count too. */
+static int back_room ( const DynamicArray * da ) {
+    return da->ring ? da->capacity - DynamicArray_size(da) : da->capacity - da->end;
 }
 
-/* Makes a new buffer that is twice the size of the old buffer,
-   copies the old information into the new buffer, and deletes
-   the old buffer */
-static void extend_buffer ( DynamicArray * da ) {
+/* Free slots before the first element */
+static int front_room ( const DynamicArray * da ) {
+    return da->ring ? da->capacity - DynamicArray_size(da) : da->origin;
+}
 
-    double * temp = (double *) calloc ( 2 * da->capacity, sizeof(double) );
-    int new_origin = da->capacity - (da->end - da->origin)/2,
-           new_end = new_origin + (da->end - da->origin);
+/* Allocates a zeroed buffer of the same kind as da's, updating capacity if
+   ring buffers round it up. Returns NULL with errno set if a ring buffer
+   cannot be mapped. */
+static double * alloc_buffer ( const DynamicArray * da, int * capacity ) {
+    if ( da->ring ) {
+        return dynamic_array_ring_alloc(capacity);
+    } else if ( da->arena != NULL ) {
+        return (double *) arena_calloc ( da->arena, *capacity * sizeof(double) );
+    } else {
+        return (double *) array_memory_alloc ( *capacity * sizeof(double), 1 );
+    }
+}
 
-    for ( int i=0; i<DynamicArray_size(da); i++ ) {
-        temp[new_origin+i] = DynamicArray_get(da,i);
+/* Allocates a buffer of the same kind as da's, not in ring mode, without clearing it */
+static double * alloc_uninitialized ( const DynamicArray * da, int capacity ) {
+    if ( da->arena != NULL ) {
+        return (double *) arena_alloc ( da->arena, capacity * sizeof(double) );
+    } else {
+        return (double *) array_memory_alloc ( capacity * sizeof(double), 0 );
+    }
+}
+
+static void free_buffer ( const DynamicArray * da, double * buffer, int capacity, int ring ) {
+    if ( ring ) {
+        dynamic_array_ring_free(buffer, capacity);
+    } else if ( da->arena != NULL ) {
+        arena_free(da->arena, buffer);
+    } else {
+        array_memory_free(buffer, capacity * sizeof(double));
+    }
+}
+
+/* Small allocations that belong to the array, the shared reference count and
+   the cached stats, come from its arena if it has one */
+static void * alloc_small ( const DynamicArray * da, size_t bytes ) {
+    return da->arena != NULL ? arena_calloc(da->arena, bytes) : calloc(1, bytes);
+}
+
+static void free_small ( const DynamicArray * da, void * p ) {
+    if ( da->arena == NULL ) {
+        free(p);
+    }
+}
+
+/* Moves the elements into a buffer of the given capacity, starting at
+   new_origin. Slots past the end are zero, as DynamicArray_set relies on.
+   When the origin does not move the buffer is resized in place, otherwise the
+   elements are moved with a single memcpy and only the rest is cleared.
+   Returns 0, or -1 with errno set if there is no memory, a mapped file cannot
+   be resized or a ring buffer cannot be mapped, in which case the array keeps
+   its elements. */
+static int resize_buffer ( DynamicArray * da, int capacity, int new_origin ) {
+
+    int size = DynamicArray_size(da);
+    assert(da->refcount == NULL);
+    assert(new_origin + size <= capacity || ( da->ring && new_origin < capacity ));
+
+    if ( da->fd >= 0 ) {
+        return dynamic_array_mapped_resize(da, capacity, new_origin);
     }
 
-    free(da->buffer);
-    da->buffer = temp;
+    if ( new_origin == da->origin && !da->ring && da->arena != NULL ) {
+        /* Grows in place when the buffer is the arena's most recent allocation */
+        da->buffer = (double *) arena_realloc(da->arena, da->buffer, da->capacity * sizeof(double),
+                                              capacity * sizeof(double));
+        if ( capacity > da->end ) {
+            memset(da->buffer + da->end, 0, (capacity - da->end) * sizeof(double));
+        }
+    } else if ( new_origin == da->origin && !da->ring ) {
+        double * temp = (double *) array_memory_realloc(da->buffer, da->capacity * sizeof(double),
+                                                        capacity * sizeof(double), 1);
+        if ( temp == NULL ) {
+            errno = ENOMEM;
+            return -1;
+        }
+        da->buffer = temp;
+    } else if ( !da->ring ) {
+        double * temp = alloc_uninitialized(da, capacity);
+        if ( temp == NULL ) {
+            errno = ENOMEM;
+            return -1;
+        }
+        memset(temp, 0, new_origin * sizeof(double));
+        memcpy(temp + new_origin, da->buffer + da->origin, size * sizeof(double));
+        memset(temp + new_origin + size, 0, (capacity - new_origin - size) * sizeof(double));
+        free_buffer(da, da->buffer, da->capacity, da->ring);
+        da->buffer = temp;
+    } else {
+        double * temp = alloc_buffer(da, &capacity);
+        if ( temp == NULL ) {
+            return -1;
+        }
+        memcpy(temp + new_origin, da->buffer + da->origin, size * sizeof(double));
+        free_buffer(da, da->buffer, da->capacity, da->ring);
+        da->buffer = temp;
+    }
 
-    da->capacity = 2 * da->capacity;
+    da->capacity = capacity;
     da->origin = new_origin;
-    da->end = new_end;
+    da->end = new_origin + size;
+    return 0;
+
+}
+
+/* Grows the buffer so that there are at least 'front' free slots before the
+   first element and 'back' free slots after the last one. The new capacity is
+   computed once, as the larger of what is needed and the current capacity
+   times the growth factor, so a far index costs a single regrowth. The
+   product is taken in double and clamped, as it can pass INT_MAX. Returns 0,
+   or -1 with errno set if the buffer cannot grow, leaving the array
+   unchanged. */
+static int grow_buffer ( DynamicArray * da, int front, int back ) {
+
+    if ( da->ring ? front + back <= back_room(da)
+                  : front <= front_room(da) && back <= back_room(da) ) {
+        return 0;
+    }
+
+    double scaled = da->capacity * da->growth_factor;
+    int grown = scaled < INT_MAX ? (int) scaled : INT_MAX;
+    if ( grown <= da->capacity && da->capacity < INT_MAX ) {
+        grown = da->capacity + 1;
+    }
+
+    if ( da->ring ) {
+        /* Any origin works for a ring; the front wraps around to the back */
+        int needed = front + DynamicArray_size(da) + back;
+        return resize_buffer(da, grown > needed ? grown : needed, 0);
+    } else if ( da->origin >= front ) {
+        /* Only the back needs room, so keep the origin and grow in place */
+        int needed = da->end + back;
+        return resize_buffer(da, grown > needed ? grown : needed, da->origin);
+    } else {
+        /* Split the spare room evenly between the two ends */
+        int needed = front + DynamicArray_size(da) + back,
+            capacity = grown > needed ? grown : needed;
+        return resize_buffer(da, capacity, front + (capacity - needed) / 2);
+    }
+
+}
+
+/* Gives the array a buffer of its own before it writes to one that other
+   arrays can see. If the other sharers are gone the buffer is taken over,
+   clearing the slots past the end that they may have filled; otherwise the
+   elements are copied. */
+static void unshare ( DynamicArray * da ) {
+
+    if ( da->refcount == NULL ) {
+        return;
+    }
+
+    if ( *da->refcount == 1 ) {
+        free_small(da, da->refcount);
+        memset(da->buffer + da->end, 0, back_room(da) * sizeof(double));
+    } else {
+        (*da->refcount)--;
+        double * temp = alloc_buffer(da, &da->capacity);
+        if ( temp != NULL ) {
+            memcpy(temp + da->origin, da->buffer + da->origin, DynamicArray_size(da) * sizeof(double));
+        } else {
+            /* No ring buffer could be mapped, so continue with a plain one */
+            int size = DynamicArray_size(da);
+            da->ring = 0;
+            temp = alloc_buffer(da, &da->capacity);
+            memcpy(temp, da->buffer + da->origin, size * sizeof(double));
+            da->origin = 0;
+            da->end = size;
+        }
+        da->buffer = temp;
+    }
+
+    da->refcount = NULL;
+    da->is_view = 0;
+
+}
+
+/* Non-zero if writing the element at index requires a private buffer.
+   Views never write to a shared buffer. The array that owns it may still
+   append within its capacity, since every view ends at or before its end. */
+static int write_needs_copy ( const DynamicArray * da, int index ) {
+    int size = DynamicArray_size(da);
+    return da->refcount != NULL &&
+           ( da->is_view || index < size || index >= size + back_room(da) );
+}
+
+/* Takes a header from the arena, or from the registry if arena is NULL, with no buffer */
+static DynamicArray * new_header ( Arena * arena ) {
+    DynamicArray * da = arena != NULL ? (DynamicArray *) arena_alloc(arena, sizeof(DynamicArray))
+                                      : dynamic_array_header_alloc();
+    da->growth_factor = DYNAMIC_ARRAY_GROWTH_FACTOR;
+    da->refcount = NULL;
+    da->is_view = 0;
+    da->ring = 0;
+    da->fd = -1;
+    da->stats = NULL;
+    da->arena = arena;
+    return da;
+}
+
+/* Reduction kernels, chosen on first use from the CPU's features */
+static DynamicArray_simd_level simd_level = DYNAMIC_ARRAY_SCALAR;
+static const DynamicArrayKernels * kernels = NULL;
+
+static const DynamicArrayKernels * get_kernels ( void ) {
+    if ( kernels == NULL ) {
+        simd_level = dynamic_array_best_simd_level();
+        kernels = dynamic_array_kernels(simd_level);
+    }
+    return kernels;
+}
 
-    return;
+/* Copies the elements of the array into a newly allocated scratch buffer */
+static double * scratch_copy ( const DynamicArray * da ) {
+    int n = DynamicArray_size(da);
+    double * x = (double *) malloc(n * sizeof(double));
+    memcpy(x, da->buffer + da->origin, n * sizeof(double));
+    return x;
+}
+
+/* Splits the fractional rank q*(n-1) into an integer rank and a remainder */
+static int quantile_rank ( int n, double q, double * frac ) {
+    double pos = q * (n - 1);
+    int k = (int) floor(pos);
+    if ( k >= n - 1 ) {
+        k = n - 1;
+    }
+    *frac = pos - k;
+    return k;
+}
+
+/* Cached statistics. Each value is either up to date or marked missing. */
+
+static void stats_add ( DynamicArray * da, double value ) {
+    DynamicArrayStats * s = da->stats;
+    if ( s == NULL ) {
+        return;
+    }
+    if ( isnan(value) ) {
+        s->has_sum = s->has_min = s->has_max = 0;
+        return;
+    }
+    s->sum += value;
+    if ( value < s->min ) s->min = value;
+    if ( value > s->max ) s->max = value;
+}
+
+static void stats_remove ( DynamicArray * da, double value ) {
+    DynamicArrayStats * s = da->stats;
+    if ( s == NULL ) {
+        return;
+    }
+    if ( isfinite(value) ) {
+        s->sum -= value;
+    } else {
+        /* Subtracting an infinity would leave a NaN */
+        s->has_sum = 0;
+    }
+    if ( value <= s->min ) s->has_min = 0;
+    if ( value >= s->max ) s->has_max = 0;
+}
 
+static int compare_ints ( const void * a, const void * b ) {
+    return *(const int *) a - *(const int *) b;
+}
+
+/* Lets go of the array's buffer: closes a mapping, frees a private buffer, or
+   drops one reference to a shared one. The header is left as it is. */
+static void release_buffer ( DynamicArray * da ) {
+    if ( da->fd >= 0 ) {
+        dynamic_array_mapped_close(da);
+    } else if ( da->refcount == NULL ) {
+        free_buffer(da, da->buffer, da->capacity, da->ring);
+    } else if ( --(*da->refcount) == 0 ) {
+        free_small(da, da->refcount);
+        free_buffer(da, da->buffer, da->capacity, da->ring);
+    }
+    da->refcount = NULL;
+    da->buffer = NULL;
+}
+
+/* A new array of n elements in a buffer of exactly that size, for builders
+   that know the size up front and write every element. The elements are not
+   initialized. */
+static DynamicArray * new_exact ( int n ) {
+    DynamicArray * da = new_header(NULL);
+    if ( n > 0 ) {
+        da->capacity = n;
+        da->buffer = (double *) array_memory_alloc ( n * sizeof(double), 0 );
+    } else {
+        da->capacity = 1;
+        da->buffer = (double *) array_memory_alloc ( sizeof(double), 1 );
+    }
+    da->origin = 0;
+    da->end = n;
+    return da;
 }
 
 /* public functions **********************************************************/
 
 DynamicArray * DynamicArray_new(void) {
-    DynamicArray * da = (DynamicArray *) malloc(sizeof(DynamicArray));
-    da->capacity = DYNAMIC_ARRAY_INITIAL_CAPACITY;    
-    da->buffer = (double *) calloc ( da->capacity, sizeof(double) ); 
+    DynamicArray * da = new_header(NULL);
+    da->capacity = DYNAMIC_ARRAY_INITIAL_CAPACITY;
+    da->buffer = (double *) array_memory_alloc ( da->capacity * sizeof(double), 1 );
+    da->origin = da->capacity / 2;
+    da->end = da->origin;
+    return da;
+}
+
+int DynamicArray_reserve(DynamicArray * da, int n) {
+    assert(da->buffer != NULL);
+    unshare(da);
+    if ( da->ring && da->capacity < n ) {
+        return resize_buffer(da, n, 0);
+    } else if ( !da->ring && da->capacity - da->origin < n ) {
+        return resize_buffer(da, da->origin + n, da->origin);
+    }
+    return 0;
+}
+
+int DynamicArray_shrink_to_fit(DynamicArray * da) {
+    assert(da->buffer != NULL);
+    unshare(da);
+    int size = DynamicArray_size(da);
+    return resize_buffer(da, size > 0 ? size : 1, 0);
+}
+
+void DynamicArray_set_growth_factor(DynamicArray * da, double factor) {
+    assert(factor > 1);
+    da->growth_factor = factor;
+}
+
+DynamicArray * DynamicArray_new_in(Arena * arena) {
+    assert(arena != NULL);
+    DynamicArray * da = new_header(arena);
+    da->capacity = DYNAMIC_ARRAY_INITIAL_CAPACITY;
+    da->buffer = alloc_buffer(da, &da->capacity);
     da->origin = da->capacity / 2;
     da->end = da->origin;
     return da;
 }
 
 void DynamicArray_destroy(DynamicArray * da) {
-    free(da->buffer);
-    da->buffer = NULL;
-    return;
+    assert(da->buffer != NULL);
+    release_buffer(da);
+    free_small(da, da->stats);
+    da->stats = NULL;
+    if ( da->arena == NULL ) {
+        dynamic_array_header_free(da);
+    }
 }
 
 int DynamicArray_size(const DynamicArray * da) {
@@ -69,26 +395,31 @@ int DynamicArray_size(const DynamicArray * da) {
 
 char * DynamicArray_to_string(const DynamicArray * da) {
     assert(da->buffer != NULL);
-    char * str = (char *) calloc (20,DynamicArray_size(da)),
-         temp[20];
-    int j = 1;
-    str[0] = '[';
-    for ( int i=0; i < DynamicArray_size(da); i++ ) {
-        if ( DynamicArray_get(da,i) == 0 ) {
-            snprintf ( temp, 20, "0" );
-        } else {
-            snprintf ( temp, 20, "%.5lf", DynamicArray_get(da,i) ); 
+    /* "%.5lf" of the largest doubles runs past 300 characters, so the
+       string grows whenever fewer than that many are left */
+    const int longest = 320;
+    const double * x = da->buffer + da->origin;
+    int n = DynamicArray_size(da);
+    size_t capacity = 12 * (size_t) n + longest + 3,
+           j = 0;
+    char * str = (char *) malloc(capacity);
+    str[j++] = '[';
+    for ( int i=0; i < n; i++ ) {
+        if ( capacity - j < (size_t) longest + 3 ) {
+            capacity = 2 * capacity;
+            str = (char *) realloc(str, capacity);
         }
-        if ( i < DynamicArray_size(da) - 1 ) {
-            sprintf( str + j, "%s,", temp);
-            j += strlen(temp) + 1;
+        if ( x[i] == 0 ) {
+            str[j++] = '0';
         } else {
-            sprintf( str + j, "%s", temp);
-            j += strlen(temp);
+            j += snprintf(str + j, capacity - j, "%.5lf", x[i]);
+        }
+        if ( i < n - 1 ) {
+            str[j++] = ',';
         }
-
     }
-    str[j] = ']';
+    str[j++] = ']';
+    str[j] = '\0';
     return str;
 }
 
@@ -106,17 +437,37 @@ void DynamicArray_print_debug_info(const DynamicArray * da) {
 
 }
 
-void DynamicArray_set(DynamicArray * da, int index, double value) {
-    assert(da->buffer != NULL);
-    assert ( index >= 0 );
-    while ( out_of_buffer(da, index_to_offset(da, index) ) ) {
-        extend_buffer(da);
+/* Writes an element, as DynamicArray_set does, without touching the stats.
+   Returns -1, writing nothing, if a mapped file cannot grow to hold it. */
+static int set_element(DynamicArray * da, int index, double value) {
+    if ( write_needs_copy(da, index) ) {
+        unshare(da);
+    }
+    if ( index >= DynamicArray_size(da) + back_room(da)
+         && grow_buffer(da, 0, index + 1 - DynamicArray_size(da)) != 0 ) {
+        return -1;
     }
     da->buffer[index_to_offset(da, index)] = value;
     if ( index >= DynamicArray_size(da) ) {
         da->end = index_to_offset(da,index+1);
     }
+    return 0;
+}
 
+void DynamicArray_set(DynamicArray * da, int index, double value) {
+    assert(da->buffer != NULL);
+    assert ( index >= 0 );
+    int size = DynamicArray_size(da);
+    double old = index < size ? da->buffer[index_to_offset(da, index)] : 0.0;
+    if ( set_element(da, index, value) != 0 ) {
+        return;
+    }
+    if ( index < size ) {
+        stats_remove(da, old);
+    } else if ( index > size ) {
+        stats_add(da, 0.0); /* the zeros in between */
+    }
+    stats_add(da, value);
 }
 
 double DynamicArray_get(const DynamicArray * da, int index) {
@@ -135,17 +486,27 @@ void DynamicArray_push(DynamicArray * da, double value ) {
 
 void DynamicArray_push_front(DynamicArray * da, double value) {
     assert(da->buffer != NULL);
-    while ( da->origin == 0 ) {
-        extend_buffer(da);
+    unshare(da);
+    if ( grow_buffer(da, 1, 0) != 0 ) {
+        return;
+    }
+    if ( da->ring && da->origin == 0 ) {
+        /* Continue from the same slot in the upper copy of the ring */
+        da->origin += da->capacity;
+        da->end += da->capacity;
     }
     da->origin--;
-    DynamicArray_set(da,0,value);
+    /* The slot may still hold an element pop_front removed, so it is not
+       removed from the stats again */
+    stats_add(da, value);
+    set_element(da, 0, value);
 }
 
 double DynamicArray_pop(DynamicArray * da) {
     assert(DynamicArray_size(da) > 0);
     double value = DynamicArray_get(da, DynamicArray_size(da)-1);
-    DynamicArray_set(da, DynamicArray_size(da)-1, 0.0);
+    stats_remove(da, value);
+    set_element(da, DynamicArray_size(da)-1, 0.0);
     da->end--;
     return value;
 }
@@ -153,30 +514,397 @@ double DynamicArray_pop(DynamicArray * da) {
 double DynamicArray_pop_front(DynamicArray * da) {
     assert(DynamicArray_size(da) > 0);
     double value = DynamicArray_get(da, 0);
-    da->origin++;
-    return value;    
+    stats_remove(da, value);
+    if ( da->ring ) {
+        /* Clear the slot for reuse, and stay within the lower copy of the ring */
+        set_element(da, 0, 0.0);
+        da->origin++;
+        if ( da->origin >= da->capacity ) {
+            da->origin -= da->capacity;
+            da->end -= da->capacity;
+        }
+    } else {
+        da->origin++;
+    }
+    return value;
 }
 
 DynamicArray * DynamicArray_map(const DynamicArray * da, double (*f) (double)) {
     assert(da->buffer != NULL);
+    int n = DynamicArray_size(da);
     DynamicArray * result = DynamicArray_new();
-    for ( int i=0; i<DynamicArray_size(da); i++ ) {
-        DynamicArray_set(result, i, f(DynamicArray_get(da, i)));
+    DynamicArray_reserve(result, n);
+    const double * in = da->buffer + da->origin;
+    double * out = result->buffer + result->origin;
+    for ( int i=0; i<n; i++ ) {
+        out[i] = f(in[i]);
     }
+    result->end = result->origin + n;
     return result;
 }
 
+void DynamicArray_map_in_place(DynamicArray * da, double (*f) (double)) {
+    assert(da->buffer != NULL);
+    unshare(da);
+    double * x = da->buffer + da->origin;
+    for ( int i=0; i<DynamicArray_size(da); i++ ) {
+        x[i] = f(x[i]);
+    }
+    DynamicArray_invalidate_stats(da);
+}
+
+void DynamicArray_unshare(DynamicArray * da) {
+    assert(da->buffer != NULL);
+    unshare(da);
+}
+
 DynamicArray * DynamicArray_subarray(DynamicArray * da, int a, int b) {
 
   assert(da->buffer != NULL);
+  assert(a >= 0);
   assert(b >= a);
 
-  DynamicArray * result = DynamicArray_new();
+  int size = DynamicArray_size(da),
+      lo = a < size ? a : size,
+      hi = b < size ? b : size;
+
+  if ( da->fd >= 0 ) {
+      /* The mapping moves when the file grows, which would leave a view
+         dangling, so subarrays of file-backed arrays are copies */
+      DynamicArray * result = DynamicArray_new();
+      DynamicArray_reserve(result, b - a);
+      memcpy(result->buffer + result->origin, da->buffer + da->origin + lo, (hi - lo) * sizeof(double));
+      result->end = result->origin + b - a;
+      return result;
+  }
+
+  if ( da->refcount == NULL ) {
+      da->refcount = (int *) alloc_small(da, sizeof(int));
+      *da->refcount = 1;
+  }
+  (*da->refcount)++;
+
+  DynamicArray * result = new_header(da->arena);
+  result->buffer = da->buffer;
+  result->capacity = da->capacity;
+  result->refcount = da->refcount;
+  result->is_view = 1;
+  result->ring = da->ring;
+  result->origin = da->origin + lo;
+  result->end = da->origin + hi;
+  if ( result->ring && result->origin >= result->capacity ) {
+      result->origin -= result->capacity;
+      result->end -= result->capacity;
+  }
 
-  for (int i=a; i<b; i++) {
-      DynamicArray_push(result,DynamicArray_get(da, i));
+  if ( b > size && b > a ) {
+      /* Pad with zeros, as DynamicArray_get does past the end */
+      DynamicArray_set(result, b - a - 1, 0.0);
   }
 
   return result;
 
-}
\ No newline at end of file
+}
+
+double DynamicArray_min ( const DynamicArray * da ) {
+    assert(DynamicArray_size(da) > 0);
+    DynamicArrayStats * s = da->stats;
+    if ( s != NULL && s->has_min ) {
+        return s->min;
+    }
+    double min = get_kernels()->min(da->buffer + da->origin, DynamicArray_size(da));
+    if ( s != NULL && !isnan(min) ) {
+        s->min = min;
+        s->has_min = 1;
+    }
+    return min;
+}
+
+double DynamicArray_max ( const DynamicArray * da ) {
+    assert(DynamicArray_size(da) > 0);
+    DynamicArrayStats * s = da->stats;
+    if ( s != NULL && s->has_max ) {
+        return s->max;
+    }
+    double max = get_kernels()->max(da->buffer + da->origin, DynamicArray_size(da));
+    if ( s != NULL && !isnan(max) ) {
+        s->max = max;
+        s->has_max = 1;
+    }
+    return max;
+}
+
+double DynamicArray_sum ( const DynamicArray * da ) {
+    assert(da->buffer != NULL);
+    DynamicArrayStats * s = da->stats;
+    if ( s != NULL && s->has_sum ) {
+        return s->sum;
+    }
+    double sum = get_kernels()->sum(da->buffer + da->origin, DynamicArray_size(da));
+    if ( s != NULL && isfinite(sum) ) {
+        s->sum = sum;
+        s->has_sum = 1;
+    }
+    return sum;
+}
+
+double DynamicArray_mean ( const DynamicArray * da ) {
+    assert(DynamicArray_size(da) > 0);
+    return DynamicArray_sum(da) / DynamicArray_size(da);
+}
+
+DynamicArray_simd_level DynamicArray_get_simd_level(void) {
+    get_kernels();
+    return simd_level;
+}
+
+DynamicArray_simd_level DynamicArray_set_simd_level(DynamicArray_simd_level level) {
+    DynamicArray_simd_level best = dynamic_array_best_simd_level();
+    simd_level = level < best ? level : best;
+    kernels = dynamic_array_kernels(simd_level);
+    return simd_level;
+}
+
+double DynamicArray_quantile ( const DynamicArray * da, double q ) {
+    assert(DynamicArray_size(da) > 0);
+    assert(q >= 0 && q <= 1);
+    int n = DynamicArray_size(da);
+    double frac, * x = scratch_copy(da);
+    int k = quantile_rank(n, q, &frac);
+    dynamic_array_select(x, n, k);
+    double result = x[k];
+    if ( frac > 0 ) {
+        /* The next order statistic is the smallest value above rank k */
+        result += frac * ( get_kernels()->min(x + k + 1, n - k - 1) - result );
+    }
+    free(x);
+    return result;
+}
+
+void DynamicArray_quantiles ( const DynamicArray * da, const double * qs, int nq, double * out ) {
+    assert(DynamicArray_size(da) > 0);
+    int n = DynamicArray_size(da),
+        * ks = (int *) malloc(2 * nq * sizeof(int)),
+        nk = 0;
+    double * x = scratch_copy(da);
+    for ( int i=0; i<nq; i++ ) {
+        double frac;
+        assert(qs[i] >= 0 && qs[i] <= 1);
+        int k = quantile_rank(n, qs[i], &frac);
+        ks[nk++] = k;
+        if ( frac > 0 ) {
+            ks[nk++] = k + 1;
+        }
+    }
+    qsort(ks, nk, sizeof(int), compare_ints);
+    int unique = 0;
+    for ( int i=0; i<nk; i++ ) {
+        if ( unique == 0 || ks[i] != ks[unique-1] ) {
+            ks[unique++] = ks[i];
+        }
+    }
+    dynamic_array_select_many(x, n, ks, unique);
+    for ( int i=0; i<nq; i++ ) {
+        double frac;
+        int k = quantile_rank(n, qs[i], &frac);
+        out[i] = frac > 0 ? x[k] + frac * ( x[k+1] - x[k] ) : x[k];
+    }
+    free(ks);
+    free(x);
+}
+
+double DynamicArray_median ( const DynamicArray * da ) {
+    return DynamicArray_quantile(da, 0.5);
+}
+
+void DynamicArray_cache_stats ( DynamicArray * da, int enable ) {
+    assert(da->buffer != NULL);
+    if ( enable && da->stats == NULL ) {
+        da->stats = (DynamicArrayStats *) alloc_small(da, sizeof(DynamicArrayStats));
+    } else if ( !enable ) {
+        free_small(da, da->stats);
+        da->stats = NULL;
+    }
+}
+
+void DynamicArray_invalidate_stats ( DynamicArray * da ) {
+    if ( da->stats != NULL ) {
+        da->stats->has_sum = da->stats->has_min = da->stats->has_max = 0;
+    }
+}
+
+void DynamicArray_sort ( DynamicArray * da ) {
+    assert(da->buffer != NULL);
+    unshare(da);
+    dynamic_array_radix_sort(da->buffer + da->origin, DynamicArray_size(da));
+}
+
+void DynamicArray_unique ( DynamicArray * da ) {
+    assert(da->buffer != NULL);
+    unshare(da);
+    double * x = da->buffer + da->origin;
+    int n = DynamicArray_size(da),
+        m = n > 0 ? 1 : 0;
+    for ( int i=1; i<n; i++ ) {
+        if ( x[i] != x[m-1] ) {
+            x[m++] = x[i];
+        }
+    }
+    memset(x + m, 0, (n - m) * sizeof(double));
+    da->end = da->origin + m;
+    if ( da->stats != NULL ) {
+        da->stats->has_sum = 0; /* min and max are still there */
+    }
+}
+
+int DynamicArray_lower_bound ( const DynamicArray * da, double value ) {
+    const double * x = da->buffer + da->origin;
+    int lo = 0,
+        hi = DynamicArray_size(da);
+    while ( lo < hi ) {
+        int mid = lo + (hi - lo) / 2;
+        if ( x[mid] < value ) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+DynamicArray * DynamicArray_merge ( const DynamicArray * a, const DynamicArray * b ) {
+    int na = DynamicArray_size(a),
+        nb = DynamicArray_size(b),
+        i = 0, j = 0, k = 0;
+    const double * x = a->buffer + a->origin,
+                 * y = b->buffer + b->origin;
+    DynamicArray * da = new_exact(na + nb);
+    double * out = da->buffer;
+    while ( i < na && j < nb ) {
+        out[k++] = y[j] < x[i] ? y[j++] : x[i++];
+    }
+    memcpy(out + k, x + i, (na - i) * sizeof(double));
+    memcpy(out + k + na - i, y + j, (nb - j) * sizeof(double));
+    return da;
+}
+
+int DynamicArray_is_valid(const DynamicArray * da) {
+    return da->buffer != NULL;
+}
+
+int DynamicArray_num_arrays() {
+    return dynamic_array_live_count();
+}
+
+void DynamicArray_destroy_all() {
+    dynamic_array_foreach_live(DynamicArray_destroy);
+}
+
+int DynamicArray_set_ring(DynamicArray * da, int ring) {
+    assert(da->buffer != NULL);
+    assert(da->fd < 0 && da->arena == NULL);
+    ring = ring != 0;
+    if ( ring == da->ring ) {
+        return 0;
+    }
+    unshare(da);
+    if ( ring == da->ring ) {
+        return 0;
+    }
+    int size = DynamicArray_size(da),
+        capacity = size > da->capacity ? size : da->capacity,
+        origin = ring ? 0 : ( capacity - size ) / 2;
+    double * old = da->buffer;
+    int old_capacity = da->capacity;
+    da->ring = ring;
+    da->buffer = alloc_buffer(da, &capacity);
+    if ( da->buffer == NULL ) {
+        da->ring = !ring;
+        da->buffer = old;
+        return -1;
+    }
+    memcpy(da->buffer + origin, old + da->origin, size * sizeof(double));
+    free_buffer(da, old, old_capacity, !ring);
+    da->capacity = capacity;
+    da->origin = origin;
+    da->end = origin + size;
+    return 0;
+}
+
+int DynamicArray_is_ring(const DynamicArray * da) {
+    return da->ring;
+}
+
+DynamicArray * DynamicArray_range(double a, double b, double step) {
+    assert(step != 0);
+    /* The tolerance keeps b in the range when (b - a) / step rounds down */
+    double steps = floor ( (b - a) / step + 1e-9 );
+    int n = steps < 0 ? 0 : (int) steps + 1;
+    DynamicArray * da = new_exact(n);
+    double * x = da->buffer;
+    /* Computing each value from a, rather than adding step repeatedly, keeps
+       rounding errors from accumulating, and lets the loop vectorize */
+    for ( int i=0; i<n; i++ ) {
+        x[i] = a + i * step;
+    }
+    return da;
+}
+
+DynamicArray * DynamicArray_concat(const DynamicArray * a, const DynamicArray * b) {
+    int na = DynamicArray_size(a),
+        nb = DynamicArray_size(b);
+    DynamicArray * da = new_exact(na + nb);
+    memcpy(da->buffer, a->buffer + a->origin, na * sizeof(double));
+    memcpy(da->buffer + na, b->buffer + b->origin, nb * sizeof(double));
+    return da;
+}
+
+void DynamicArray_append_move(DynamicArray * dst, DynamicArray * src) {
+
+    assert(dst->buffer != NULL && src->buffer != NULL);
+    assert(dst != src);
+
+    int size = DynamicArray_size(dst),
+        n = DynamicArray_size(src);
+
+    if ( size == 0 && dst->fd < 0 && dst->refcount == NULL
+                   && src->fd < 0 && src->refcount == NULL && dst->arena == src->arena ) {
+        /* Take the whole buffer over; src gets a new empty one below */
+        release_buffer(dst);
+        dst->buffer = src->buffer;
+        dst->capacity = src->capacity;
+        dst->origin = src->origin;
+        dst->end = src->end;
+        dst->ring = src->ring;
+        src->buffer = NULL;
+        DynamicArray_invalidate_stats(dst);
+    } else if ( n > 0 ) {
+        if ( write_needs_copy(dst, size + n - 1) ) {
+            unshare(dst);
+        }
+        if ( grow_buffer(dst, 0, n) != 0 ) {
+            return;
+        }
+        memcpy(dst->buffer + dst->end, src->buffer + src->origin, n * sizeof(double));
+        dst->end += n;
+        DynamicArray_invalidate_stats(dst);
+    }
+    DynamicArray_invalidate_stats(src);
+
+    if ( src->buffer != NULL && src->refcount == NULL ) {
+        /* Keep the private buffer, zeroed as DynamicArray_set expects */
+        memset(src->buffer + src->origin, 0, n * sizeof(double));
+        src->end = src->origin;
+    } else {
+        if ( src->buffer != NULL ) {
+            release_buffer(src);
+        }
+        src->capacity = DYNAMIC_ARRAY_INITIAL_CAPACITY;
+        src->ring = 0;
+        src->is_view = 0;
+        src->buffer = alloc_buffer(src, &src->capacity);
+        src->origin = src->capacity / 2;
+        src->end = src->origin;
+    }
+
+}
@@ -2,19 +2,129 @@
 #define _DYNAMIC_ARRAY
 
 #define DYNAMIC_ARRAY_INITIAL_CAPACITY 10
+#define DYNAMIC_ARRAY_GROWTH_FACTOR 2.0
+
+#include <stdio.h>
+#include "arena.h"
+
+/* Cached aggregates of an array, see DynamicArray_cache_stats */
+typedef struct {
+    int has_sum,
+        has_min,
+        has_max;
+    double sum,
+           min,
+           max;
+} DynamicArrayStats;
 
 typedef struct {
     int capacity,
         origin,
         end;
+    double growth_factor;
     double * buffer;
+    int * refcount; /* shared by arrays using the same buffer, NULL if unshared */
+    int is_view;    /* non-zero for arrays made by DynamicArray_subarray */
+    int ring;       /* non-zero in ring-buffer mode, see DynamicArray_set_ring */
+    int fd;         /* the backing file of a mapped array, -1 otherwise */
+    DynamicArrayStats * stats; /* NULL unless caching is turned on */
+    Arena * arena;  /* holds the header and buffer, NULL if they come from the heap */
 } DynamicArray;
 
 /* Constructors / Destructors ************************************************/
 
+/*! Headers come from a registry of slabs with per-thread free lists, so arrays can
+ *  be created and destroyed on many threads at once without contending on a lock.
+ *  Destroying an array frees its buffer and recycles its header for a later
+ *  DynamicArray_new, so the array must not be used, or destroyed, again.
+ */
 DynamicArray * DynamicArray_new(void);
 void DynamicArray_destroy(DynamicArray *);
 
+/*! Makes an array whose header, buffer and any later buffers come from an arena
+ *  instead of the heap, so it costs no malloc and needs no destroy: arena_reset
+ *  releases it along with everything else in the arena. Destroying it is allowed
+ *  and gives back its buffer if that was the arena's most recent allocation.
+ *  Subarrays of it share the arena, and their headers come from it too. Arena
+ *  arrays are not counted by DynamicArray_num_arrays and cannot be put in ring mode.
+ *  \param arena The arena
+ */
+DynamicArray * DynamicArray_new_in(Arena * arena);
+
+/* Capacity ******************************************************************/
+
+/*! Makes room for the array to hold n elements, counting from its first element,
+ *  so that pushing up to that size does not reallocate. Returns 0, or -1 with errno
+ *  set if there is no memory, if the array is file-backed and its file cannot grow,
+ *  e.g. on a full disk, or if it is in ring mode and a larger ring cannot be mapped;
+ *  the array is then unchanged.
+ *  \param da The array
+ *  \param n The number of elements to make room for
+ */
+int DynamicArray_reserve(DynamicArray * da, int n);
+
+/*! Reallocates the buffer to hold exactly the current elements. Returns 0, or -1
+ *  with errno set if a file-backed array's file or mapping cannot shrink; the array
+ *  keeps its elements either way.
+ *  \param da The array
+ */
+int DynamicArray_shrink_to_fit(DynamicArray * da);
+
+/*! Switches the array into or out of ring-buffer mode. In ring mode the slots freed
+ *  by pop_front are reused by push, so an array used as a FIFO queue needs no more
+ *  memory than its largest size and stops regrowing once it gets there. The buffer
+ *  is mapped twice in a row, so the elements remain contiguous at buffer + origin
+ *  and every other function works unchanged. The capacity is rounded up to whole
+ *  pages. File-backed arrays cannot be switched to ring mode. Returns 0, or -1
+ *  with errno set, leaving the array unchanged, if the ring buffer cannot be
+ *  mapped. A copy of a ring array that cannot map a ring of its own when it is
+ *  first written leaves ring mode.
+ *  \param da The array
+ *  \param ring 1 for ring mode, 0 for the usual layout
+ */
+int DynamicArray_set_ring(DynamicArray * da, int ring);
+
+/*! Returns 1 if the array is in ring-buffer mode and 0 otherwise.
+ */
+int DynamicArray_is_ring(const DynamicArray * da);
+
+/*! Sets the factor by which the capacity is multiplied when the buffer has to grow.
+ *  The default is DYNAMIC_ARRAY_GROWTH_FACTOR.
+ *  \param da The array
+ *  \param factor The growth factor, which must be greater than 1
+ */
+void DynamicArray_set_growth_factor(DynamicArray * da, double factor);
+
+/* File-backed arrays *******************************************************/
+
+/*! Creates a file holding an empty array with room for capacity elements, and returns
+ *  an array whose buffer is the memory mapped file. The file is replaced if it exists.
+ *  Every other DynamicArray function works on the result; growing it extends the file.
+ *  A set, push or append that needs the file to grow and cannot grow it leaves the
+ *  array unchanged; call DynamicArray_reserve first to find out why.
+ *  Returns NULL if the file cannot be created or mapped.
+ *  \param path The file name
+ *  \param capacity The initial capacity, in elements
+ */
+DynamicArray * DynamicArray_create_mapped(const char * path, int capacity);
+
+/*! Maps a file written by a mapped array, without reading its elements. Returns NULL
+ *  if the file cannot be opened or is not a mapped array.
+ *  \param path The file name
+ */
+DynamicArray * DynamicArray_open_mapped(const char * path);
+
+/*! Writes the size and position of the elements to the file header and waits for the
+ *  mapped file to reach the disk. DynamicArray_destroy also writes the header. Returns
+ *  0 on success, or -1 with errno set. Does nothing for arrays that are not mapped.
+ *  \param da The array
+ */
+int DynamicArray_flush(DynamicArray * da);
+
+/*! Returns 1 if the array's buffer is a memory mapped file and 0 otherwise.
+ */
+int DynamicArray_is_mapped(const DynamicArray * da);
+
 /* Getters / Setters *********************************************************/
 
 void DynamicArray_set(DynamicArray *, int, double);
@@ -26,6 +136,45 @@ int DynamicArray_size(const DynamicArray *);
 char * DynamicArray_to_string(const DynamicArray *);
 void DynamicArray_print_debug_info(const DynamicArray *);
 
+/* Serialization *************************************************************/
+
+/*! Writes the shortest decimal that reads back as exactly x, followed by a NUL, and
+ *  returns its length. See grisu.h for the notation used.
+ *  \param x The number
+ *  \param buffer At least GRISU_BUFFER_SIZE (32) characters
+ */
+int DynamicArray_format_double(double x, char * buffer);
+
+/*! Streams the array as text, e.g. [1,0.25,-3e-7], with each element in shortest
+ *  round-trip form, using a fixed-size buffer however long the array is. Returns
+ *  the number of characters written, or -1 on a write error.
+ *  \param da The array
+ *  \param file The stream to write to
+ */
+long DynamicArray_write(const DynamicArray * da, FILE * file);
+
+/*! Like DynamicArray_write, but writes to a file descriptor.
+ *  \param da The array
+ *  \param fd The file descriptor to write to
+ */
+long DynamicArray_write_fd(const DynamicArray * da, int fd);
+
+/*! Writes the array in binary: the magic bytes "DArr", a little-endian uint32 version
+ *  and uint64 element count, then the elements as little-endian doubles. Returns 0 on
+ *  success and -1 on a write error.
+ *  \param da The array
+ *  \param file The stream to write to
+ */
+int DynamicArray_save(const DynamicArray * da, FILE * file);
+
+/*! Reads an array written by DynamicArray_save, with no parsing. The buffer grows
+ *  geometrically as the elements are read, never more than a chunk ahead of them, so
+ *  a truncated or corrupt header cannot make it allocate more than the stream holds.
+ *  Returns NULL if the stream does not hold a saved array, or if there is no memory.
+ *  \param file The stream to read from
+ */
+DynamicArray * DynamicArray_load(FILE * file);
+
 /* Operations ****************************************************************/
 
 void DynamicArray_push(DynamicArray *, double);
@@ -36,6 +185,12 @@ double DynamicArray_pop_front(DynamicArray *);
 
 DynamicArray * DynamicArray_map ( const DynamicArray *, double (*) (double) );
 
+/*! Replaces each element x of the array with f(x).
+ *  \param da The array
+ *  \param f The function to apply
+ */
+void DynamicArray_map_in_place ( DynamicArray * da, double (*f) (double) );
+
 /* EXERCISES: ********************************************************/
 
 /*! Return the first value in the given array. Throw a runtime error if the array is empty.
@@ -54,19 +209,31 @@ double DynamicArray_first ( const DynamicArray * da );
 DynamicArray * DynamicArray_copy ( const DynamicArray * da );
 
 /*! Return a new array whose elements span the given range and are step units apart.
+ *  The range includes b when it is a whole number of steps from a, and element i
+ *  is computed as a + i * step, so rounding errors do not build up. The result is
+ *  allocated once, at its exact size.
  *  \param a The first value
  *  \param b The second value
  *  \param step The different between consecutive elements.
  */
 DynamicArray * DynamicArray_range ( double a, double b, double step);
 
-/*! Return a new array that is the concatenation of the given arrays. 
+/*! Return a new array that is the concatenation of the given arrays. The result is
+ *  allocated once, at its exact size.
  *  \param a The first array
  *  \param b The second array
  */
 DynamicArray * DynamicArray_concat ( const DynamicArray * a, const DynamicArray * b );
 
-/*! Mathematical operations
+/*! Moves the elements of src onto the end of dst and leaves src empty. When dst
+ *  is empty it takes over the buffer of src instead of copying, provided neither
+ *  array is file-backed or shares its buffer with views.
+ *  \param dst The array to append to
+ *  \param src The array to move the elements from
+ */
+void DynamicArray_append_move ( DynamicArray * dst, DynamicArray * src );
+
+/*! Mathematical operations. min and max return NaN if any element is NaN.
   */
 double DynamicArray_min ( const DynamicArray * da );
 double DynamicArray_max ( const DynamicArray * da );
@@ -74,18 +241,119 @@ double DynamicArray_mean ( const DynamicArray * da );
 double DynamicArray_median ( const DynamicArray * da );
 double DynamicArray_sum ( const DynamicArray * da );
 
+/*! Returns the q-th quantile of the array, for 0 <= q <= 1, interpolating linearly
+ *  between the two nearest order statistics. Runs in linear time on a scratch copy,
+ *  so the array itself is left unchanged. The median is the 0.5 quantile.
+ *  \param da The array
+ *  \param q The quantile
+ */
+double DynamicArray_quantile ( const DynamicArray * da, double q );
+
+/*! Computes several quantiles with a single partitioning pass over one scratch copy.
+ *  \param da The array
+ *  \param qs The quantiles, each between 0 and 1, in any order
+ *  \param nq The number of quantiles
+ *  \param out Receives the nq results, in the same order as qs
+ */
+void DynamicArray_quantiles ( const DynamicArray * da, const double * qs, int nq, double * out );
+
+/*! Turns caching of the sum, min and max on or off. With caching on, repeated calls
+ *  to DynamicArray_sum, _mean, _min and _max return the cached value in constant time.
+ *  DynamicArray_set, push and pop keep the sum up to date and min and max too, unless
+ *  the element they remove was the minimum or maximum, in which case that value is
+ *  computed again on the next call. Other changes clear the cache. A sum updated many
+ *  times may differ from a fresh one in the last bits, as with any running sum.
+ *  \param da The array
+ *  \param enable 1 to cache, 0 not to
+ */
+void DynamicArray_cache_stats ( DynamicArray * da, int enable );
+
+/*! Clears the cached statistics of the array, if any. Call this after writing to
+ *  the buffer directly rather than through DynamicArray_set.
+ *  \param da The array
+ */
+void DynamicArray_invalidate_stats ( DynamicArray * da );
+
+/*! Sorts the array ascending, in place, with a radix sort on the bit patterns of the
+ *  values. Runs in linear time. Negative zero sorts before zero, and NaNs go to the
+ *  ends of the array.
+ *  \param da The array
+ */
+void DynamicArray_sort ( DynamicArray * da );
+
+/*! Removes consecutive equal elements, keeping the first of each run. On a sorted
+ *  array this leaves each value once.
+ *  \param da The array
+ */
+void DynamicArray_unique ( DynamicArray * da );
+
+/*! Returns the index of the first element of a sorted array that is not less than
+ *  value, or the size of the array if there is none. Uses binary search.
+ *  \param da The sorted array
+ *  \param value The value to look for
+ */
+int DynamicArray_lower_bound ( const DynamicArray * da, double value );
+
+/*! Returns a new sorted array with the elements of two sorted arrays, in linear time.
+ *  Of two equal elements, the one from a comes first.
+ *  \param a The first sorted array
+ *  \param b The second sorted array
+ */
+DynamicArray * DynamicArray_merge ( const DynamicArray * a, const DynamicArray * b );
+
 /*! Returns 1 if the array is valid (meaning its buffer is not NULL) and 0 otherwize.
+ *  The answer means nothing for an array that has been destroyed, since its header
+ *  may already belong to another array.
  */
 int DynamicArray_is_valid(const DynamicArray * da);
 
-/*! Returns the number of arrays that have been constructed to far.
+/*! Returns the number of arrays that have been constructed and not yet destroyed.
+ *  Safe to call from any thread.
  */
 int DynamicArray_num_arrays();
 
-/*! Destroys all arrays that have been constructed so far.
+/*! Destroys all arrays that have been constructed so far. Must not run while other
+ *  threads are using arrays. As after DynamicArray_destroy, the arrays must not be
+ *  used, or destroyed, again.
  */
 void DynamicArray_destroy_all();
 
-DynamicArray * DynamicArray_subarray(DynamicArray *, int, int);
+/*! Returns the elements from index a up to, but not including, index b. The result
+ *  is a view that shares the buffer of da, so no elements are copied. Writing to
+ *  the view, or changing elements of da the view can see, first gives the writer
+ *  its own copy. Destroy views with DynamicArray_destroy as usual.
+ *  \param da The array
+ *  \param a The first index
+ *  \param b One past the last index
+ */
+DynamicArray * DynamicArray_subarray(DynamicArray * da, int a, int b);
+
+/*! Gives the array its own copy of a buffer it shares with views, so that its
+ *  elements can be written directly through da->buffer.
+ *  \param da The array
+ */
+void DynamicArray_unshare(DynamicArray * da);
+
+/* Instruction set selection *************************************************/
+
+/*! Instruction sets the reductions (min, max, mean, sum) can use. The best one
+ *  the CPU supports is chosen the first time a reduction is called.
+ */
+typedef enum {
+    DYNAMIC_ARRAY_SCALAR,
+    DYNAMIC_ARRAY_SSE2,
+    DYNAMIC_ARRAY_AVX2,
+    DYNAMIC_ARRAY_AVX512
+} DynamicArray_simd_level;
+
+/*! Returns the instruction set currently used by the reductions.
+ */
+DynamicArray_simd_level DynamicArray_get_simd_level(void);
+
+/*! Makes the reductions use the given instruction set, or the best supported one
+ *  below it if the CPU does not have it. Returns the level actually selected.
+ *  \param level The requested instruction set
+ */
+DynamicArray_simd_level DynamicArray_set_simd_level(DynamicArray_simd_level level);
 
 #endif
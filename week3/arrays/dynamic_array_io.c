@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "dynamic_array.h"
+#include "grisu.h"
+
+/* Text is formatted into a fixed chunk that is handed to a sink whenever it
+   fills up, so arrays of any size are written with constant memory. */
+#define CHUNK_SIZE 65536
+
+/* Binary format: the 4 byte magic, a little-endian uint32 version and
+   uint64 element count, then the elements as little-endian IEEE-754 doubles */
+#define BINARY_MAGIC "DArr"
+#define BINARY_VERSION 1
+#define BINARY_HEADER_SIZE 16
+
+typedef int (*Sink) ( void * target, const char * data, size_t n );
+
+/* private functions *********************************************************/
+
+static int file_sink ( void * target, const char * data, size_t n ) {
+    return fwrite(data, 1, n, (FILE *) target) == n ? 0 : -1;
+}
+
+static int fd_sink ( void * target, const char * data, size_t n ) {
+    int fd = *(int *) target;
+    while ( n > 0 ) {
+        ssize_t written = write(fd, data, n);
+        if ( written < 0 ) {
+            if ( errno == EINTR ) continue;
+            return -1;
+        }
+        data += written;
+        n -= written;
+    }
+    return 0;
+}
+
+/* Writes [x0,x1,...] in shortest round-trip form. Returns the number of
+   characters written, or -1 if the sink failed. */
+static long write_text ( const DynamicArray * da, Sink sink, void * target ) {
+
+    assert(da->buffer != NULL);
+
+    char * chunk = (char *) malloc(CHUNK_SIZE);
+    const double * x = da->buffer + da->origin;
+    int n = DynamicArray_size(da);
+    size_t used = 0;
+    long total = 0;
+
+    chunk[used++] = '[';
+    for ( int i=0; i<n; i++ ) {
+        if ( used + GRISU_BUFFER_SIZE + 1 > CHUNK_SIZE ) {
+            if ( sink(target, chunk, used) != 0 ) {
+                free(chunk);
+                return -1;
+            }
+            total += used;
+            used = 0;
+        }
+        used += grisu_format(x[i], chunk + used);
+        if ( i < n - 1 ) {
+            chunk[used++] = ',';
+        }
+    }
+    chunk[used++] = ']';
+
+    int status = sink(target, chunk, used);
+    free(chunk);
+    return status == 0 ? total + (long) used : -1;
+
+}
+
+static int host_is_little_endian ( void ) {
+    uint16_t one = 1;
+    return *(uint8_t *) &one == 1;
+}
+
+static void put_le ( unsigned char * p, uint64_t v, int bytes ) {
+    for ( int i=0; i<bytes; i++ ) {
+        p[i] = (unsigned char) ( v >> ( 8 * i ) );
+    }
+}
+
+static uint64_t get_le ( const unsigned char * p, int bytes ) {
+    uint64_t v = 0;
+    for ( int i=0; i<bytes; i++ ) {
+        v |= (uint64_t) p[i] << ( 8 * i );
+    }
+    return v;
+}
+
+/* Reverses the bytes of each double, converting between byte orders */
+static void swap_doubles ( double * x, int n ) {
+    for ( int i=0; i<n; i++ ) {
+        uint64_t v;
+        memcpy(&v, x + i, sizeof(v));
+        v = __builtin_bswap64(v);
+        memcpy(x + i, &v, sizeof(v));
+    }
+}
+
+/* public functions **********************************************************/
+
+int DynamicArray_format_double(double x, char * buffer) {
+    return grisu_format(x, buffer);
+}
+
+long DynamicArray_write(const DynamicArray * da, FILE * file) {
+    return write_text(da, file_sink, file);
+}
+
+long DynamicArray_write_fd(const DynamicArray * da, int fd) {
+    return write_text(da, fd_sink, &fd);
+}
+
+int DynamicArray_save(const DynamicArray * da, FILE * file) {
+
+    assert(da->buffer != NULL);
+
+    int n = DynamicArray_size(da);
+    unsigned char header[BINARY_HEADER_SIZE];
+    memcpy(header, BINARY_MAGIC, 4);
+    put_le(header + 4, BINARY_VERSION, 4);
+    put_le(header + 8, (uint64_t) n, 8);
+    if ( fwrite(header, 1, sizeof(header), file) != sizeof(header) ) {
+        return -1;
+    }
+
+    const double * x = da->buffer + da->origin;
+    if ( host_is_little_endian() ) {
+        return fwrite(x, sizeof(double), n, file) == (size_t) n ? 0 : -1;
+    }
+
+    /* Big-endian hosts convert a chunk at a time */
+    double chunk[CHUNK_SIZE / sizeof(double)];
+    int per_chunk = CHUNK_SIZE / sizeof(double);
+    for ( int i=0; i<n; i+=per_chunk ) {
+        int len = n - i < per_chunk ? n - i : per_chunk;
+        memcpy(chunk, x + i, len * sizeof(double));
+        swap_doubles(chunk, len);
+        if ( fwrite(chunk, sizeof(double), len, file) != (size_t) len ) {
+            return -1;
+        }
+    }
+    return 0;
+
+}
+
+DynamicArray * DynamicArray_load(FILE * file) {
+
+    unsigned char header[BINARY_HEADER_SIZE];
+    if ( fread(header, 1, sizeof(header), file) != sizeof(header) ||
+         memcmp(header, BINARY_MAGIC, 4) != 0 ||
+         get_le(header + 4, 4) != BINARY_VERSION ) {
+        return NULL;
+    }
+    uint64_t count = get_le(header + 8, 8);
+    if ( count > (uint64_t) 0x7FFFFFFF ) {
+        return NULL;
+    }
+
+    /* The elements start at the front of the buffer, so no capacity up to
+       count overflows an int. The buffer grows as the elements arrive, at
+       most a chunk past them, rather than trusting count up front. */
+    int n = (int) count,
+        per_chunk = CHUNK_SIZE / sizeof(double);
+    DynamicArray * da = DynamicArray_new();
+    da->origin = da->end = 0;
+    for ( int i=0; i<n; ) {
+        int len = n - i < per_chunk ? n - i : per_chunk;
+        if ( da->capacity < i + len ) {
+            int grown = da->capacity < n / 2 ? 2 * da->capacity : n;
+            if ( DynamicArray_reserve(da, grown > i + len ? grown : i + len) != 0 ) {
+                DynamicArray_destroy(da);
+                return NULL;
+            }
+        }
+        double * x = da->buffer + i;
+        if ( fread(x, sizeof(double), len, file) != (size_t) len ) {
+            DynamicArray_destroy(da);
+            return NULL;
+        }
+        if ( !host_is_little_endian() ) {
+            swap_doubles(x, len);
+        }
+        i += len;
+        da->end = i;
+    }
+    return da;
+
+}
@@ -0,0 +1,190 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "dynamic_array_mapped.h"
+#include "array_memory.h"
+
+/* A mapped file holds a 64 byte header followed by the buffer. Keeping the
+   header a cache line long leaves the buffer 64 byte aligned in the mapping. */
+
+#define MAPPED_MAGIC "DYNARRAY"
+#define MAPPED_VERSION 1
+
+typedef struct {
+    char magic[8];
+    int32_t version,
+            capacity,
+            origin,
+            end;
+    char reserved[40];
+} MappedHeader;
+
+/* private functions *********************************************************/
+
+static size_t mapped_length ( int capacity ) {
+    return sizeof(MappedHeader) + (size_t) capacity * sizeof(double);
+}
+
+static MappedHeader * header_of ( const DynamicArray * da ) {
+    return (MappedHeader *) ( (char *) da->buffer - sizeof(MappedHeader) );
+}
+
+static void write_header ( const DynamicArray * da ) {
+    MappedHeader * h = header_of(da);
+    memcpy(h->magic, MAPPED_MAGIC, sizeof(h->magic));
+    h->version = MAPPED_VERSION;
+    h->capacity = da->capacity;
+    h->origin = da->origin;
+    h->end = da->end;
+}
+
+/* Maps the whole file and turns a fresh array into a view of it */
+static DynamicArray * attach ( int fd, int capacity ) {
+    void * base = mmap(NULL, mapped_length(capacity), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if ( base == MAP_FAILED ) {
+        close(fd);
+        return NULL;
+    }
+    DynamicArray * da = DynamicArray_new();
+    array_memory_free(da->buffer, da->capacity * sizeof(double));
+    da->buffer = (double *) ( (char *) base + sizeof(MappedHeader) );
+    da->capacity = capacity;
+    da->fd = fd;
+    return da;
+}
+
+/* public functions **********************************************************/
+
+DynamicArray * DynamicArray_create_mapped(const char * path, int capacity) {
+    assert(capacity > 0);
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if ( fd < 0 ) {
+        return NULL;
+    }
+    /* A freshly extended file reads as zeros, as DynamicArray_set expects */
+    if ( ftruncate(fd, mapped_length(capacity)) != 0 ) {
+        close(fd);
+        return NULL;
+    }
+    DynamicArray * da = attach(fd, capacity);
+    if ( da != NULL ) {
+        da->origin = 0;
+        da->end = 0;
+        write_header(da);
+    }
+    return da;
+}
+
+DynamicArray * DynamicArray_open_mapped(const char * path) {
+    int fd = open(path, O_RDWR);
+    if ( fd < 0 ) {
+        return NULL;
+    }
+    MappedHeader h;
+    struct stat st;
+    if ( read(fd, &h, sizeof(h)) != sizeof(h) ||
+         memcmp(h.magic, MAPPED_MAGIC, sizeof(h.magic)) != 0 ||
+         h.version != MAPPED_VERSION ||
+         h.capacity <= 0 || h.origin < 0 || h.origin > h.end || h.end > h.capacity ||
+         fstat(fd, &st) != 0 || (size_t) st.st_size < mapped_length(h.capacity) ) {
+        close(fd);
+        return NULL;
+    }
+    DynamicArray * da = attach(fd, h.capacity);
+    if ( da != NULL ) {
+        da->origin = h.origin;
+        da->end = h.end;
+    }
+    return da;
+}
+
+int DynamicArray_flush(DynamicArray * da) {
+    assert(da->buffer != NULL);
+    if ( da->fd < 0 ) {
+        return 0;
+    }
+    write_header(da);
+    return msync(header_of(da), mapped_length(da->capacity), MS_SYNC);
+}
+
+int DynamicArray_is_mapped(const DynamicArray * da) {
+    return da->fd >= 0;
+}
+
+/* private interface *********************************************************/
+
+int dynamic_array_mapped_resize ( DynamicArray * da, int capacity, int new_origin ) {
+
+    size_t old_length = mapped_length(da->capacity),
+           new_length = mapped_length(capacity);
+    int size = da->end - da->origin,
+        new_end = new_origin + size,
+        status = 0;
+    void * base = header_of(da);
+
+    /* Extend the file before the mapping, so no mapped page lies past its end */
+    if ( capacity > da->capacity ) {
+        if ( ftruncate(da->fd, new_length) != 0 ) {
+            return -1;
+        }
+        void * grown = mremap(base, old_length, new_length, MREMAP_MAYMOVE);
+        if ( grown == MAP_FAILED ) {
+            int saved = errno;
+            if ( ftruncate(da->fd, old_length) != 0 ) {
+                /* The file stays longer than the array needs, which is harmless */
+            }
+            errno = saved;
+            return -1;
+        }
+        base = grown;
+    }
+
+    double * x = (double *) ( (char *) base + sizeof(MappedHeader) );
+    if ( new_origin != da->origin ) {
+        memmove(x + new_origin, x + da->origin, size * sizeof(double));
+        if ( new_end < da->end ) {
+            int stale = ( da->end < capacity ? da->end : capacity ) - new_end;
+            memset(x + new_end, 0, stale * sizeof(double));
+        }
+    }
+
+    /* Shrink the mapping before the file. If either fails the elements, which
+       have already moved, are kept at the old capacity, or in a file longer
+       than the mapping; both are valid arrays. */
+    if ( capacity < da->capacity ) {
+        void * shrunk = mremap(base, old_length, new_length, MREMAP_MAYMOVE);
+        if ( shrunk == MAP_FAILED ) {
+            if ( da->end > capacity ) {
+                memset(x + capacity, 0, ( da->end - capacity ) * sizeof(double));
+            }
+            da->origin = new_origin;
+            da->end = new_end;
+            write_header(da);
+            return -1;
+        }
+        base = shrunk;
+        status = ftruncate(da->fd, new_length);
+    }
+
+    da->buffer = (double *) ( (char *) base + sizeof(MappedHeader) );
+    da->capacity = capacity;
+    da->origin = new_origin;
+    da->end = new_end;
+    write_header(da);
+    return status == 0 ? 0 : -1;
+
+}
+
+void dynamic_array_mapped_close ( DynamicArray * da ) {
+    write_header(da);
+    munmap(header_of(da), mapped_length(da->capacity));
+    close(da->fd);
+    da->fd = -1;
+}
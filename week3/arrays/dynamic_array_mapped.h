@@ -0,0 +1,24 @@
+#ifndef _DYNAMIC_ARRAY_MAPPED
+#define _DYNAMIC_ARRAY_MAPPED
+
+#include "dynamic_array.h"
+
+/*! @file
+ *  Support for arrays whose buffer is a memory mapped file, used by
+ *  dynamic_array.c. The public functions are declared in dynamic_array.h.
+ *  This header is private to the dynamic array implementation.
+ */
+
+/*! Resizes the file and its mapping to the given capacity and moves the
+ *  elements to start at new_origin, keeping slots past the end zero. Returns 0,
+ *  or -1 with errno set if the file or the mapping cannot be resized. A failed
+ *  grow leaves the array unchanged; a failed shrink leaves the same elements,
+ *  possibly at a larger capacity.
+ */
+int dynamic_array_mapped_resize ( DynamicArray * da, int capacity, int new_origin );
+
+/*! Writes the header, unmaps the file and closes it.
+ */
+void dynamic_array_mapped_close ( DynamicArray * da );
+
+#endif
@@ -0,0 +1,149 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "dynamic_array_pipeline.h"
+
+/* Elements are processed in blocks small enough to stay in L1, running each
+   stage over the whole block before the next. The stages are fused into one
+   pass over memory while each inner loop calls a single function. */
+#define BLOCK 256
+
+typedef struct {
+    const DynamicArrayPipeline * pipeline;
+    const double * in;
+    double * out;          /* NULL when reducing */
+    int n;
+    double (*op) (double, double);
+    double identity;
+    double * partials;     /* one per worker when reducing */
+} Job;
+
+/* private functions *********************************************************/
+
+static void run_stages ( const DynamicArrayPipeline * p, double * x, int n ) {
+    for ( int s=0; s<p->num_stages; s++ ) {
+        double (*f) (double) = p->stages[s];
+        for ( int i=0; i<n; i++ ) {
+            x[i] = f(x[i]);
+        }
+    }
+}
+
+static void map_range ( const Job * job, int lo, int hi ) {
+    for ( int b=lo; b<hi; b+=BLOCK ) {
+        int len = hi - b < BLOCK ? hi - b : BLOCK;
+        if ( job->out != job->in ) {
+            memcpy(job->out + b, job->in + b, len * sizeof(double));
+        }
+        run_stages(job->pipeline, job->out + b, len);
+    }
+}
+
+static double reduce_range ( const Job * job, int lo, int hi ) {
+    double acc = job->identity,
+           x[BLOCK];
+    for ( int b=lo; b<hi; b+=BLOCK ) {
+        int len = hi - b < BLOCK ? hi - b : BLOCK;
+        memcpy(x, job->in + b, len * sizeof(double));
+        run_stages(job->pipeline, x, len);
+        for ( int i=0; i<len; i++ ) {
+            acc = job->op(acc, x[i]);
+        }
+    }
+    return acc;
+}
+
+static void job_task ( void * arg, int worker, int num_workers ) {
+    Job * job = (Job *) arg;
+    int lo = (int) ( (long) job->n * worker / num_workers ),
+        hi = (int) ( (long) job->n * (worker + 1) / num_workers );
+    if ( job->out != NULL ) {
+        map_range(job, lo, hi);
+    } else {
+        job->partials[worker] = reduce_range(job, lo, hi);
+    }
+}
+
+/* Number of workers a job over n elements is split across */
+static int workers_for ( const DynamicArrayPipeline * p, int n ) {
+    return n >= DYNAMIC_ARRAY_PARALLEL_THRESHOLD ? p->num_threads : 1;
+}
+
+/* Runs the job on the pool if it is large enough, otherwise inline */
+static void run_job ( DynamicArrayPipeline * p, Job * job ) {
+    if ( workers_for(p, job->n) > 1 ) {
+        if ( p->pool == NULL ) {
+            p->pool = ThreadPool_new(p->num_threads);
+        }
+        ThreadPool_run(p->pool, job_task, job);
+    } else {
+        job_task(job, 0, 1);
+    }
+}
+
+/* public functions **********************************************************/
+
+DynamicArrayPipeline * DynamicArrayPipeline_new(void) {
+    DynamicArrayPipeline * p = (DynamicArrayPipeline *) malloc(sizeof(DynamicArrayPipeline));
+    p->num_stages = 0;
+    p->num_threads = ThreadPool_num_processors();
+    p->pool = NULL;
+    return p;
+}
+
+void DynamicArrayPipeline_destroy(DynamicArrayPipeline * p) {
+    if ( p->pool != NULL ) {
+        ThreadPool_destroy(p->pool);
+    }
+    free(p);
+}
+
+void DynamicArrayPipeline_map(DynamicArrayPipeline * p, double (*f) (double)) {
+    assert(p->num_stages < DYNAMIC_ARRAY_PIPELINE_MAX_STAGES);
+    p->stages[p->num_stages++] = f;
+}
+
+void DynamicArrayPipeline_set_threads(DynamicArrayPipeline * p, int num_threads) {
+    assert(num_threads >= 1);
+    if ( p->pool != NULL && ThreadPool_size(p->pool) != num_threads ) {
+        ThreadPool_destroy(p->pool);
+        p->pool = NULL;
+    }
+    p->num_threads = num_threads;
+}
+
+DynamicArray * DynamicArrayPipeline_apply(DynamicArrayPipeline * p, const DynamicArray * da) {
+    assert(da->buffer != NULL);
+    int n = DynamicArray_size(da);
+    DynamicArray * result = DynamicArray_new();
+    DynamicArray_reserve(result, n);
+    Job job = { p, da->buffer + da->origin, result->buffer + result->origin, n, NULL, 0, NULL };
+    run_job(p, &job);
+    result->end = result->origin + n;
+    return result;
+}
+
+void DynamicArrayPipeline_apply_in_place(DynamicArrayPipeline * p, DynamicArray * da) {
+    DynamicArray_unshare(da);
+    double * x = da->buffer + da->origin;
+    Job job = { p, x, x, DynamicArray_size(da), NULL, 0, NULL };
+    run_job(p, &job);
+    DynamicArray_invalidate_stats(da);
+}
+
+double DynamicArrayPipeline_reduce(DynamicArrayPipeline * p, const DynamicArray * da,
+                                   double (*op) (double, double), double identity) {
+    assert(da->buffer != NULL);
+    int n = DynamicArray_size(da),
+        workers = workers_for(p, n);
+    double * partials = (double *) malloc(workers * sizeof(double));
+    Job job = { p, da->buffer + da->origin, NULL, n, op, identity, partials };
+    run_job(p, &job);
+    double result = partials[0];
+    for ( int w=1; w<workers; w++ ) {
+        result = op(result, partials[w]);
+    }
+    free(partials);
+    return result;
+}
@@ -0,0 +1,70 @@
+#ifndef _DYNAMIC_ARRAY_PIPELINE
+#define _DYNAMIC_ARRAY_PIPELINE
+
+#include "dynamic_array.h"
+#include "thread_pool.h"
+
+/*! @file
+ *  A chain of element-wise maps, optionally followed by a reduction, that is
+ *  applied to an array in a single pass. Arrays of at least
+ *  DYNAMIC_ARRAY_PARALLEL_THRESHOLD elements are split into one contiguous
+ *  chunk per worker thread.
+ */
+
+#define DYNAMIC_ARRAY_PIPELINE_MAX_STAGES 16
+#define DYNAMIC_ARRAY_PARALLEL_THRESHOLD 65536
+
+typedef struct {
+    double (*stages[DYNAMIC_ARRAY_PIPELINE_MAX_STAGES]) (double);
+    int num_stages,
+        num_threads;
+    ThreadPool * pool; /* started on first parallel use */
+} DynamicArrayPipeline;
+
+/* Constructors / Destructors ************************************************/
+
+/*! Returns an empty pipeline that uses one thread per online processor.
+ */
+DynamicArrayPipeline * DynamicArrayPipeline_new(void);
+void DynamicArrayPipeline_destroy(DynamicArrayPipeline *);
+
+/* Setup *********************************************************************/
+
+/*! Appends a map stage. Stages are applied in the order they were added.
+ *  \param p The pipeline
+ *  \param f The function to apply to each element
+ */
+void DynamicArrayPipeline_map(DynamicArrayPipeline * p, double (*f) (double));
+
+/*! Sets the number of threads to split large arrays across.
+ *  \param p The pipeline
+ *  \param num_threads The number of threads, at least 1
+ */
+void DynamicArrayPipeline_set_threads(DynamicArrayPipeline * p, int num_threads);
+
+/* Operations ****************************************************************/
+
+/*! Returns a new array holding the result of every stage applied to each element of da.
+ *  \param p The pipeline
+ *  \param da The input array
+ */
+DynamicArray * DynamicArrayPipeline_apply(DynamicArrayPipeline * p, const DynamicArray * da);
+
+/*! Applies every stage to each element of da, in place.
+ *  \param p The pipeline
+ *  \param da The array
+ */
+void DynamicArrayPipeline_apply_in_place(DynamicArrayPipeline * p, DynamicArray * da);
+
+/*! Maps each element through every stage and folds the results with op, without
+ *  storing the mapped values. The operation must be associative, since each thread
+ *  folds its own chunk before the partial results are combined in order.
+ *  \param p The pipeline
+ *  \param da The input array
+ *  \param op The binary operation
+ *  \param identity The identity of op, returned for an empty array
+ */
+double DynamicArrayPipeline_reduce(DynamicArrayPipeline * p, const DynamicArray * da,
+                                   double (*op) (double, double), double identity);
+
+#endif
@@ -0,0 +1,183 @@
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "dynamic_array_registry.h"
+
+/* Each header lives in a slot of a slab. Slabs are never freed, so a slot
+   can always be inspected; a slot is live exactly when its buffer is not
+   NULL. Slabs are pushed onto a global list with compare-and-swap and never
+   removed, which keeps the push free of the ABA problem. Free slots are kept
+   on a list owned by the thread that freed them. A thread that frees more
+   than CACHE_LIMIT slots hands a batch to a shared list, and a thread whose
+   list is empty takes a batch from the shared list before it makes a new
+   slab, so arrays made on one thread and destroyed on another keep being
+   recycled. An exiting thread hands over its whole list. The shared list is
+   the only place a lock is taken. */
+
+#define SLAB_SLOTS 1024
+#define CACHE_BATCH 256                 /* slots moved to or from the shared list at once */
+#define CACHE_LIMIT ( 2 * CACHE_BATCH ) /* most free slots a thread keeps */
+
+typedef struct Slot {
+    DynamicArray array; /* first, so a header pointer is a slot pointer */
+    struct Slot * next_free;
+} Slot;
+
+typedef struct Slab {
+    struct Slab * next;
+    Slot slots[SLAB_SLOTS];
+} Slab;
+
+typedef struct {
+    Slot * free_list;
+    int num_free;
+} ThreadCache;
+
+static Slab * slabs = NULL;
+static int live = 0;
+
+static Slot * shared = NULL;
+static int have_shared = 0;
+static pthread_mutex_t shared_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t cache_key;
+static __thread ThreadCache * cache = NULL;
+
+/* private functions *********************************************************/
+
+/* Puts the chain of free slots from first to last on the shared list */
+static void give_away ( Slot * first, Slot * last ) {
+    pthread_mutex_lock(&shared_lock);
+    last->next_free = shared;
+    shared = first;
+    __atomic_store_n(&have_shared, 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&shared_lock);
+}
+
+/* Runs when a thread exits: give its free slots to the other threads */
+static void release_cache ( void * p ) {
+    ThreadCache * c = (ThreadCache *) p;
+    if ( c->free_list != NULL ) {
+        Slot * last = c->free_list;
+        while ( last->next_free != NULL ) {
+            last = last->next_free;
+        }
+        give_away(c->free_list, last);
+    }
+    free(c);
+}
+
+static void make_key ( void ) {
+    pthread_key_create(&cache_key, release_cache);
+}
+
+static ThreadCache * thread_cache ( void ) {
+    if ( cache == NULL ) {
+        pthread_once(&key_once, make_key);
+        cache = (ThreadCache *) malloc(sizeof(ThreadCache));
+        cache->free_list = NULL;
+        cache->num_free = 0;
+        pthread_setspecific(cache_key, cache);
+    }
+    return cache;
+}
+
+/* Refills an empty free list, with up to CACHE_BATCH slots from the shared
+   list if there are any and otherwise from a new slab */
+static void refill ( ThreadCache * c ) {
+
+    if ( __atomic_load_n(&have_shared, __ATOMIC_ACQUIRE) ) {
+        pthread_mutex_lock(&shared_lock);
+        Slot * first = shared,
+             * last = shared;
+        int n = first != NULL;
+        while ( n > 0 && n < CACHE_BATCH && last->next_free != NULL ) {
+            last = last->next_free;
+            n++;
+        }
+        if ( n > 0 ) {
+            shared = last->next_free;
+            last->next_free = NULL;
+        }
+        if ( shared == NULL ) {
+            __atomic_store_n(&have_shared, 0, __ATOMIC_RELAXED);
+        }
+        pthread_mutex_unlock(&shared_lock);
+        if ( n > 0 ) {
+            c->free_list = first;
+            c->num_free = n;
+            return;
+        }
+    }
+
+    Slab * slab = (Slab *) calloc(1, sizeof(Slab));
+    for ( int i=0; i<SLAB_SLOTS-1; i++ ) {
+        slab->slots[i].next_free = &slab->slots[i+1];
+    }
+    c->free_list = &slab->slots[0];
+    c->num_free = SLAB_SLOTS;
+
+    slab->next = __atomic_load_n(&slabs, __ATOMIC_RELAXED);
+    while ( !__atomic_compare_exchange_n(&slabs, &slab->next, slab, 1,
+                                         __ATOMIC_RELEASE, __ATOMIC_RELAXED) ) {
+        /* slab->next now holds the current head; try again */
+    }
+
+}
+
+/* private interface *********************************************************/
+
+DynamicArray * dynamic_array_header_alloc ( void ) {
+    ThreadCache * c = thread_cache();
+    if ( c->free_list == NULL ) {
+        refill(c);
+    }
+    Slot * slot = c->free_list;
+    c->free_list = slot->next_free;
+    c->num_free--;
+    __atomic_fetch_add(&live, 1, __ATOMIC_RELAXED);
+    return &slot->array;
+}
+
+void dynamic_array_header_free ( DynamicArray * da ) {
+    ThreadCache * c = thread_cache();
+    Slot * slot = (Slot *) da;
+    slot->next_free = c->free_list;
+    c->free_list = slot;
+    __atomic_fetch_sub(&live, 1, __ATOMIC_RELAXED);
+
+    /* Keep the list bounded when this thread frees more than it makes */
+    if ( ++c->num_free > CACHE_LIMIT ) {
+        Slot * last = c->free_list;
+        for ( int i=1; i<CACHE_BATCH; i++ ) {
+            last = last->next_free;
+        }
+        Slot * first = c->free_list;
+        c->free_list = last->next_free;
+        c->num_free -= CACHE_BATCH;
+        give_away(first, last);
+    }
+}
+
+int dynamic_array_slab_count ( void ) {
+    int n = 0;
+    for ( Slab * slab = __atomic_load_n(&slabs, __ATOMIC_ACQUIRE); slab != NULL; slab = slab->next ) {
+        n++;
+    }
+    return n;
+}
+
+int dynamic_array_live_count ( void ) {
+    return __atomic_load_n(&live, __ATOMIC_RELAXED);
+}
+
+void dynamic_array_foreach_live ( void (*f) ( DynamicArray * ) ) {
+    for ( Slab * slab = __atomic_load_n(&slabs, __ATOMIC_ACQUIRE); slab != NULL; slab = slab->next ) {
+        for ( int i=0; i<SLAB_SLOTS; i++ ) {
+            if ( slab->slots[i].array.buffer != NULL ) {
+                f(&slab->slots[i].array);
+            }
+        }
+    }
+}
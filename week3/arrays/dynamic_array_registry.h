@@ -0,0 +1,38 @@
+#ifndef _DYNAMIC_ARRAY_REGISTRY
+#define _DYNAMIC_ARRAY_REGISTRY
+
+#include "dynamic_array.h"
+
+/*! @file
+ *  The registry of every DynamicArray header, used by dynamic_array.c.
+ *  Headers are carved out of slabs and recycled through per-thread free
+ *  lists, so creating an array takes no lock and, apart from the occasional
+ *  new slab, no malloc. This header is private to the dynamic array
+ *  implementation.
+ */
+
+/*! Returns an uninitialized header and counts it as live.
+ */
+DynamicArray * dynamic_array_header_alloc ( void );
+
+/*! Returns a header to the calling thread's free list and counts it as no longer live.
+ *  A list that grows past a limit passes a batch of headers to a shared list, which
+ *  other threads take from before making a new slab. The caller must have set the
+ *  buffer to NULL.
+ */
+void dynamic_array_header_free ( DynamicArray * da );
+
+/*! Returns the number of slabs made so far, each of which holds 1024 headers.
+ */
+int dynamic_array_slab_count ( void );
+
+/*! Returns the number of live headers.
+ */
+int dynamic_array_live_count ( void );
+
+/*! Calls f on every header whose buffer is not NULL. Must not run while other
+ *  threads create or destroy arrays.
+ */
+void dynamic_array_foreach_live ( void (*f) ( DynamicArray * ) );
+
+#endif
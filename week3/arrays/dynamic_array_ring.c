@@ -0,0 +1,55 @@
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "dynamic_array_ring.h"
+
+/* Undoes a partial setup, keeping the errno of the call that failed */
+static void fail ( int fd, char * base, size_t bytes ) {
+    int error = errno;
+    if ( base != NULL ) {
+        munmap(base, bytes);
+    }
+    close(fd);
+    errno = error;
+}
+
+double * dynamic_array_ring_alloc ( int * capacity ) {
+
+    size_t page = (size_t) sysconf(_SC_PAGESIZE),
+           bytes = ( (size_t) *capacity * sizeof(double) + page - 1 ) / page * page;
+    if ( bytes == 0 ) {
+        bytes = page;
+    }
+
+    /* A fresh memory file reads as zeros */
+    int fd = memfd_create("dynamic_array_ring", 0);
+    if ( fd < 0 ) {
+        return NULL;
+    }
+    if ( ftruncate(fd, bytes) != 0 ) {
+        fail(fd, NULL, 0);
+        return NULL;
+    }
+
+    /* Reserve twice the room, then map the file into both halves */
+    char * base = (char *) mmap(NULL, 2 * bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if ( base == MAP_FAILED ) {
+        fail(fd, NULL, 0);
+        return NULL;
+    }
+    if ( mmap(base, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED
+      || mmap(base + bytes, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ) {
+        fail(fd, base, 2 * bytes);
+        return NULL;
+    }
+    close(fd);
+
+    *capacity = (int) ( bytes / sizeof(double) );
+    return (double *) base;
+
+}
+
+void dynamic_array_ring_free ( double * buffer, int capacity ) {
+    munmap(buffer, 2 * (size_t) capacity * sizeof(double));
+}
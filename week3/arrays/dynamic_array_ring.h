@@ -0,0 +1,24 @@
+#ifndef _DYNAMIC_ARRAY_RING
+#define _DYNAMIC_ARRAY_RING
+
+/*! @file
+ *  Buffers for arrays in ring mode, used by dynamic_array.c. A ring buffer of
+ *  capacity n is mapped twice, back to back, so buffer[i] and buffer[i+n] are
+ *  the same memory. Elements that wrap around the end of the ring are then
+ *  still contiguous at buffer + origin, for any origin below n, and every
+ *  function that reads buffer[origin..end) works unchanged. This header is
+ *  private to the dynamic array implementation.
+ */
+
+/*! Rounds capacity up to a whole number of pages, allocates a zeroed ring buffer
+ *  of that many elements and stores the rounded capacity back in *capacity.
+ *  Returns NULL with errno set, leaving *capacity unchanged, if the memory
+ *  file cannot be created or mapped.
+ */
+double * dynamic_array_ring_alloc ( int * capacity );
+
+/*! Frees a buffer returned by dynamic_array_ring_alloc.
+ */
+void dynamic_array_ring_free ( double * buffer, int capacity );
+
+#endif
@@ -0,0 +1,128 @@
+#include "dynamic_array_select.h"
+
+/* Introselect: quickselect with a median-of-three pivot, switching to a
+   median-of-medians pivot when partitioning stops making progress, which
+   keeps the worst case linear. Partitioning is three-way so that runs of
+   equal values (common in sensor data) are settled in a single step. */
+
+#define SMALL_RANGE 16
+
+static void swap ( double * x, int i, int j ) {
+    double t = x[i];
+    x[i] = x[j];
+    x[j] = t;
+}
+
+static void insertion_sort ( double * x, int lo, int hi ) {
+    for ( int i=lo+1; i<hi; i++ ) {
+        double v = x[i];
+        int j = i;
+        while ( j > lo && x[j-1] > v ) {
+            x[j] = x[j-1];
+            j--;
+        }
+        x[j] = v;
+    }
+}
+
+static double median_of_three ( const double * x, int lo, int hi ) {
+    double a = x[lo], b = x[lo + (hi-lo)/2], c = x[hi-1];
+    if ( a > b ) { double t = a; a = b; b = t; }
+    if ( b > c ) { b = c; }
+    return a > b ? a : b;
+}
+
+static void select_range ( double * x, int lo, int hi, int k, int budget );
+
+/* Gathers the medians of groups of five at the front of [lo,hi) and returns
+   their median */
+static double median_of_medians ( double * x, int lo, int hi ) {
+    int groups = 0;
+    for ( int g=lo; g<hi; g+=5 ) {
+        int end = g + 5 < hi ? g + 5 : hi;
+        insertion_sort(x, g, end);
+        swap(x, lo + groups, g + (end-g)/2);
+        groups++;
+    }
+    select_range(x, lo, lo + groups, lo + groups/2, 0);
+    return x[lo + groups/2];
+}
+
+/* Splits [lo,hi) into [lo,*lt) < pivot, [*lt,*gt) == pivot, [*gt,hi) > pivot */
+static void partition ( double * x, int lo, int hi, double pivot, int * lt, int * gt ) {
+    int i = lo, l = lo, g = hi;
+    while ( i < g ) {
+        if ( x[i] < pivot ) {
+            swap(x, i++, l++);
+        } else if ( x[i] > pivot ) {
+            swap(x, i, --g);
+        } else {
+            i++;
+        }
+    }
+    *lt = l;
+    *gt = g;
+}
+
+static int depth_budget ( int n ) {
+    int b = 0;
+    while ( n > 1 ) {
+        n >>= 1;
+        b += 2;
+    }
+    return b;
+}
+
+static void select_range ( double * x, int lo, int hi, int k, int budget ) {
+    while ( hi - lo > SMALL_RANGE ) {
+        double pivot = budget-- > 0 ? median_of_three(x, lo, hi) : median_of_medians(x, lo, hi);
+        int lt, gt;
+        partition(x, lo, hi, pivot, &lt, &gt);
+        if ( k < lt ) {
+            hi = lt;
+        } else if ( k >= gt ) {
+            lo = gt;
+        } else {
+            return;
+        }
+    }
+    insertion_sort(x, lo, hi);
+}
+
+static void select_many_range ( double * x, int lo, int hi, const int * ks, int nk, int budget ) {
+    while ( nk > 0 ) {
+        if ( hi - lo <= SMALL_RANGE || nk == 1 ) {
+            if ( nk == 1 ) {
+                select_range(x, lo, hi, ks[0], budget);
+            } else {
+                insertion_sort(x, lo, hi);
+            }
+            return;
+        }
+        double pivot = budget-- > 0 ? median_of_three(x, lo, hi) : median_of_medians(x, lo, hi);
+        int lt, gt;
+        partition(x, lo, hi, pivot, &lt, &gt);
+        int left = 0, right = nk;
+        while ( left < nk && ks[left] < lt ) left++;
+        while ( right > left && ks[right-1] >= gt ) right--;
+        /* Recurse into the side with fewer ranks, loop on the other */
+        if ( left < nk - right ) {
+            select_many_range(x, lo, lt, ks, left, budget);
+            ks += right;
+            nk -= right;
+            lo = gt;
+        } else {
+            select_many_range(x, gt, hi, ks + right, nk - right, budget);
+            nk = left;
+            hi = lt;
+        }
+    }
+}
+
+void dynamic_array_select ( double * x, int n, int k ) {
+    select_range(x, 0, n, k, depth_budget(n));
+}
+
+void dynamic_array_select_many ( double * x, int n, const int * ks, int nk ) {
+    select_many_range(x, 0, n, ks, nk, depth_budget(n));
+}
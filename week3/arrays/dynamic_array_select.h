@@ -0,0 +1,27 @@
+#ifndef _DYNAMIC_ARRAY_SELECT
+#define _DYNAMIC_ARRAY_SELECT
+
+/*! @file
+ *  Linear time selection of order statistics, used by the quantile functions
+ *  in dynamic_array.c. Both functions reorder the values they are given, so
+ *  callers pass a scratch copy. This header is private to the dynamic array
+ *  implementation.
+ */
+
+/*! Reorders x so that x[k] holds the k-th smallest value, everything before it
+ *  is no larger and everything after it is no smaller.
+ *  \param x The values
+ *  \param n The number of values
+ *  \param k The rank to select, 0 <= k < n
+ */
+void dynamic_array_select ( double * x, int n, int k );
+
+/*! Like dynamic_array_select, but places every rank in ks in one pass.
+ *  \param x The values
+ *  \param n The number of values
+ *  \param ks The ranks to select, sorted ascending
+ *  \param nk The number of ranks
+ */
+void dynamic_array_select_many ( double * x, int n, const int * ks, int nk );
+
+#endif
@@ -0,0 +1,292 @@
+#include <math.h>
+
+#include "dynamic_array_simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define DYNAMIC_ARRAY_X86
+#include <immintrin.h>
+#endif
+
+/* scalar kernels ************************************************************/
+
+/* min and max return NaN if any element is NaN, at every level. The vector
+   min and max instructions return their second operand when either is NaN,
+   which would lose it, so the vector kernels also collect an unordered
+   compare of each load and check it at the end. */
+
+static double sum_scalar ( const double * x, int n ) {
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    int i = 0;
+    for ( ; i + 4 <= n; i += 4 ) {
+        s0 += x[i];
+        s1 += x[i+1];
+        s2 += x[i+2];
+        s3 += x[i+3];
+    }
+    for ( ; i < n; i++ ) {
+        s0 += x[i];
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+static double min_scalar ( const double * x, int n ) {
+    double m = x[0];
+    for ( int i=1; i<n; i++ ) {
+        if ( x[i] < m || isnan(x[i]) ) m = x[i];
+    }
+    return m;
+}
+
+static double max_scalar ( const double * x, int n ) {
+    double m = x[0];
+    for ( int i=1; i<n; i++ ) {
+        if ( x[i] > m || isnan(x[i]) ) m = x[i];
+    }
+    return m;
+}
+
+static const DynamicArrayKernels scalar_kernels = { sum_scalar, min_scalar, max_scalar };
+
+#ifdef DYNAMIC_ARRAY_X86
+
+/* SSE2 kernels: 2 doubles per register **************************************/
+
+__attribute__((target("sse2")))
+static double sum_sse2 ( const double * x, int n ) {
+    __m128d a0 = _mm_setzero_pd(), a1 = _mm_setzero_pd(),
+            a2 = _mm_setzero_pd(), a3 = _mm_setzero_pd();
+    int i = 0;
+    for ( ; i + 8 <= n; i += 8 ) {
+        a0 = _mm_add_pd(a0, _mm_loadu_pd(x+i));
+        a1 = _mm_add_pd(a1, _mm_loadu_pd(x+i+2));
+        a2 = _mm_add_pd(a2, _mm_loadu_pd(x+i+4));
+        a3 = _mm_add_pd(a3, _mm_loadu_pd(x+i+6));
+    }
+    a0 = _mm_add_pd(_mm_add_pd(a0, a1), _mm_add_pd(a2, a3));
+    double lanes[2];
+    _mm_storeu_pd(lanes, a0);
+    double s = lanes[0] + lanes[1];
+    for ( ; i < n; i++ ) {
+        s += x[i];
+    }
+    return s;
+}
+
+__attribute__((target("sse2")))
+static double min_sse2 ( const double * x, int n ) {
+    if ( n < 2 ) return min_scalar(x, n);
+    __m128d m = _mm_loadu_pd(x),
+            nan = _mm_cmpunord_pd(m, m);
+    int i = 2;
+    for ( ; i + 2 <= n; i += 2 ) {
+        __m128d v = _mm_loadu_pd(x+i);
+        m = _mm_min_pd(m, v);
+        nan = _mm_or_pd(nan, _mm_cmpunord_pd(v, v));
+    }
+    if ( _mm_movemask_pd(nan) ) {
+        return NAN;
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, m);
+    double r = lanes[0] < lanes[1] ? lanes[0] : lanes[1];
+    for ( ; i < n; i++ ) {
+        if ( x[i] < r || isnan(x[i]) ) r = x[i];
+    }
+    return r;
+}
+
+__attribute__((target("sse2")))
+static double max_sse2 ( const double * x, int n ) {
+    if ( n < 2 ) return max_scalar(x, n);
+    __m128d m = _mm_loadu_pd(x),
+            nan = _mm_cmpunord_pd(m, m);
+    int i = 2;
+    for ( ; i + 2 <= n; i += 2 ) {
+        __m128d v = _mm_loadu_pd(x+i);
+        m = _mm_max_pd(m, v);
+        nan = _mm_or_pd(nan, _mm_cmpunord_pd(v, v));
+    }
+    if ( _mm_movemask_pd(nan) ) {
+        return NAN;
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, m);
+    double r = lanes[0] > lanes[1] ? lanes[0] : lanes[1];
+    for ( ; i < n; i++ ) {
+        if ( x[i] > r || isnan(x[i]) ) r = x[i];
+    }
+    return r;
+}
+
+static const DynamicArrayKernels sse2_kernels = { sum_sse2, min_sse2, max_sse2 };
+
+/* AVX2 kernels: 4 doubles per register **************************************/
+
+__attribute__((target("avx2")))
+static double sum_avx2 ( const double * x, int n ) {
+    __m256d a0 = _mm256_setzero_pd(), a1 = _mm256_setzero_pd(),
+            a2 = _mm256_setzero_pd(), a3 = _mm256_setzero_pd();
+    int i = 0;
+    for ( ; i + 16 <= n; i += 16 ) {
+        a0 = _mm256_add_pd(a0, _mm256_loadu_pd(x+i));
+        a1 = _mm256_add_pd(a1, _mm256_loadu_pd(x+i+4));
+        a2 = _mm256_add_pd(a2, _mm256_loadu_pd(x+i+8));
+        a3 = _mm256_add_pd(a3, _mm256_loadu_pd(x+i+12));
+    }
+    for ( ; i + 4 <= n; i += 4 ) {
+        a0 = _mm256_add_pd(a0, _mm256_loadu_pd(x+i));
+    }
+    a0 = _mm256_add_pd(_mm256_add_pd(a0, a1), _mm256_add_pd(a2, a3));
+    __m128d h = _mm_add_pd(_mm256_castpd256_pd128(a0), _mm256_extractf128_pd(a0, 1));
+    double lanes[2];
+    _mm_storeu_pd(lanes, h);
+    double s = lanes[0] + lanes[1];
+    for ( ; i < n; i++ ) {
+        s += x[i];
+    }
+    return s;
+}
+
+__attribute__((target("avx2")))
+static double min_avx2 ( const double * x, int n ) {
+    if ( n < 4 ) return min_sse2(x, n);
+    __m256d m = _mm256_loadu_pd(x),
+            nan = _mm256_cmp_pd(m, m, _CMP_UNORD_Q);
+    int i = 4;
+    for ( ; i + 4 <= n; i += 4 ) {
+        __m256d v = _mm256_loadu_pd(x+i);
+        m = _mm256_min_pd(m, v);
+        nan = _mm256_or_pd(nan, _mm256_cmp_pd(v, v, _CMP_UNORD_Q));
+    }
+    if ( _mm256_movemask_pd(nan) ) {
+        return NAN;
+    }
+    __m128d h = _mm_min_pd(_mm256_castpd256_pd128(m), _mm256_extractf128_pd(m, 1));
+    double lanes[2];
+    _mm_storeu_pd(lanes, h);
+    double r = lanes[0] < lanes[1] ? lanes[0] : lanes[1];
+    for ( ; i < n; i++ ) {
+        if ( x[i] < r || isnan(x[i]) ) r = x[i];
+    }
+    return r;
+}
+
+__attribute__((target("avx2")))
+static double max_avx2 ( const double * x, int n ) {
+    if ( n < 4 ) return max_sse2(x, n);
+    __m256d m = _mm256_loadu_pd(x),
+            nan = _mm256_cmp_pd(m, m, _CMP_UNORD_Q);
+    int i = 4;
+    for ( ; i + 4 <= n; i += 4 ) {
+        __m256d v = _mm256_loadu_pd(x+i);
+        m = _mm256_max_pd(m, v);
+        nan = _mm256_or_pd(nan, _mm256_cmp_pd(v, v, _CMP_UNORD_Q));
+    }
+    if ( _mm256_movemask_pd(nan) ) {
+        return NAN;
+    }
+    __m128d h = _mm_max_pd(_mm256_castpd256_pd128(m), _mm256_extractf128_pd(m, 1));
+    double lanes[2];
+    _mm_storeu_pd(lanes, h);
+    double r = lanes[0] > lanes[1] ? lanes[0] : lanes[1];
+    for ( ; i < n; i++ ) {
+        if ( x[i] > r || isnan(x[i]) ) r = x[i];
+    }
+    return r;
+}
+
+static const DynamicArrayKernels avx2_kernels = { sum_avx2, min_avx2, max_avx2 };
+
+/* AVX-512 kernels: 8 doubles per register, masked tail **********************/
+
+__attribute__((target("avx512f")))
+static double sum_avx512 ( const double * x, int n ) {
+    __m512d a0 = _mm512_setzero_pd(), a1 = _mm512_setzero_pd(),
+            a2 = _mm512_setzero_pd(), a3 = _mm512_setzero_pd();
+    int i = 0;
+    for ( ; i + 32 <= n; i += 32 ) {
+        a0 = _mm512_add_pd(a0, _mm512_loadu_pd(x+i));
+        a1 = _mm512_add_pd(a1, _mm512_loadu_pd(x+i+8));
+        a2 = _mm512_add_pd(a2, _mm512_loadu_pd(x+i+16));
+        a3 = _mm512_add_pd(a3, _mm512_loadu_pd(x+i+24));
+    }
+    for ( ; i + 8 <= n; i += 8 ) {
+        a0 = _mm512_add_pd(a0, _mm512_loadu_pd(x+i));
+    }
+    if ( i < n ) {
+        __mmask8 tail = (__mmask8) ((1u << (n - i)) - 1);
+        a1 = _mm512_add_pd(a1, _mm512_maskz_loadu_pd(tail, x+i));
+    }
+    a0 = _mm512_add_pd(_mm512_add_pd(a0, a1), _mm512_add_pd(a2, a3));
+    return _mm512_reduce_add_pd(a0);
+}
+
+__attribute__((target("avx512f")))
+static double min_avx512 ( const double * x, int n ) {
+    if ( n < 8 ) return min_avx2(x, n);
+    __m512d m = _mm512_loadu_pd(x);
+    __mmask8 nan = _mm512_cmp_pd_mask(m, m, _CMP_UNORD_Q);
+    int i = 8;
+    for ( ; i + 8 <= n; i += 8 ) {
+        __m512d v = _mm512_loadu_pd(x+i);
+        m = _mm512_min_pd(m, v);
+        nan |= _mm512_cmp_pd_mask(v, v, _CMP_UNORD_Q);
+    }
+    if ( i < n ) {
+        /* Re-reading already seen elements is harmless for min */
+        __m512d v = _mm512_loadu_pd(x+n-8);
+        m = _mm512_min_pd(m, v);
+        nan |= _mm512_cmp_pd_mask(v, v, _CMP_UNORD_Q);
+    }
+    return nan ? NAN : _mm512_reduce_min_pd(m);
+}
+
+__attribute__((target("avx512f")))
+static double max_avx512 ( const double * x, int n ) {
+    if ( n < 8 ) return max_avx2(x, n);
+    __m512d m = _mm512_loadu_pd(x);
+    __mmask8 nan = _mm512_cmp_pd_mask(m, m, _CMP_UNORD_Q);
+    int i = 8;
+    for ( ; i + 8 <= n; i += 8 ) {
+        __m512d v = _mm512_loadu_pd(x+i);
+        m = _mm512_max_pd(m, v);
+        nan |= _mm512_cmp_pd_mask(v, v, _CMP_UNORD_Q);
+    }
+    if ( i < n ) {
+        __m512d v = _mm512_loadu_pd(x+n-8);
+        m = _mm512_max_pd(m, v);
+        nan |= _mm512_cmp_pd_mask(v, v, _CMP_UNORD_Q);
+    }
+    return nan ? NAN : _mm512_reduce_max_pd(m);
+}
+
+static const DynamicArrayKernels avx512_kernels = { sum_avx512, min_avx512, max_avx512 };
+
+#endif
+
+/* dispatch ******************************************************************/
+
+DynamicArray_simd_level dynamic_array_best_simd_level ( void ) {
+#ifdef DYNAMIC_ARRAY_X86
+    __builtin_cpu_init();
+    if ( __builtin_cpu_supports("avx512f") ) {
+        return DYNAMIC_ARRAY_AVX512;
+    } else if ( __builtin_cpu_supports("avx2") ) {
+        return DYNAMIC_ARRAY_AVX2;
+    } else if ( __builtin_cpu_supports("sse2") ) {
+        return DYNAMIC_ARRAY_SSE2;
+    }
+#endif
+    return DYNAMIC_ARRAY_SCALAR;
+}
+
+const DynamicArrayKernels * dynamic_array_kernels ( DynamicArray_simd_level level ) {
+    switch ( level ) {
+#ifdef DYNAMIC_ARRAY_X86
+        case DYNAMIC_ARRAY_AVX512: return &avx512_kernels;
+        case DYNAMIC_ARRAY_AVX2:   return &avx2_kernels;
+        case DYNAMIC_ARRAY_SSE2:   return &sse2_kernels;
+#endif
+        default:                   return &scalar_kernels;
+    }
+}
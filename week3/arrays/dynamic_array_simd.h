@@ -0,0 +1,26 @@
+#ifndef _DYNAMIC_ARRAY_SIMD
+#define _DYNAMIC_ARRAY_SIMD
+
+#include "dynamic_array.h"
+
+/*! @file
+ *  Reduction kernels used by dynamic_array.c. Each kernel works directly on
+ *  a contiguous run of doubles, so callers pass buffer + origin and the size.
+ *  This header is private to the dynamic array implementation.
+ */
+
+typedef struct {
+    double (*sum) ( const double *, int );
+    double (*min) ( const double *, int );
+    double (*max) ( const double *, int );
+} DynamicArrayKernels;
+
+/*! Returns the kernels for the given level. The level must be supported by the CPU.
+ */
+const DynamicArrayKernels * dynamic_array_kernels ( DynamicArray_simd_level level );
+
+/*! Returns the best level the running CPU supports.
+ */
+DynamicArray_simd_level dynamic_array_best_simd_level ( void );
+
+#endif
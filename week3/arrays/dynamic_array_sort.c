@@ -0,0 +1,102 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dynamic_array_sort.h"
+
+/* LSD radix sort on the bit patterns of the doubles, a byte at a time. Flipping
+   the sign bit of non-negative values, and every bit of negative ones, gives
+   unsigned keys that order the same way as the doubles. All eight histograms
+   are counted in one pass, and passes where every key has the same byte are
+   skipped, which is common for readings of similar magnitude. */
+
+#define RADIX_BITS 8
+#define RADIX_SIZE (1 << RADIX_BITS)
+#define RADIX_PASSES (64 / RADIX_BITS)
+#define SMALL_SORT 32
+
+/* Lets the double buffer be worked on as keys in place */
+typedef uint64_t __attribute__((may_alias)) Key;
+
+static inline uint64_t to_key ( uint64_t bits ) {
+    uint64_t mask = -(bits >> 63) | 0x8000000000000000ull;
+    return bits ^ mask;
+}
+
+static inline uint64_t from_key ( uint64_t key ) {
+    uint64_t mask = ( (key >> 63) - 1 ) | 0x8000000000000000ull;
+    return key ^ mask;
+}
+
+static void insertion_sort ( Key * k, int n ) {
+    for ( int i=1; i<n; i++ ) {
+        uint64_t v = k[i];
+        int j = i;
+        while ( j > 0 && k[j-1] > v ) {
+            k[j] = k[j-1];
+            j--;
+        }
+        k[j] = v;
+    }
+}
+
+void dynamic_array_radix_sort ( double * x, int n ) {
+
+    if ( n < 2 ) {
+        return;
+    }
+
+    Key * keys = (Key *) x;
+    for ( int i=0; i<n; i++ ) {
+        keys[i] = to_key(keys[i]);
+    }
+
+    if ( n <= SMALL_SORT ) {
+        insertion_sort(keys, n);
+    } else {
+
+        size_t counts[RADIX_PASSES][RADIX_SIZE] = {};
+        for ( int i=0; i<n; i++ ) {
+            uint64_t k = keys[i];
+            for ( int p=0; p<RADIX_PASSES; p++ ) {
+                counts[p][(k >> (p * RADIX_BITS)) & (RADIX_SIZE - 1)]++;
+            }
+        }
+
+        Key * temp = (Key *) malloc(n * sizeof(uint64_t)),
+               * from = keys,
+               * to = temp;
+
+        for ( int p=0; p<RADIX_PASSES; p++ ) {
+            size_t * count = counts[p];
+            int shift = p * RADIX_BITS;
+            if ( count[(from[0] >> shift) & (RADIX_SIZE - 1)] == (size_t) n ) {
+                continue;
+            }
+            size_t offset = 0;
+            for ( int b=0; b<RADIX_SIZE; b++ ) {
+                size_t c = count[b];
+                count[b] = offset;
+                offset += c;
+            }
+            for ( int i=0; i<n; i++ ) {
+                uint64_t k = from[i];
+                to[count[(k >> shift) & (RADIX_SIZE - 1)]++] = k;
+            }
+            Key * t = from;
+            from = to;
+            to = t;
+        }
+
+        if ( from != keys ) {
+            memcpy(keys, from, n * sizeof(uint64_t));
+        }
+        free(temp);
+
+    }
+
+    for ( int i=0; i<n; i++ ) {
+        keys[i] = from_key(keys[i]);
+    }
+
+}
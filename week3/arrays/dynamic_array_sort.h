@@ -0,0 +1,16 @@
+#ifndef _DYNAMIC_ARRAY_SORT
+#define _DYNAMIC_ARRAY_SORT
+
+/*! @file
+ *  Radix sort of doubles, used by DynamicArray_sort in dynamic_array.c. This
+ *  header is private to the dynamic array implementation.
+ */
+
+/*! Sorts x ascending. Negative zero sorts before zero, and NaNs go to the ends:
+ *  those with the sign bit set first, the others last.
+ *  \param x The values
+ *  \param n The number of values
+ */
+void dynamic_array_radix_sort ( double * x, int n );
+
+#endif
@@ -0,0 +1,286 @@
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "grisu.h"
+
+/* A floating point number f * 2^e with a 64 bit significand */
+typedef struct {
+    uint64_t f;
+    int e;
+} DiyFp;
+
+#define SIGNIFICAND_BITS 52
+#define HIDDEN_BIT ( (uint64_t) 1 << SIGNIFICAND_BITS )
+#define SIGNIFICAND_MASK ( HIDDEN_BIT - 1 )
+#define EXPONENT_BIAS ( 0x3FF + SIGNIFICAND_BITS )
+
+/* Normalized 64 bit significands and binary exponents of 10^k for
+   k = -348, -340, ..., 340, rounded to nearest */
+static const uint64_t cached_powers_f[] = {
+    0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+    0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+    0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+    0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+    0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+    0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+    0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+    0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+    0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+    0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+    0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+    0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+    0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+    0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+    0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+    0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+    0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+    0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+    0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+    0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+    0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+    0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+    0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+    0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+    0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+    0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+    0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+    0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+    0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL
+};
+
+static const int16_t cached_powers_e[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+    -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+    -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+    -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+    -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+    109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+    641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+    907, 933, 960, 986, 1013, 1039, 1066
+};
+
+static const uint64_t pow10[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+    10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+/* private functions *********************************************************/
+
+static DiyFp diyfp ( uint64_t f, int e ) {
+    DiyFp x;
+    x.f = f;
+    x.e = e;
+    return x;
+}
+
+static DiyFp from_double ( double d ) {
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    int biased_e = (int) ( ( bits >> SIGNIFICAND_BITS ) & 0x7FF );
+    uint64_t significand = bits & SIGNIFICAND_MASK;
+    if ( biased_e != 0 ) {
+        return diyfp(significand + HIDDEN_BIT, biased_e - EXPONENT_BIAS);
+    } else {
+        return diyfp(significand, 1 - EXPONENT_BIAS);
+    }
+}
+
+/* The product rounded to 64 bits */
+static DiyFp multiply ( DiyFp a, DiyFp b ) {
+    unsigned __int128 p = (unsigned __int128) a.f * b.f;
+    uint64_t hi = (uint64_t) ( p >> 64 ),
+             lo = (uint64_t) p;
+    return diyfp(hi + ( lo >> 63 ), a.e + b.e + 64);
+}
+
+static DiyFp normalize ( DiyFp x ) {
+    int s = __builtin_clzll(x.f);
+    return diyfp(x.f << s, x.e - s);
+}
+
+/* The halfway points between v and its neighbours, with a common exponent */
+static void boundaries ( DiyFp v, DiyFp * minus, DiyFp * plus ) {
+    DiyFp p = normalize(diyfp(( v.f << 1 ) + 1, v.e - 1)),
+          m = v.f == HIDDEN_BIT ? diyfp(( v.f << 2 ) - 1, v.e - 2)
+                                : diyfp(( v.f << 1 ) - 1, v.e - 1);
+    m.f <<= m.e - p.e;
+    m.e = p.e;
+    *plus = p;
+    *minus = m;
+}
+
+/* A cached power 10^-k such that multiplying by it brings a number with binary
+   exponent e into the range the digit generation expects */
+static DiyFp cached_power ( int e, int * k ) {
+    double dk = ( -61 - e ) * 0.30102999566398114 + 347;
+    int ik = (int) dk;
+    if ( dk - ik > 0.0 ) {
+        ik++;
+    }
+    int index = ( ik >> 3 ) + 1;
+    *k = -( -348 + ( index << 3 ) );
+    return diyfp(cached_powers_f[index], cached_powers_e[index]);
+}
+
+static int count_digits ( uint32_t n ) {
+    int d = 1;
+    while ( n >= 10 ) {
+        n /= 10;
+        d++;
+    }
+    return d;
+}
+
+/* Moves the last digit towards w while the result stays inside the rounding interval */
+static void round_weed ( char * buffer, int len, uint64_t delta, uint64_t rest,
+                         uint64_t ten_kappa, uint64_t wp_w ) {
+    while ( rest < wp_w && delta - rest >= ten_kappa &&
+            ( rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w ) ) {
+        buffer[len-1]--;
+        rest += ten_kappa;
+    }
+}
+
+/* Generates the shortest digits of a number in (Mp - delta, Mp], close to W */
+static int digit_gen ( DiyFp W, DiyFp Mp, uint64_t delta, char * buffer, int * k ) {
+
+    DiyFp one = diyfp((uint64_t) 1 << -Mp.e, Mp.e);
+    uint64_t wp_w = Mp.f - W.f,
+             p2 = Mp.f & ( one.f - 1 );
+    uint32_t p1 = (uint32_t) ( Mp.f >> -one.e );
+    int kappa = count_digits(p1),
+        len = 0;
+
+    while ( kappa > 0 ) {
+        uint32_t d = p1 / (uint32_t) pow10[kappa-1];
+        p1 %= (uint32_t) pow10[kappa-1];
+        if ( d || len ) {
+            buffer[len++] = (char) ( '0' + d );
+        }
+        kappa--;
+        uint64_t rest = ( (uint64_t) p1 << -one.e ) + p2;
+        if ( rest <= delta ) {
+            *k += kappa;
+            round_weed(buffer, len, delta, rest, pow10[kappa] << -one.e, wp_w);
+            return len;
+        }
+    }
+
+    while ( 1 ) {
+        p2 *= 10;
+        delta *= 10;
+        char d = (char) ( p2 >> -one.e );
+        if ( d || len ) {
+            buffer[len++] = (char) ( '0' + d );
+        }
+        p2 &= one.f - 1;
+        kappa--;
+        if ( p2 < delta ) {
+            *k += kappa;
+            int index = -kappa;
+            round_weed(buffer, len, delta, p2, one.f, wp_w * ( index < 20 ? pow10[index] : 0 ));
+            return len;
+        }
+    }
+
+}
+
+/* Digits of a positive finite value, with value ~= digits * 10^k */
+static int grisu2 ( double value, char * buffer, int * k ) {
+    DiyFp v = from_double(value), w_m, w_p;
+    boundaries(v, &w_m, &w_p);
+    DiyFp c_mk = cached_power(w_p.e, k),
+          W = multiply(normalize(v), c_mk),
+          Wp = multiply(w_p, c_mk),
+          Wm = multiply(w_m, c_mk);
+    Wm.f++;
+    Wp.f--;
+    return digit_gen(W, Wp, Wp.f - Wm.f, buffer, k);
+}
+
+static int write_exponent ( int e, char * buffer ) {
+    int n = 0;
+    buffer[n++] = 'e';
+    if ( e < 0 ) {
+        buffer[n++] = '-';
+        e = -e;
+    }
+    if ( e >= 100 ) {
+        buffer[n++] = (char) ( '0' + e / 100 );
+        e %= 100;
+        buffer[n++] = (char) ( '0' + e / 10 );
+    } else if ( e >= 10 ) {
+        buffer[n++] = (char) ( '0' + e / 10 );
+    }
+    buffer[n++] = (char) ( '0' + e % 10 );
+    return n;
+}
+
+/* Lays out len digits with decimal exponent k in plain or exponent notation */
+static int prettify ( char * buffer, int len, int k ) {
+
+    int kk = len + k; /* 10^(kk-1) <= v < 10^kk */
+
+    if ( k >= 0 && kk <= 21 ) {
+        /* 1234e7 -> 12340000000 */
+        memset(buffer + len, '0', k);
+        return kk;
+    } else if ( kk > 0 && kk <= 21 ) {
+        /* 1234e-2 -> 12.34 */
+        memmove(buffer + kk + 1, buffer + kk, len - kk);
+        buffer[kk] = '.';
+        return len + 1;
+    } else if ( kk > -6 && kk <= 0 ) {
+        /* 1234e-6 -> 0.001234 */
+        int offset = 2 - kk;
+        memmove(buffer + offset, buffer, len);
+        buffer[0] = '0';
+        buffer[1] = '.';
+        memset(buffer + 2, '0', offset - 2);
+        return len + offset;
+    } else if ( len == 1 ) {
+        /* 1e30 */
+        return 1 + write_exponent(kk - 1, buffer + 1);
+    } else {
+        /* 1234e30 -> 1.234e33 */
+        memmove(buffer + 2, buffer + 1, len - 1);
+        buffer[1] = '.';
+        return len + 1 + write_exponent(kk - 1, buffer + len + 1);
+    }
+
+}
+
+/* public functions **********************************************************/
+
+int grisu_format ( double value, char * buffer ) {
+
+    int n = 0;
+
+    if ( isnan(value) ) {
+        memcpy(buffer, "nan", 4);
+        return 3;
+    }
+    if ( signbit(value) ) {
+        buffer[n++] = '-';
+        value = -value;
+    }
+    if ( isinf(value) ) {
+        memcpy(buffer + n, "inf", 4);
+        return n + 3;
+    }
+    if ( value == 0 ) {
+        buffer[n++] = '0';
+        buffer[n] = '\0';
+        return n;
+    }
+
+    int k, len = grisu2(value, buffer + n, &k);
+    n += prettify(buffer + n, len, k);
+    buffer[n] = '\0';
+    return n;
+
+}
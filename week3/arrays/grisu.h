@@ -0,0 +1,24 @@
+#ifndef _GRISU
+#define _GRISU
+
+/*! @file
+ *  Shortest round-trip formatting of doubles with the Grisu2 algorithm
+ *  (Loitsch, "Printing Floating-Point Numbers Quickly and Accurately with
+ *  Integers", PLDI 2010). The output always parses back to the same double
+ *  with strtod, and is the shortest such decimal for almost all inputs.
+ */
+
+/*! The most characters grisu_format writes, including the terminating NUL */
+#define GRISU_BUFFER_SIZE 32
+
+/*! Writes the shortest decimal representation of value to buffer, followed by a NUL.
+ *  Integers below 1e21 are written without a fraction or exponent, numbers from
+ *  1e-6 up in plain decimal notation, and anything else as, e.g., 1.5e-7. Infinities
+ *  and NaN are written as inf, -inf and nan. Returns the number of characters
+ *  written, not counting the NUL.
+ *  \param value The number to format
+ *  \param buffer At least GRISU_BUFFER_SIZE characters
+ */
+int grisu_format ( double value, char * buffer );
+
+#endif
@@ -0,0 +1,100 @@
+#include <stdlib.h>
+#include <assert.h>
+
+#include "median_tracker.h"
+
+/* private functions *********************************************************/
+
+/* Both halves are min-heaps; the lower half stores negated values so that its
+   root is the largest value of the smaller half. */
+
+static void sift_up ( DynamicArray * heap, int i ) {
+    double v = DynamicArray_get(heap, i);
+    while ( i > 0 ) {
+        int parent = (i - 1) / 2;
+        double p = DynamicArray_get(heap, parent);
+        if ( p <= v ) break;
+        DynamicArray_set(heap, i, p);
+        i = parent;
+    }
+    DynamicArray_set(heap, i, v);
+}
+
+static void sift_down ( DynamicArray * heap, int i ) {
+    int n = DynamicArray_size(heap);
+    double v = DynamicArray_get(heap, i);
+    while ( 2 * i + 1 < n ) {
+        int child = 2 * i + 1;
+        if ( child + 1 < n && DynamicArray_get(heap, child+1) < DynamicArray_get(heap, child) ) {
+            child++;
+        }
+        double c = DynamicArray_get(heap, child);
+        if ( v <= c ) break;
+        DynamicArray_set(heap, i, c);
+        i = child;
+    }
+    DynamicArray_set(heap, i, v);
+}
+
+static void heap_push ( DynamicArray * heap, double value ) {
+    DynamicArray_push(heap, value);
+    sift_up(heap, DynamicArray_size(heap) - 1);
+}
+
+static double heap_pop ( DynamicArray * heap ) {
+    double top = DynamicArray_get(heap, 0),
+           last = DynamicArray_pop(heap);
+    if ( DynamicArray_size(heap) > 0 ) {
+        DynamicArray_set(heap, 0, last);
+        sift_down(heap, 0);
+    }
+    return top;
+}
+
+/* public functions **********************************************************/
+
+MedianTracker * MedianTracker_new(void) {
+    MedianTracker * mt = (MedianTracker *) malloc(sizeof(MedianTracker));
+    mt->lower = DynamicArray_new();
+    mt->upper = DynamicArray_new();
+    return mt;
+}
+
+void MedianTracker_destroy(MedianTracker * mt) {
+    DynamicArray_destroy(mt->lower);
+    DynamicArray_destroy(mt->upper);
+    free(mt);
+}
+
+void MedianTracker_push(MedianTracker * mt, double value) {
+    /* Keep size(lower) == size(upper) or size(upper) + 1 */
+    if ( DynamicArray_size(mt->lower) == 0 || value <= -DynamicArray_get(mt->lower, 0) ) {
+        heap_push(mt->lower, -value);
+    } else {
+        heap_push(mt->upper, value);
+    }
+    if ( DynamicArray_size(mt->lower) > DynamicArray_size(mt->upper) + 1 ) {
+        heap_push(mt->upper, -heap_pop(mt->lower));
+    } else if ( DynamicArray_size(mt->upper) > DynamicArray_size(mt->lower) ) {
+        heap_push(mt->lower, -heap_pop(mt->upper));
+    }
+}
+
+void MedianTracker_push_array(MedianTracker * mt, const DynamicArray * da) {
+    for ( int i=0; i<DynamicArray_size(da); i++ ) {
+        MedianTracker_push(mt, DynamicArray_get(da, i));
+    }
+}
+
+double MedianTracker_median(const MedianTracker * mt) {
+    assert(MedianTracker_size(mt) > 0);
+    if ( DynamicArray_size(mt->lower) > DynamicArray_size(mt->upper) ) {
+        return -DynamicArray_get(mt->lower, 0);
+    } else {
+        return ( -DynamicArray_get(mt->lower, 0) + DynamicArray_get(mt->upper, 0) ) / 2;
+    }
+}
+
+int MedianTracker_size(const MedianTracker * mt) {
+    return DynamicArray_size(mt->lower) + DynamicArray_size(mt->upper);
+}
@@ -0,0 +1,47 @@
+#ifndef _MEDIAN_TRACKER
+#define _MEDIAN_TRACKER
+
+#include "dynamic_array.h"
+
+/*! @file
+ *  A running median over a stream of values. The smaller half of the values is
+ *  kept in a max-heap and the larger half in a min-heap, both stored in dynamic
+ *  arrays, so each new value costs O(log n) and the median is available in O(1).
+ *  Feed a tracker the same values you DynamicArray_push onto the array it follows.
+ */
+typedef struct {
+    DynamicArray * lower, /* negated values of the smaller half, as a min-heap */
+                 * upper; /* the larger half, as a min-heap */
+} MedianTracker;
+
+/* Constructors / Destructors ************************************************/
+
+MedianTracker * MedianTracker_new(void);
+void MedianTracker_destroy(MedianTracker *);
+
+/* Operations ****************************************************************/
+
+/*! Adds a value to the tracker.
+ *  \param mt The tracker
+ *  \param value The new value
+ */
+void MedianTracker_push(MedianTracker * mt, double value);
+
+/*! Adds every element of an array to the tracker, e.g. to start tracking an array
+ *  that already has data.
+ *  \param mt The tracker
+ *  \param da The array
+ */
+void MedianTracker_push_array(MedianTracker * mt, const DynamicArray * da);
+
+/*! Returns the median of the values added so far. Asserts that there is at least one.
+ *  \param mt The tracker
+ */
+double MedianTracker_median(const MedianTracker * mt);
+
+/*! Returns the number of values added so far.
+ *  \param mt The tracker
+ */
+int MedianTracker_size(const MedianTracker * mt);
+
+#endif
@@ -0,0 +1,242 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+
+#include "segmented_array.h"
+#include "dynamic_array_simd.h"
+
+#define BLOCK_BITS SEGMENTED_ARRAY_BLOCK_BITS
+#define BLOCK_SIZE SEGMENTED_ARRAY_BLOCK_SIZE
+#define BLOCK_MASK (BLOCK_SIZE - 1)
+#define INITIAL_INDEX_CAPACITY 8
+
+/* private functions *********************************************************/
+
+/* Address of the element at position p, counting from the start of the first block */
+static double * slot ( const SegmentedArray * sa, int p ) {
+    return sa->blocks[sa->first_block + (p >> BLOCK_BITS)] + (p & BLOCK_MASK);
+}
+
+static double * new_block ( SegmentedArray * sa ) {
+    double * block = sa->spare;
+    if ( block != NULL ) {
+        sa->spare = NULL;
+    } else {
+        block = (double *) malloc(BLOCK_SIZE * sizeof(double));
+    }
+    return block;
+}
+
+static void release_block ( SegmentedArray * sa, double * block ) {
+    if ( sa->spare == NULL ) {
+        sa->spare = block;
+    } else {
+        free(block);
+    }
+}
+
+/* Makes room at both ends of the block index, centering the blocks in use. If
+   fewer than half the entries are in use, as when the array is used as a queue,
+   they are moved back to the middle; otherwise the index is doubled. Only block
+   pointers are copied, never elements. */
+static void grow_index ( SegmentedArray * sa ) {
+    if ( 2 * sa->num_blocks < sa->index_capacity ) {
+        int first = (sa->index_capacity - sa->num_blocks) / 2;
+        memmove(sa->blocks + first, sa->blocks + sa->first_block, sa->num_blocks * sizeof(double *));
+        sa->first_block = first;
+        return;
+    }
+    int capacity = 2 * sa->index_capacity,
+        first = (capacity - sa->num_blocks) / 2;
+    double ** index = (double **) malloc(capacity * sizeof(double *));
+    memcpy(index + first, sa->blocks + sa->first_block, sa->num_blocks * sizeof(double *));
+    free(sa->blocks);
+    sa->blocks = index;
+    sa->index_capacity = capacity;
+    sa->first_block = first;
+}
+
+static const DynamicArrayKernels * kernels ( void ) {
+    return dynamic_array_kernels(DynamicArray_get_simd_level());
+}
+
+/* public functions **********************************************************/
+
+SegmentedArray * SegmentedArray_new(void) {
+    SegmentedArray * sa = (SegmentedArray *) malloc(sizeof(SegmentedArray));
+    sa->index_capacity = INITIAL_INDEX_CAPACITY;
+    sa->blocks = (double **) malloc(sa->index_capacity * sizeof(double *));
+    sa->first_block = sa->index_capacity / 2;
+    sa->num_blocks = 1;
+    sa->spare = NULL;
+    sa->blocks[sa->first_block] = new_block(sa);
+    sa->origin = BLOCK_SIZE / 2;
+    sa->size = 0;
+    return sa;
+}
+
+void SegmentedArray_destroy(SegmentedArray * sa) {
+    for ( int b=0; b<sa->num_blocks; b++ ) {
+        free(sa->blocks[sa->first_block + b]);
+    }
+    free(sa->spare);
+    free(sa->blocks);
+    free(sa);
+}
+
+int SegmentedArray_size(const SegmentedArray * sa) {
+    return sa->size;
+}
+
+double SegmentedArray_get(const SegmentedArray * sa, int index) {
+    assert(index >= 0);
+    if ( index >= sa->size ) {
+        return 0;
+    } else {
+        return *slot(sa, sa->origin + index);
+    }
+}
+
+double * SegmentedArray_ptr(SegmentedArray * sa, int index) {
+    assert(index >= 0 && index < sa->size);
+    return slot(sa, sa->origin + index);
+}
+
+void SegmentedArray_set(SegmentedArray * sa, int index, double value) {
+    assert(index >= 0);
+    while ( sa->size < index ) {
+        SegmentedArray_push(sa, 0.0);
+    }
+    if ( index == sa->size ) {
+        SegmentedArray_push(sa, value);
+    } else {
+        *slot(sa, sa->origin + index) = value;
+    }
+}
+
+void SegmentedArray_push(SegmentedArray * sa, double value) {
+    int p = sa->origin + sa->size;
+    if ( (p >> BLOCK_BITS) == sa->num_blocks ) {
+        if ( sa->first_block + sa->num_blocks == sa->index_capacity ) {
+            grow_index(sa);
+        }
+        sa->blocks[sa->first_block + sa->num_blocks] = new_block(sa);
+        sa->num_blocks++;
+    }
+    *slot(sa, p) = value;
+    sa->size++;
+}
+
+void SegmentedArray_push_front(SegmentedArray * sa, double value) {
+    if ( sa->origin == 0 ) {
+        if ( sa->first_block == 0 ) {
+            grow_index(sa);
+        }
+        sa->first_block--;
+        sa->blocks[sa->first_block] = new_block(sa);
+        sa->num_blocks++;
+        sa->origin = BLOCK_SIZE;
+    }
+    sa->origin--;
+    sa->size++;
+    *slot(sa, sa->origin) = value;
+}
+
+double SegmentedArray_pop(SegmentedArray * sa) {
+    assert(sa->size > 0);
+    sa->size--;
+    double value = *slot(sa, sa->origin + sa->size);
+    int needed = (sa->origin + sa->size + BLOCK_MASK) >> BLOCK_BITS;
+    if ( sa->num_blocks > needed && sa->num_blocks > 1 ) {
+        sa->num_blocks--;
+        release_block(sa, sa->blocks[sa->first_block + sa->num_blocks]);
+    }
+    return value;
+}
+
+double SegmentedArray_pop_front(SegmentedArray * sa) {
+    assert(sa->size > 0);
+    double value = *slot(sa, sa->origin);
+    sa->origin++;
+    sa->size--;
+    if ( sa->origin == BLOCK_SIZE ) {
+        if ( sa->num_blocks > 1 ) {
+            release_block(sa, sa->blocks[sa->first_block]);
+            sa->first_block++;
+            sa->num_blocks--;
+            sa->origin = 0;
+        } else {
+            sa->origin = BLOCK_SIZE / 2; /* empty: start again mid-block */
+        }
+    }
+    return value;
+}
+
+SegmentedArrayIterator SegmentedArray_blocks(const SegmentedArray * sa) {
+    SegmentedArrayIterator it;
+    it.array = sa;
+    it.next = 0;
+    return it;
+}
+
+int SegmentedArrayIterator_next(SegmentedArrayIterator * it, const double ** data, int * length) {
+    const SegmentedArray * sa = it->array;
+    int end = sa->origin + sa->size;
+    while ( it->next < sa->num_blocks ) {
+        int b = it->next++,
+            lo = b == 0 ? sa->origin : 0,
+            hi = end - b * BLOCK_SIZE < BLOCK_SIZE ? end - b * BLOCK_SIZE : BLOCK_SIZE;
+        if ( hi > lo ) {
+            *data = sa->blocks[sa->first_block + b] + lo;
+            *length = hi - lo;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+double SegmentedArray_sum(const SegmentedArray * sa) {
+    const DynamicArrayKernels * k = kernels();
+    SegmentedArrayIterator it = SegmentedArray_blocks(sa);
+    const double * data;
+    int length;
+    double sum = 0;
+    while ( SegmentedArrayIterator_next(&it, &data, &length) ) {
+        sum += k->sum(data, length);
+    }
+    return sum;
+}
+
+double SegmentedArray_min(const SegmentedArray * sa) {
+    assert(sa->size > 0);
+    const DynamicArrayKernels * k = kernels();
+    SegmentedArrayIterator it = SegmentedArray_blocks(sa);
+    const double * data;
+    int length;
+    double m = SegmentedArray_get(sa, 0);
+    while ( SegmentedArrayIterator_next(&it, &data, &length) ) {
+        double b = k->min(data, length);
+        if ( b < m || isnan(b) ) m = b;
+    }
+    return m;
+}
+
+double SegmentedArray_max(const SegmentedArray * sa) {
+    assert(sa->size > 0);
+    const DynamicArrayKernels * k = kernels();
+    SegmentedArrayIterator it = SegmentedArray_blocks(sa);
+    const double * data;
+    int length;
+    double m = SegmentedArray_get(sa, 0);
+    while ( SegmentedArrayIterator_next(&it, &data, &length) ) {
+        double b = k->max(data, length);
+        if ( b > m || isnan(b) ) m = b;
+    }
+    return m;
+}
+
+double SegmentedArray_mean(const SegmentedArray * sa) {
+    assert(sa->size > 0);
+    return SegmentedArray_sum(sa) / sa->size;
+}
@@ -0,0 +1,80 @@
+#ifndef _SEGMENTED_ARRAY
+#define _SEGMENTED_ARRAY
+
+/*! @file
+ *  A double-ended array stored as fixed-size blocks behind a block index, like
+ *  a deque. Pushing at either end never moves existing elements, so pointers
+ *  to elements stay valid until the element is popped, and growth costs at most
+ *  a new block plus, rarely, a copy of the block index.
+ */
+
+#define SEGMENTED_ARRAY_BLOCK_BITS 12
+#define SEGMENTED_ARRAY_BLOCK_SIZE (1 << SEGMENTED_ARRAY_BLOCK_BITS) /* elements per block */
+
+typedef struct {
+    double ** blocks;  /* the block index */
+    int index_capacity,
+        first_block,   /* position in the index of the block holding element 0 */
+        num_blocks,    /* blocks in use */
+        origin,        /* position of element 0 within its block */
+        size;
+    double * spare;    /* an emptied block kept for reuse */
+} SegmentedArray;
+
+/*! Iterates over the elements a block at a time, so each run can be processed
+ *  with contiguous (e.g. vectorized) loops.
+ */
+typedef struct {
+    const SegmentedArray * array;
+    int next;          /* the next block, counting from the first in use */
+} SegmentedArrayIterator;
+
+/* Constructors / Destructors ************************************************/
+
+SegmentedArray * SegmentedArray_new(void);
+void SegmentedArray_destroy(SegmentedArray *);
+
+/* Getters / Setters *********************************************************/
+
+/*! Sets the element at index, extending the array with zeros if index is past the end.
+ */
+void SegmentedArray_set(SegmentedArray *, int index, double value);
+
+/*! Returns the element at index, or 0 if index is past the end.
+ */
+double SegmentedArray_get(const SegmentedArray *, int index);
+
+/*! Returns the address of the element at index, which stays valid until that element
+ *  is popped or the array is destroyed.
+ */
+double * SegmentedArray_ptr(SegmentedArray *, int index);
+
+int SegmentedArray_size(const SegmentedArray *);
+
+/* Operations ****************************************************************/
+
+void SegmentedArray_push(SegmentedArray *, double);
+void SegmentedArray_push_front(SegmentedArray *, double);
+double SegmentedArray_pop(SegmentedArray *);
+double SegmentedArray_pop_front(SegmentedArray *);
+
+/*! Returns an iterator positioned before the first block.
+ */
+SegmentedArrayIterator SegmentedArray_blocks(const SegmentedArray *);
+
+/*! Advances to the next non-empty run of elements. Returns 1 and sets data and
+ *  length if there is one, and 0 at the end.
+ *  \param it The iterator
+ *  \param data Receives the address of the run
+ *  \param length Receives the number of elements in the run
+ */
+int SegmentedArrayIterator_next(SegmentedArrayIterator * it, const double ** data, int * length);
+
+/*! Reductions, computed a block at a time with the same kernels as DynamicArray
+ */
+double SegmentedArray_min(const SegmentedArray *);
+double SegmentedArray_max(const SegmentedArray *);
+double SegmentedArray_sum(const SegmentedArray *);
+double SegmentedArray_mean(const SegmentedArray *);
+
+#endif
@@ -0,0 +1,122 @@
+#include <stdlib.h>
+#include <assert.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "thread_pool.h"
+
+typedef struct {
+    ThreadPool * pool;
+    int index;
+} Worker;
+
+struct ThreadPool {
+    int num_threads,
+        generation, /* incremented each time a task is started */
+        pending,    /* workers that have not finished the current task */
+        shutdown;
+    ThreadPool_task task;
+    void * arg;
+    pthread_mutex_t lock;
+    pthread_cond_t start,
+                   done;
+    pthread_t * threads;
+    Worker * workers;
+};
+
+/* private functions *********************************************************/
+
+static void * worker_loop ( void * p ) {
+
+    Worker * w = (Worker *) p;
+    ThreadPool * pool = w->pool;
+    int seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    while ( 1 ) {
+        while ( pool->generation == seen && !pool->shutdown ) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if ( pool->shutdown ) {
+            break;
+        }
+        seen = pool->generation;
+        ThreadPool_task task = pool->task;
+        void * arg = pool->arg;
+        pthread_mutex_unlock(&pool->lock);
+        task(arg, w->index, pool->num_threads);
+        pthread_mutex_lock(&pool->lock);
+        if ( --pool->pending == 0 ) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+
+}
+
+/* public functions **********************************************************/
+
+ThreadPool * ThreadPool_new(int num_threads) {
+    assert(num_threads >= 1);
+    ThreadPool * pool = (ThreadPool *) malloc(sizeof(ThreadPool));
+    pool->num_threads = num_threads;
+    pool->generation = 0;
+    pool->pending = 0;
+    pool->shutdown = 0;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pool->threads = (pthread_t *) malloc(num_threads * sizeof(pthread_t));
+    pool->workers = (Worker *) malloc(num_threads * sizeof(Worker));
+    for ( int i=1; i<num_threads; i++ ) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].index = i;
+        pthread_create(&pool->threads[i], NULL, worker_loop, &pool->workers[i]);
+    }
+    return pool;
+}
+
+void ThreadPool_destroy(ThreadPool * pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    for ( int i=1; i<pool->num_threads; i++ ) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+    free(pool->threads);
+    free(pool->workers);
+    free(pool);
+}
+
+void ThreadPool_run(ThreadPool * pool, ThreadPool_task task, void * arg) {
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->arg = arg;
+    pool->pending = pool->num_threads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    task(arg, 0, pool->num_threads);
+
+    pthread_mutex_lock(&pool->lock);
+    while ( pool->pending > 0 ) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+int ThreadPool_size(const ThreadPool * pool) {
+    return pool->num_threads;
+}
+
+int ThreadPool_num_processors(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int) n : 1;
+}
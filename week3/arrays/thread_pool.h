@@ -0,0 +1,40 @@
+#ifndef _THREAD_POOL
+#define _THREAD_POOL
+
+/*! @file
+ *  A fixed set of worker threads that run one task at a time, fork-join style.
+ *  The calling thread takes part as worker 0, so a pool of n threads starts n-1.
+ */
+
+typedef struct ThreadPool ThreadPool;
+
+/*! A task run by every worker of the pool.
+ *  \param arg The argument given to ThreadPool_run
+ *  \param worker The index of the worker, from 0 to num_workers-1
+ *  \param num_workers The number of workers in the pool
+ */
+typedef void (*ThreadPool_task) ( void * arg, int worker, int num_workers );
+
+/* Constructors / Destructors ************************************************/
+
+ThreadPool * ThreadPool_new(int num_threads);
+void ThreadPool_destroy(ThreadPool *);
+
+/* Operations ****************************************************************/
+
+/*! Runs task on every worker and returns once all of them have finished.
+ *  \param pool The pool
+ *  \param task The task
+ *  \param arg Passed to each call of task
+ */
+void ThreadPool_run(ThreadPool * pool, ThreadPool_task task, void * arg);
+
+/*! Returns the number of workers, including the calling thread.
+ */
+int ThreadPool_size(const ThreadPool * pool);
+
+/*! Returns the number of processors online, and at least 1.
+ */
+int ThreadPool_num_processors(void);
+
+#endif
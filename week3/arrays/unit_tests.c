@@ -1,10 +1,66 @@
 #include <math.h>
 #include <float.h> /* defines DBL_EPSILON */
+#include <unistd.h>
+#include <pthread.h>
+#include <signal.h>
+#include <errno.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
 #include "dynamic_array.h"
+#include "median_tracker.h"
+#include "dynamic_array_pipeline.h"
+#include "segmented_array.h"
+#include "compressed_array.h"
+#include "array_memory.h"
+#include "dynamic_array_registry.h"
+#include "dynamic_array_simd.h"
 #include "gtest/gtest.h"
 
 #define X 1.2345
 
+static int compare_doubles ( const void * a, const void * b ) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static double twice ( double x ) { return 2 * x; }
+static double plus_one ( double x ) { return x + 1; }
+static double add ( double x, double y ) { return x + y; }
+
+static void * create_and_destroy ( void * arg ) {
+    DynamicArray * keep[16];
+    for ( int i=0; i<100000; i++ ) {
+        DynamicArray * da = DynamicArray_new();
+        DynamicArray_push(da, i);
+        if ( i % 1000 < 16 ) {
+            keep[i % 1000] = da;
+        } else {
+            DynamicArray_destroy(da);
+        }
+        if ( i % 1000 == 999 ) {
+            for ( int j=0; j<16; j++ ) DynamicArray_destroy(keep[j]);
+        }
+    }
+    return arg;
+}
+
+/* Destroys, on a thread of its own, each batch of arrays the main thread makes */
+#define HANDOFF_BATCH 1000
+static DynamicArray * handoff[HANDOFF_BATCH];
+static pthread_barrier_t handoff_barrier;
+
+static void * destroy_handed_off ( void * arg ) {
+    long rounds = (long) arg;
+    for ( long r=0; r<rounds; r++ ) {
+        pthread_barrier_wait(&handoff_barrier);
+        for ( int i=0; i<HANDOFF_BATCH; i++ ) {
+            DynamicArray_destroy(handoff[i]);
+        }
+        pthread_barrier_wait(&handoff_barrier);
+    }
+    return arg;
+}
+
 namespace {
 
     TEST(DynamicArray, CreateAndDestroy) {
@@ -126,4 +182,974 @@ namespace {
         DynamicArray_destroy(y);                    
     }         
 
-}
\ No newline at end of file
+    TEST(DynamicArray, Reductions) {
+        DynamicArray * da = DynamicArray_new();
+        for ( int i=0; i<1001; i++ ) {
+            DynamicArray_push(da, (i * 37) % 1001 - 500);
+        }
+        DynamicArray_pop_front(da); /* makes the data start off a vector boundary */
+        DynamicArray_simd_level best = DynamicArray_get_simd_level();
+        for ( int level = DYNAMIC_ARRAY_SCALAR; level <= DYNAMIC_ARRAY_AVX512; level++ ) {
+            DynamicArray_set_simd_level((DynamicArray_simd_level) level);
+            ASSERT_EQ(DynamicArray_min(da), -499);
+            ASSERT_EQ(DynamicArray_max(da), 500);
+            ASSERT_EQ(DynamicArray_sum(da), 500);
+            ASSERT_DOUBLE_EQ(DynamicArray_mean(da), 0.5);
+        }
+        DynamicArray_set_simd_level(best);
+        DynamicArray_destroy(da);
+    }
+
+    TEST(DynamicArray, ReductionsWithNaN) {
+        /* Every level returns NaN for min and max wherever the NaN is */
+        DynamicArray_simd_level best = dynamic_array_best_simd_level();
+        double x[40];
+        for ( int level = DYNAMIC_ARRAY_SCALAR; level <= best; level++ ) {
+            const DynamicArrayKernels * k = dynamic_array_kernels((DynamicArray_simd_level) level);
+            for ( int n=1; n<=40; n++ ) {
+                double lo = 0, hi = 0;
+                for ( int i=0; i<n; i++ ) {
+                    x[i] = i % 4 == 0 ? i : 5;
+                    hi = x[i] > hi ? x[i] : hi;
+                }
+                ASSERT_EQ(k->min(x, n), lo) << level << " " << n;
+                ASSERT_EQ(k->max(x, n), hi) << level << " " << n;
+                for ( int nan=0; nan<n; nan++ ) {
+                    double saved = x[nan];
+                    x[nan] = NAN;
+                    ASSERT_TRUE(isnan(k->min(x, n))) << level << " " << n << " " << nan;
+                    ASSERT_TRUE(isnan(k->max(x, n))) << level << " " << n << " " << nan;
+                    x[nan] = saved;
+                }
+            }
+        }
+        /* A NaN is not cached, and is found again on the next call */
+        double values[] = { 1, 5, 5, 5, NAN, 5, 5, 5, 9, 5, 5, 5 };
+        DynamicArray * da = DynamicArray_new();
+        DynamicArray_cache_stats(da, 1);
+        for ( int i=0; i<12; i++ ) {
+            DynamicArray_push(da, values[i]);
+        }
+        ASSERT_TRUE(isnan(DynamicArray_min(da)));
+        ASSERT_TRUE(isnan(DynamicArray_max(da)));
+        DynamicArray_set(da, 4, 2);
+        ASSERT_EQ(DynamicArray_min(da), 1);
+        ASSERT_EQ(DynamicArray_max(da), 9);
+        DynamicArray_destroy(da);
+    }
+
+    TEST(DynamicArray, SmallReductions) {
+        DynamicArray * da = DynamicArray_new();
+        for ( int n=1; n<40; n++ ) {
+            DynamicArray_push_front(da, -n);
+            DynamicArray_push(da, n);
+            ASSERT_EQ(DynamicArray_min(da), -n);
+            ASSERT_EQ(DynamicArray_max(da), n);
+            ASSERT_EQ(DynamicArray_sum(da), 0);
+        }
+        DynamicArray_destroy(da);
+    }
+
+    TEST(DynamicArray, Median) {
+        DynamicArray * da = DynamicArray_new();
+        DynamicArray_push(da, 3);
+        ASSERT_EQ(DynamicArray_median(da), 3);
+        DynamicArray_push(da, 1);
+        ASSERT_EQ(DynamicArray_median(da), 2);
+        DynamicArray_push(da, 2);
+        ASSERT_EQ(DynamicArray_median(da), 2);
+        ASSERT_EQ(DynamicArray_get(da, 0), 3); /* unchanged */
+        DynamicArray_destroy(da);
+    }
+
+    TEST(DynamicArray, Quantiles) {
+        DynamicArray * da = DynamicArray_new();
+        int n = 5000;
+        double * sorted = (double *) malloc(n * sizeof(double));
+        for ( int i=0; i<n; i++ ) {
+            sorted[i] = rand() % 100; /* lots of repeated values */
+            DynamicArray_push(da, sorted[i]);
+        }
+        qsort(sorted, n, sizeof(double), compare_doubles);
+        double qs[] = { 0.9, 0, 0.25, 0.5, 0.5, 1, 0.3337 },
+               out[7];
+        DynamicArray_quantiles(da, qs, 7, out);
+        for ( int i=0; i<7; i++ ) {
+            double pos = qs[i] * (n-1);
+            int k = (int) pos;
+            double expected = k < n-1 ? sorted[k] + (pos-k) * (sorted[k+1] - sorted[k]) : sorted[k];
+            ASSERT_DOUBLE_EQ(out[i], expected);
+            ASSERT_DOUBLE_EQ(DynamicArray_quantile(da, qs[i]), expected);
+        }
+        free(sorted);
+        DynamicArray_destroy(da);
+    }
+
+    TEST(MedianTracker, Stream) {
+        DynamicArray * da = DynamicArray_new();
+        MedianTracker * mt = MedianTracker_new();
+        for ( int i=0; i<500; i++ ) {
+            double x = rand() % 1000;
+            DynamicArray_push(da, x);
+            MedianTracker_push(mt, x);
+            ASSERT_EQ(MedianTracker_size(mt), i+1);
+            ASSERT_DOUBLE_EQ(MedianTracker_median(mt), DynamicArray_median(da));
+        }
+        MedianTracker * copy = MedianTracker_new();
+        MedianTracker_push_array(copy, da);
+        ASSERT_DOUBLE_EQ(MedianTracker_median(copy), MedianTracker_median(mt));
+        MedianTracker_destroy(copy);
+        MedianTracker_destroy(mt);
+        DynamicArray_destroy(da);
+    }
+
+    TEST(DynamicArray, Reserve) {
+        DynamicArray * da = DynamicArray_new();
+        DynamicArray_push(da, X);
+        DynamicArray_reserve(da, 1000);
+        double * buffer = da->buffer;
+        for ( int i=1; i<1000; i++ ) {
+            DynamicArray_push(da, i);
+        }
+        ASSERT_EQ(da->buffer, buffer); /* no reallocation */
+        ASSERT_EQ(DynamicArray_get(da, 0), X);
+        ASSERT_EQ(DynamicArray_get(da, 999), 999);
+        DynamicArray_destroy(da);
+    }
+
+    TEST(DynamicArray, ShrinkToFit) {
+        DynamicArray * da = DynamicArray_new();
+        for ( int i=0; i<100; i++ ) {
+            DynamicArray_push_front(da, i);
+        }
+        DynamicArray_shrink_to_fit(da);
+        ASSERT_EQ(da->capacity, 100);
+        ASSERT_EQ(DynamicArray_get(da, 0), 99);
+        ASSERT_EQ(DynamicArray_get(da, 99), 0);
+        DynamicArray_push_front(da, X);
+        DynamicArray_push(da, X);
+        ASSERT_EQ(DynamicArray_size(da), 102);
+        ASSERT_EQ(DynamicArray_get(da, 1), 99);
+        DynamicArray_destroy(da);
+    }
+
+    TEST(DynamicArray, GrowthFactor) {
+        DynamicArray * da = DynamicArray_new();
+        DynamicArray_set_growth_factor(da, 1.5);
+        for ( int i=0; i<1000; i++ ) {
+            DynamicArray_push(da, i);
+        }
+        for ( int i=0; i<1000; i++ ) {
+            ASSERT_EQ(DynamicArray_get(da, i), i);
+        }
+        /* A single far index grows straight to the needed size */
+        DynamicArray_set(da, 100000, X);
+        ASSERT_EQ(da->capacity, da->origin + 100001);
+        ASSERT_EQ(DynamicArray_get(da, 50000), 0);
+        ASSERT_DEATH(DynamicArray_set_growth_factor(da, 1.0), ".*Assertion.*");
+        DynamicArray_destroy(da);
+    }
+
+    TEST(DynamicArray, Subarray) {
+        DynamicArray * da = DynamicArray_new();
+        for ( int i=0; i<10; i++ ) {
+            DynamicArray_push(da, i);
+        }
+        DynamicArray * view = DynamicArray_subarray(da, 2, 6);
+        ASSERT_EQ(view->buffer, da->buffer); /* nothing copied */
+        ASSERT_EQ(DynamicArray_size(view), 4);
+        ASSERT_EQ(DynamicArray_get(view, 0), 2);
+        ASSERT_EQ(DynamicArray_get(view, 4), 0);
+        ASSERT_EQ(DynamicArray_sum(view), 14);
+        ASSERT_EQ(DynamicArray_min(view), 2);
+        ASSERT_EQ(DynamicArray_max(view), 5);
+        ASSERT_EQ(DynamicArray_mean(view), 3.5);
+        char * str = DynamicArray_to_string(view);
+        ASSERT_STREQ(str, "[2.00000,3.00000,4.00000,5.00000]");
+        free(str);
+
+        /* Appending to the parent leaves the view alone */
+        DynamicArray_push(da, 10);
+        ASSERT_EQ(view->buffer, da->buffer);
+
+        /* Writing to the view copies it */
+        DynamicArray_set(view, 0, X);
+        ASSERT_NE(view->buffer, da->buffer);
+        ASSERT_EQ(DynamicArray_get(view, 0), X);
+        ASSERT_EQ(DynamicArray_get(da, 2), 2);
+
+        DynamicArray_destroy(view);
+        DynamicArray_destroy(da);
+    }
+
+    TEST(DynamicArray, SubarrayCopyOnWrite) {
+        DynamicArray * da = DynamicArray_new();
+        for ( int i=0; i<10; i++ ) {
+            DynamicArray_push(da, i);
+        }
+        DynamicArray * a = DynamicArray_subarray(da, 0, 5),
+                     * b = DynamicArray_subarray(a, 1, 3);
+        ASSERT_EQ(DynamicArray_get(b, 0), 1);
+
+        /* Changing a visible element of the parent copies the parent */
+        DynamicArray_set(da, 1, X);
+        ASSERT_EQ(DynamicArray_get(a, 1), 1);
+        ASSERT_EQ(DynamicArray_get(b, 0), 1);
+        DynamicArray_pop(da);
+        DynamicArray_destroy(da);
+
+        /* Once a is the last sharer it takes the buffer over */
+        DynamicArray_destroy(b);
+        double * buffer = a->buffer;
+        DynamicArray_set(a, 7, X);
+        ASSERT_EQ(a->buffer, buffer);
+        ASSERT_EQ(DynamicArray_get(a, 5), 0);
+        ASSERT_EQ(DynamicArray_get(a, 7), X);
+        DynamicArray_destroy(a);
+    }
+
+    TEST(DynamicArray, SubarrayPastEnd) {
+        DynamicArray * da = DynamicArray_new();
+        DynamicArray_push(da, 1);
+        DynamicArray_push(da, 2);
+        DynamicArray * view = DynamicArray_subarray(da, 1, 4);
+        ASSERT_EQ(DynamicArray_size(view), 3);
+        ASSERT_EQ(DynamicArray_get(view, 0), 2);
+        ASSERT_EQ(DynamicArray_get(view, 1), 0);
+        ASSERT_EQ(DynamicArray_get(view, 2), 0);
+        DynamicArray_destroy(view);
+        DynamicArray_destroy(da);
+    }
+
+    TEST(DynamicArray, MapInPlace) {
+        DynamicArray * da = DynamicArray_new();
+        for ( int i=0; i<4; i++ ) {
+            DynamicArray_push(da, 0.25 * i);
+        }
+        DynamicArray * view = DynamicArray_subarray(da, 0, 2);
+        DynamicArray_map_in_place(da, twice);
+        ASSERT_EQ(DynamicArray_get(da, 3), 1.5);
+        ASSERT_EQ(DynamicArray_get(view, 1), 0.25); /* the view keeps the old values */
+        DynamicArray_destroy(view);
+        DynamicArray_destroy(da);
+    }
+
+    TEST(DynamicArrayPipeline, Fused) {
+        int n = 3 * DYNAMIC_ARRAY_PARALLEL_THRESHOLD + 7;
+        DynamicArray * da = DynamicArray_new();
+        for ( int i=0; i<n; i++ ) {
+            DynamicArray_push(da, i % 100);
+        }
+        DynamicArrayPipeline * p = DynamicArrayPipeline_new();
+        DynamicArrayPipeline_map(p, twice);
+        DynamicArrayPipeline_map(p, plus_one);
+        for ( int threads=1; threads<=4; threads++ ) {
+            DynamicArrayPipeline_set_threads(p, threads);
+            DynamicArray * y = DynamicArrayPipeline_apply(p, da);
+            ASSERT_EQ(DynamicArray_size(y), n);
+            for ( int i=0; i<n; i++ ) {
+                ASSERT_EQ(DynamicArray_get(y, i), 2 * (i % 100) + 1);
+            }
+            ASSERT_EQ(DynamicArrayPipeline_reduce(p, da, add, 0), DynamicArray_sum(y));
+            DynamicArray_destroy(y);
+        }
+        DynamicArrayPipeline_apply_in_place(p, da);
+        ASSERT_EQ(DynamicArray_get(da, 199), 199);
+        DynamicArrayPipeline_destroy(p);
+        DynamicArray_destroy(da);
+    }
+
+    TEST(DynamicArray, Mapped) {
+        char path[64];
+        snprintf(path, sizeof(path), "/tmp/dynamic_array_test_%d.bin", (int) getpid());
+
+        DynamicArray * da = DynamicArray_create_mapped(path, 16);
+        ASSERT_TRUE(da != NULL);
+        ASSERT_TRUE(DynamicArray_is_mapped(da));
+        for ( int i=0; i<1000; i++ ) {
+            DynamicArray_push(da, i);           /* grows the file */
+        }
+        DynamicArray_push_front(da, -1);        /* moves the elements within it */
+        ASSERT_EQ(DynamicArray_size(da), 1001);
+        ASSERT_EQ(DynamicArray_sum(da), 499499);
+        DynamicArray * sub = DynamicArray_subarray(da, 1, 4);
+        ASSERT_FALSE(DynamicArray_is_mapped(sub));
+        ASSERT_EQ(DynamicArray_get(sub, 2), 2);
+        DynamicArray_destroy(sub);
+        ASSERT_EQ(DynamicArray_flush(da), 0);
+        DynamicArray_destroy(da);
+
+        da = DynamicArray_open_mapped(path);
+        ASSERT_TRUE(da != NULL);
+        ASSERT_EQ(DynamicArray_size(da), 1001);
+        ASSERT_EQ(DynamicArray_get(da, 0), -1);
+        ASSERT_EQ(DynamicArray_get(da, 1000), 999);
+        DynamicArray_pop(da);
+        DynamicArray_shrink_to_fit(da);
+        ASSERT_EQ(da->capacity, 1000);
+        DynamicArray_set(da, 1002, X);
+        ASSERT_EQ(DynamicArray_get(da, 1000), 0);
+        ASSERT_EQ(DynamicArray_get(da, 1002), X);
+        DynamicArray_destroy(da);
+
+        da = DynamicArray_open_mapped(path);
+        ASSERT_EQ(DynamicArray_size(da), 1003);
+        ASSERT_EQ(DynamicArray_get(da, 999), 998);
+        DynamicArray_destroy(da);
+
+        ASSERT_TRUE(DynamicArray_open_mapped("/nonexistent/dynamic_array.bin") == NULL);
+        unlink(path);
+    }
+
+    TEST(DynamicArray, MappedGrowFailure) {
+        char path[64];
+        snprintf(path, sizeof(path), "/tmp/dynamic_array_test_%d.bin", (int) getpid());
+        DynamicArray * da = DynamicArray_create_mapped(path, 16);
+        for ( int i=0; i<16; i++ ) {
+            DynamicArray_push(da, i);
+        }
+
+        /* A file size limit makes extending the file fail, as a full disk would */
+        struct rlimit old_limit, limit;
+        getrlimit(RLIMIT_FSIZE, &old_limit);
+        limit = old_limit;
+        struct stat st;
+        stat(path, &st);
+        limit.rlim_cur = st.st_size;
+        void (*old_handler) (int) = signal(SIGXFSZ, SIG_IGN);
+        setrlimit(RLIMIT_FSIZE, &limit);
+
+        ASSERT_EQ(DynamicArray_reserve(da, 1000), -1);
+        ASSERT_EQ(errno, EFBIG);
+        DynamicArray_push(da, X);
+        DynamicArray_set(da, 2000, X);
+        ASSERT_EQ(DynamicArray_size(da), 16);
+        ASSERT_EQ(da->capacity, 16);
+        ASSERT_EQ(DynamicArray_sum(da), 120);
+
+        setrlimit(RLIMIT_FSIZE, &old_limit);
+        signal(SIGXFSZ, old_handler);
+        DynamicArray_push(da, X);
+        ASSERT_EQ(DynamicArray_size(da), 17);
+        DynamicArray_destroy(da);
+        unlink(path);
+    }
+
+    TEST(DynamicArray, ToStringEdgeCases) {
+        DynamicArray * da = DynamicArray_new();
+        char * str = DynamicArray_to_string(da);
+        ASSERT_STREQ(str, "[]");
+        free(str);
+        DynamicArray_push(da, 0);
+        DynamicArray_push(da, -DBL_MAX);
+        str = DynamicArray_to_string(da);
+        ASSERT_EQ(strncmp(str, "[0,-17976931348623157", 21), 0);
+        ASSERT_EQ(str[strlen(str)-1], ']');
+        free(str);
+        DynamicArray_destroy(da);
+    }
+
+    TEST(DynamicArray, FormatDouble) {
+        char buffer[32];
+        double values[] = { 0.1, 1.0/3, -2.5e-300, 123456789, 1e21, 5e-324, DBL_MAX };
+        for ( int i=0; i<7; i++ ) {
+            DynamicArray_format_double(values[i], buffer);
+            ASSERT_EQ(strtod(buffer, NULL), values[i]);
+        }
+        ASSERT_EQ(DynamicArray_format_double(0.1, buffer), 3);
+        ASSERT_STREQ(buffer, "0.1");
+        DynamicArray_format_double(-1.5e-7, buffer);
+        ASSERT_STREQ(buffer, "-1.5e-7");
+        DynamicArray_format_double(1e20, buffer);
+        ASSERT_STREQ(buffer, "100000000000000000000");
+    }
+
+    TEST(DynamicArray, WriteText) {
+        DynamicArray * da = DynamicArray_new();
+        DynamicArray_push(da, 1);
+        DynamicArray_push(da, 0.25);
+        DynamicArray_push(da, -3e-7);
+        char * text = NULL;
+        size_t size = 0;
+        FILE * f = open_memstream(&text, &size);
+        ASSERT_EQ(DynamicArray_write(da, f), 14);
+        fclose(f);
+        ASSERT_STREQ(text, "[1,0.25,-3e-7]");
+        free(text);
+        DynamicArray_destroy(da);
+    }
+
+    TEST(DynamicArray, SaveAndLoad) {
+        DynamicArray * da = DynamicArray_new();
+        for ( int i=0; i<100000; i++ ) {
+            DynamicArray_push_front(da, i / 7.0);
+        }
+        FILE * f = tmpfile();
+        ASSERT_EQ(DynamicArray_save(da, f), 0);
+        rewind(f);
+        unsigned char magic[5] = { 0 };
+        ASSERT_EQ(fread(magic, 1, 4, f), 4u);
+        ASSERT_STREQ((char *) magic, "DArr");
+        rewind(f);
+        DynamicArray * copy = DynamicArray_load(f);
+        ASSERT_TRUE(copy != NULL);
+        ASSERT_EQ(DynamicArray_size(copy), 100000);
+        for ( int i=0; i<100000; i++ ) {
+            ASSERT_EQ(DynamicArray_get(copy, i), DynamicArray_get(da, i));
+        }
+        ASSERT_TRUE(DynamicArray_load(f) == NULL); /* at end of file */
+        fclose(f);
+        DynamicArray_destroy(copy);
+        DynamicArray_destroy(da);
+    }
+
+    TEST(DynamicArray, LoadBadCount) {
+        DynamicArray * da = DynamicArray_new();
+        for ( int i=0; i<10; i++ ) {
+            DynamicArray_push(da, i);
+        }
+        FILE * f = tmpfile();
+        ASSERT_EQ(DynamicArray_save(da, f), 0);
+        /* Claims far more elements than follow the header, up to the largest count
+           accepted */
+        unsigned char count[8] = { 0xFF, 0xFF, 0xFF, 0x7F, 0, 0, 0, 0 };
+        fseek(f, 8, SEEK_SET);
+        ASSERT_EQ(fwrite(count, 1, 8, f), 8u);
+        rewind(f);
+        ASSERT_TRUE(DynamicArray_load(f) == NULL);
+        count[0] = 11;
+        count[1] = count[2] = count[3] = 0;
+        fseek(f, 8, SEEK_SET);
+        ASSERT_EQ(fwrite(count, 1, 8, f), 8u);
+        rewind(f);
+        ASSERT_TRUE(DynamicArray_load(f) == NULL);
+        /* The right count loads, and the result grows at both ends */
+        count[0] = 10;
+        fseek(f, 8, SEEK_SET);
+        ASSERT_EQ(fwrite(count, 1, 8, f), 8u);
+        rewind(f);
+        DynamicArray * copy = DynamicArray_load(f);
+        ASSERT_TRUE(copy != NULL);
+        DynamicArray_push_front(copy, -1);
+        DynamicArray_push(copy, 10);
+        ASSERT_EQ(DynamicArray_size(copy), 12);
+        ASSERT_EQ(DynamicArray_get(copy, 0), -1);
+        ASSERT_EQ(DynamicArray_get(copy, 10), 9);
+        ASSERT_EQ(DynamicArray_get(copy, 11), 10);
+        fclose(f);
+        DynamicArray_destroy(copy);
+        DynamicArray_destroy(da);
+    }
+
+    TEST(DynamicArray, Registry) {
+        int before = DynamicArray_num_arrays();
+        DynamicArray * a = DynamicArray_new(),
+                     * b = DynamicArray_new(),
+                     * c = DynamicArray_subarray(a, 0, 0);
+        ASSERT_EQ(DynamicArray_num_arrays(), before + 3);
+        ASSERT_TRUE(DynamicArray_is_valid(a));
+        ASSERT_TRUE(DynamicArray_is_valid(c));
+        DynamicArray_destroy(b);
+        ASSERT_EQ(DynamicArray_num_arrays(), before + 2);
+        DynamicArray_destroy_all();
+        ASSERT_EQ(DynamicArray_num_arrays(), 0);
+    }
+
+    TEST(DynamicArray, RegistryThreads) {
+        int before = DynamicArray_num_arrays();
+        pthread_t threads[4];
+        for ( int t=0; t<4; t++ ) {
+            pthread_create(&threads[t], NULL, create_and_destroy, NULL);
+        }
+        for ( int t=0; t<4; t++ ) {
+            pthread_join(threads[t], NULL);
+        }
+        ASSERT_EQ(DynamicArray_num_arrays(), before);
+        /* Headers freed by the exited threads are reused */
+        DynamicArray * da = DynamicArray_new();
+        ASSERT_EQ(DynamicArray_num_arrays(), before + 1);
+        DynamicArray_destroy(da);
+    }
+
+    TEST(DynamicArray, RegistryHandoff) {
+        /* Headers freed on one thread go back to the one that makes them, rather
+           than piling up, so making 100000 arrays needs only a few slabs */
+        long rounds = 100;
+        int slabs = dynamic_array_slab_count();
+        pthread_t consumer;
+        pthread_barrier_init(&handoff_barrier, NULL, 2);
+        pthread_create(&consumer, NULL, destroy_handed_off, (void *) rounds);
+        for ( long r=0; r<rounds; r++ ) {
+            for ( int i=0; i<HANDOFF_BATCH; i++ ) {
+                handoff[i] = DynamicArray_new();
+            }
+            pthread_barrier_wait(&handoff_barrier);
+            pthread_barrier_wait(&handoff_barrier);
+        }
+        pthread_join(consumer, NULL);
+        pthread_barrier_destroy(&handoff_barrier);
+        ASSERT_LE(dynamic_array_slab_count() - slabs, 4);
+    }
+
+    TEST(DynamicArray, RingQueue) {
+        DynamicArray * da = DynamicArray_new();
+        DynamicArray_push(da, 1);
+        DynamicArray_push(da, 2);
+        DynamicArray_set_ring(da, 1);
+        ASSERT_TRUE(DynamicArray_is_ring(da));
+        ASSERT_EQ(DynamicArray_size(da), 2);
+        int capacity = da->capacity;
+        /* A queue of bounded length wraps around without growing */
+        for ( int i=3; i<100000; i++ ) {
+            DynamicArray_push(da, i);
+            ASSERT_EQ(DynamicArray_pop_front(da), i - 2);
+        }
+        ASSERT_EQ(da->capacity, capacity);
+        ASSERT_EQ(DynamicArray_size(da), 2);
+        ASSERT_EQ(DynamicArray_get(da, 0), 99998);
+        ASSERT_EQ(DynamicArray_get(da, 1), 99999);
+        /* Growing past the capacity keeps the order */
+        for ( int i=0; i<capacity; i++ ) {
+            DynamicArray_push_front(da, -i);
+        }
+        ASSERT_GT(da->capacity, capacity);
+        ASSERT_EQ(DynamicArray_size(da), capacity + 2);
+        ASSERT_EQ(DynamicArray_get(da, 0), 1 - capacity);
+        ASSERT_EQ(DynamicArray_get(da, capacity + 1), 99999);
+        DynamicArray_set_ring(da, 0);
+        ASSERT_FALSE(DynamicArray_is_ring(da));
+        ASSERT_EQ(DynamicArray_get(da, 0), 1 - capacity);
+        ASSERT_EQ(DynamicArray_pop(da), 99999);
+        DynamicArray_destroy(da);
+    }
+
+    TEST(DynamicArray, RingMapFailure) {
+        DynamicArray * da = DynamicArray_new();
+        DynamicArray_push(da, 1);
+        DynamicArray_push(da, 2);
+        /* With no file descriptors left the memory file cannot be created */
+        struct rlimit saved, none;
+        getrlimit(RLIMIT_NOFILE, &saved);
+        none = saved;
+        none.rlim_cur = 0;
+        setrlimit(RLIMIT_NOFILE, &none);
+        errno = 0;
+        int status = DynamicArray_set_ring(da, 1);
+        int error = errno;
+        setrlimit(RLIMIT_NOFILE, &saved);
+        ASSERT_EQ(status, -1);
+        ASSERT_EQ(error, EMFILE);
+        ASSERT_FALSE(DynamicArray_is_ring(da));
+        ASSERT_EQ(DynamicArray_size(da), 2);
+        ASSERT_EQ(DynamicArray_get(da, 1), 2);
+        /* A ring that cannot grow is left as it was */
+        ASSERT_EQ(DynamicArray_set_ring(da, 1), 0);
+        int capacity = da->capacity;
+        setrlimit(RLIMIT_NOFILE, &none);
+        status = DynamicArray_reserve(da, 2 * capacity);
+        setrlimit(RLIMIT_NOFILE, &saved);
+        ASSERT_EQ(status, -1);
+        ASSERT_EQ(da->capacity, capacity);
+        ASSERT_EQ(DynamicArray_get(da, 0), 1);
+        /* A view that cannot map a ring of its own leaves ring mode when written */
+        DynamicArray * view = DynamicArray_subarray(da, 0, 2);
+        setrlimit(RLIMIT_NOFILE, &none);
+        DynamicArray_set(view, 0, X);
+        setrlimit(RLIMIT_NOFILE, &saved);
+        ASSERT_FALSE(DynamicArray_is_ring(view));
+        ASSERT_EQ(DynamicArray_get(view, 0), X);
+        ASSERT_EQ(DynamicArray_get(view, 1), 2);
+        ASSERT_EQ(DynamicArray_get(da, 0), 1);
+        DynamicArray_destroy(view);
+        DynamicArray_destroy(da);
+    }
+
+    TEST(DynamicArray, RingWrapped) {
+        DynamicArray * da = DynamicArray_new();
+        DynamicArray_set_ring(da, 1);
+        int capacity = da->capacity;
+        /* Leave the elements straddling the end of the ring */
+        for ( int i=0; i<capacity-5; i++ ) {
+            DynamicArray_push(da, 0);
+            DynamicArray_pop_front(da);
+        }
+        for ( int i=0; i<10; i++ ) {
+            DynamicArray_push(da, i);
+        }
+        ASSERT_DOUBLE_EQ(DynamicArray_sum(da), 45);
+        ASSERT_EQ(DynamicArray_min(da), 0);
+        ASSERT_EQ(DynamicArray_max(da), 9);
+        DynamicArray * view = DynamicArray_subarray(da, 3, 8);
+        char * str = DynamicArray_to_string(view);
+        ASSERT_STREQ(str, "[3.00000,4.00000,5.00000,6.00000,7.00000]");
+        free(str);
+        /* Writes to the view copy it, and leave the original alone */
+        DynamicArray_push_front(view, X);
+        DynamicArray_set(da, 4, -1);
+        ASSERT_EQ(DynamicArray_get(view, 0), X);
+        ASSERT_EQ(DynamicArray_get(view, 2), 4);
+        ASSERT_EQ(DynamicArray_get(da, 3), 3);
+        ASSERT_EQ(DynamicArray_get(da, 4), -1);
+        DynamicArray_destroy(view);
+        DynamicArray_destroy(da);
+    }
+
+    TEST(DynamicArray, RangeAndConcat) {
+        DynamicArray * a = DynamicArray_range(0, 1, 0.1);
+        ASSERT_EQ(DynamicArray_size(a), 11);
+        ASSERT_EQ(a->capacity, 11);
+        char * str = DynamicArray_to_string(a);
+        ASSERT_STREQ(str,
+            "[0,0.10000,0.20000,0.30000,0.40000,0.50000,0.60000,0.70000,0.80000,0.90000,1.00000]");
+        free(str);
+        ASSERT_DOUBLE_EQ(DynamicArray_get(a, 7), 0.7);
+        DynamicArray * b = DynamicArray_range(3, 0, -1.5);
+        str = DynamicArray_to_string(b);
+        ASSERT_STREQ(str, "[3.00000,1.50000,0]");
+        free(str);
+        DynamicArray * e = DynamicArray_range(1, 0, 1);
+        ASSERT_EQ(DynamicArray_size(e), 0);
+        DynamicArray * c = DynamicArray_concat(a, b);
+        ASSERT_EQ(DynamicArray_size(c), 14);
+        ASSERT_EQ(c->capacity, 14);
+        ASSERT_EQ(DynamicArray_get(c, 10), 1);
+        ASSERT_EQ(DynamicArray_get(c, 11), 3);
+        DynamicArray * d = DynamicArray_concat(e, e);
+        ASSERT_EQ(DynamicArray_size(d), 0);
+        DynamicArray_push_front(d, 1);
+        ASSERT_EQ(DynamicArray_get(d, 0), 1);
+        DynamicArray_destroy(a);
+        DynamicArray_destroy(b);
+        DynamicArray_destroy(c);
+        DynamicArray_destroy(d);
+        DynamicArray_destroy(e);
+    }
+
+    TEST(DynamicArray, AppendMove) {
+        DynamicArray * src = DynamicArray_range(1, 5, 1),
+                     * dst = DynamicArray_new();
+        double * buffer = src->buffer;
+        DynamicArray_append_move(dst, src);
+        ASSERT_EQ(dst->buffer, buffer);
+        ASSERT_EQ(DynamicArray_size(dst), 5);
+        ASSERT_EQ(DynamicArray_size(src), 0);
+        /* src is empty but still usable */
+        DynamicArray_push(src, 6);
+        DynamicArray_push(src, 7);
+        DynamicArray_append_move(dst, src);
+        ASSERT_EQ(DynamicArray_size(dst), 7);
+        ASSERT_EQ(DynamicArray_get(dst, 6), 7);
+        ASSERT_EQ(DynamicArray_size(src), 0);
+        ASSERT_EQ(DynamicArray_get(src, 0), 0);
+        /* A view is copied from, and the array it looks at is left alone */
+        DynamicArray * view = DynamicArray_subarray(dst, 0, 2);
+        DynamicArray_append_move(dst, view);
+        ASSERT_EQ(DynamicArray_size(dst), 9);
+        ASSERT_EQ(DynamicArray_get(dst, 8), 2);
+        ASSERT_EQ(DynamicArray_size(view), 0);
+        ASSERT_EQ(DynamicArray_get(dst, 0), 1);
+        DynamicArray_destroy(view);
+        DynamicArray_destroy(src);
+        DynamicArray_destroy(dst);
+    }
+
+    TEST(DynamicArray, Sort) {
+        DynamicArray * da = DynamicArray_new();
+        double values[] = { 3, -1.5, 0, 2e300, -0.0, -2e-300, 7, 3, -1e10, 5e-324 };
+        for ( int i=0; i<10; i++ ) {
+            DynamicArray_push(da, values[i]);
+        }
+        DynamicArray_sort(da);
+        qsort(values, 10, sizeof(double), compare_doubles);
+        for ( int i=0; i<10; i++ ) {
+            ASSERT_EQ(DynamicArray_get(da, i), values[i]);
+        }
+        ASSERT_TRUE(signbit(DynamicArray_get(da, 3)));
+        DynamicArray_destroy(da);
+        /* Large enough for the radix passes, with equal high bytes */
+        da = DynamicArray_new();
+        for ( int i=0; i<1000; i++ ) {
+            DynamicArray_push(da, ( (i * 7919) % 1000 ) - 500.25);
+        }
+        DynamicArray * view = DynamicArray_subarray(da, 0, 3);
+        DynamicArray_sort(da);
+        for ( int i=0; i<1000; i++ ) {
+            ASSERT_EQ(DynamicArray_get(da, i), i - 500.25);
+        }
+        ASSERT_EQ(DynamicArray_get(view, 0), -500.25);
+        ASSERT_EQ(DynamicArray_get(view, 1), ( 7919 % 1000 ) - 500.25);
+        DynamicArray_destroy(view);
+        DynamicArray_destroy(da);
+    }
+
+    TEST(DynamicArray, SortedOperations) {
+        DynamicArray * a = DynamicArray_new(),
+                     * b = DynamicArray_range(0, 10, 2.5);
+        double values[] = { 1, 1, 2, 3, 3, 3, 8 };
+        for ( int i=0; i<7; i++ ) {
+            DynamicArray_push(a, values[i]);
+        }
+        ASSERT_EQ(DynamicArray_lower_bound(a, 3), 3);
+        ASSERT_EQ(DynamicArray_lower_bound(a, 2.5), 3);
+        ASSERT_EQ(DynamicArray_lower_bound(a, 0), 0);
+        ASSERT_EQ(DynamicArray_lower_bound(a, 9), 7);
+        DynamicArray * c = DynamicArray_merge(a, b);
+        char * str = DynamicArray_to_string(c);
+        ASSERT_STREQ(str,
+            "[0,1.00000,1.00000,2.00000,2.50000,3.00000,3.00000,3.00000,5.00000,7.50000,8.00000,10.00000]");
+        free(str);
+        DynamicArray_unique(a);
+        str = DynamicArray_to_string(a);
+        ASSERT_STREQ(str, "[1.00000,2.00000,3.00000,8.00000]");
+        free(str);
+        ASSERT_EQ(DynamicArray_get(a, 4), 0);
+        DynamicArray_destroy(a);
+        DynamicArray_destroy(b);
+        DynamicArray_destroy(c);
+    }
+
+    TEST(DynamicArray, CachedStats) {
+        DynamicArray * da = DynamicArray_range(1, 10, 1);
+        DynamicArray_cache_stats(da, 1);
+        ASSERT_EQ(DynamicArray_sum(da), 55);
+        ASSERT_EQ(DynamicArray_min(da), 1);
+        ASSERT_EQ(DynamicArray_max(da), 10);
+        ASSERT_TRUE(da->stats->has_sum && da->stats->has_min && da->stats->has_max);
+        /* Adding elements keeps everything */
+        DynamicArray_push(da, 20);
+        DynamicArray_push_front(da, -1);
+        ASSERT_TRUE(da->stats->has_sum && da->stats->has_min && da->stats->has_max);
+        ASSERT_EQ(DynamicArray_sum(da), 74);
+        ASSERT_EQ(DynamicArray_min(da), -1);
+        ASSERT_EQ(DynamicArray_max(da), 20);
+        /* Removing an extremum drops just that one */
+        ASSERT_EQ(DynamicArray_pop(da), 20);
+        ASSERT_TRUE(da->stats->has_sum && da->stats->has_min);
+        ASSERT_FALSE(da->stats->has_max);
+        ASSERT_EQ(DynamicArray_max(da), 10);
+        ASSERT_EQ(DynamicArray_pop_front(da), -1);
+        ASSERT_FALSE(da->stats->has_min);
+        ASSERT_EQ(DynamicArray_min(da), 1);
+        /* Overwriting, and padding with zeros */
+        DynamicArray_set(da, 4, 50);
+        ASSERT_EQ(DynamicArray_mean(da), 10);
+        ASSERT_EQ(DynamicArray_max(da), 50);
+        DynamicArray_set(da, 12, 2);
+        ASSERT_EQ(DynamicArray_sum(da), 102);
+        ASSERT_EQ(DynamicArray_min(da), 0);
+        DynamicArray_push_front(da, 4);
+        ASSERT_EQ(DynamicArray_sum(da), 106);
+        /* Other changes clear the cache */
+        DynamicArray_map_in_place(da, twice);
+        ASSERT_FALSE(da->stats->has_sum || da->stats->has_min || da->stats->has_max);
+        ASSERT_EQ(DynamicArray_sum(da), 212);
+        ASSERT_EQ(DynamicArray_min(da), 0);
+        ASSERT_EQ(DynamicArray_max(da), 100);
+        DynamicArray_cache_stats(da, 0);
+        ASSERT_EQ(da->stats, (DynamicArrayStats *) NULL);
+        ASSERT_EQ(DynamicArray_sum(da), 212);
+        DynamicArray_destroy(da);
+    }
+
+    TEST(DynamicArray, AlignedBuffers) {
+        DynamicArray * da = DynamicArray_new();
+        ASSERT_EQ((uintptr_t) da->buffer % ARRAY_MEMORY_ALIGNMENT, 0);
+        for ( int i=0; i<1000; i++ ) {
+            DynamicArray_push(da, i);
+        }
+        ASSERT_EQ((uintptr_t) da->buffer % ARRAY_MEMORY_ALIGNMENT, 0);
+        /* Large buffers sit on huge page boundaries, through every regrowth */
+        DynamicArray_reserve(da, 1 << 20);
+        ASSERT_EQ((uintptr_t) da->buffer % ARRAY_MEMORY_HUGE_PAGE, 0);
+        DynamicArray_set(da, 3 << 20, 1);
+        ASSERT_EQ((uintptr_t) da->buffer % ARRAY_MEMORY_HUGE_PAGE, 0);
+        ASSERT_EQ(DynamicArray_get(da, 999), 999);
+        ASSERT_EQ(DynamicArray_get(da, 2 << 20), 0);
+        ASSERT_EQ(DynamicArray_sum(da), 999 * 500 + 1);
+        DynamicArray_shrink_to_fit(da);
+        ASSERT_EQ(DynamicArray_get(da, 3 << 20), 1);
+        DynamicArray_destroy(da);
+        DynamicArray * range = DynamicArray_range(0, 1 << 20, 1);
+        ASSERT_EQ((uintptr_t) range->buffer % ARRAY_MEMORY_HUGE_PAGE, 0);
+        ASSERT_EQ(DynamicArray_get(range, 1 << 20), 1 << 20);
+        DynamicArray_destroy(range);
+    }
+
+    TEST(SegmentedArray, PushAndPop) {
+        SegmentedArray * sa = SegmentedArray_new();
+        int n = 3 * SEGMENTED_ARRAY_BLOCK_SIZE;
+        SegmentedArray_push(sa, 0);
+        double * first = SegmentedArray_ptr(sa, 0);
+        for ( int i=1; i<=n; i++ ) {
+            SegmentedArray_push(sa, i);
+            SegmentedArray_push_front(sa, -i);
+        }
+        ASSERT_EQ(SegmentedArray_size(sa), 2 * n + 1);
+        ASSERT_EQ(SegmentedArray_ptr(sa, n), first); /* never moved */
+        ASSERT_EQ(SegmentedArray_get(sa, 0), -n);
+        ASSERT_EQ(SegmentedArray_get(sa, 2 * n), n);
+        ASSERT_EQ(SegmentedArray_get(sa, 2 * n + 1), 0);
+        ASSERT_EQ(SegmentedArray_sum(sa), 0);
+        ASSERT_EQ(SegmentedArray_min(sa), -n);
+        ASSERT_EQ(SegmentedArray_max(sa), n);
+        for ( int i=n; i>0; i-- ) {
+            ASSERT_EQ(SegmentedArray_pop(sa), i);
+            ASSERT_EQ(SegmentedArray_pop_front(sa), -i);
+        }
+        ASSERT_EQ(SegmentedArray_size(sa), 1);
+        ASSERT_EQ(SegmentedArray_pop_front(sa), 0);
+        ASSERT_DEATH(SegmentedArray_pop(sa), ".*Assertion.*");
+        SegmentedArray_destroy(sa);
+    }
+
+    TEST(SegmentedArray, SetAndBlocks) {
+        SegmentedArray * sa = SegmentedArray_new();
+        SegmentedArray_set(sa, 10000, X);
+        SegmentedArray_set(sa, 3, 1);
+        ASSERT_EQ(SegmentedArray_size(sa), 10001);
+        ASSERT_EQ(SegmentedArray_get(sa, 2), 0);
+        ASSERT_EQ(SegmentedArray_get(sa, 3), 1);
+        ASSERT_EQ(SegmentedArray_get(sa, 10000), X);
+        SegmentedArrayIterator it = SegmentedArray_blocks(sa);
+        const double * data;
+        int length, total = 0, runs = 0;
+        while ( SegmentedArrayIterator_next(&it, &data, &length) ) {
+            ASSERT_LE(length, SEGMENTED_ARRAY_BLOCK_SIZE);
+            total += length;
+            runs++;
+        }
+        ASSERT_EQ(total, 10001);
+        ASSERT_EQ(runs, 3); /* starts mid-block, then one full and one partial block */
+        ASSERT_DOUBLE_EQ(SegmentedArray_mean(sa), (1 + X) / 10001);
+        SegmentedArray_destroy(sa);
+    }
+
+    TEST(SegmentedArray, QueueReusesIndex) {
+        SegmentedArray * sa = SegmentedArray_new();
+        for ( int i=0; i<100 * SEGMENTED_ARRAY_BLOCK_SIZE; i++ ) {
+            SegmentedArray_push(sa, i);
+            if ( i >= SEGMENTED_ARRAY_BLOCK_SIZE ) {
+                ASSERT_EQ(SegmentedArray_pop_front(sa), i - SEGMENTED_ARRAY_BLOCK_SIZE);
+            }
+        }
+        ASSERT_EQ(SegmentedArray_size(sa), SEGMENTED_ARRAY_BLOCK_SIZE);
+        ASSERT_EQ(sa->index_capacity, 8); /* recentered, never doubled */
+        SegmentedArray_destroy(sa);
+    }
+
+    TEST(CompressedArray, RoundTrip) {
+        CompressedArray * ca = CompressedArray_new();
+        DynamicArray * da = DynamicArray_new();
+        double special[] = { 0, -0.0, 1e-310, -INFINITY, 1e300, 3 };
+        for ( int i=0; i<6; i++ ) {
+            DynamicArray_push(da, special[i]);
+        }
+        /* A slowly varying reading that often repeats */
+        double reading = 20;
+        for ( int i=0; i<5000; i++ ) {
+            if ( i % 7 == 0 ) {
+                reading += ( (i * 7919) % 21 - 10 ) / 100.0;
+            }
+            DynamicArray_push(da, reading);
+        }
+        CompressedArray_push(ca, DynamicArray_get(da, 0));
+        DynamicArray * rest = DynamicArray_subarray(da, 1, DynamicArray_size(da));
+        CompressedArray_push_array(ca, rest);
+        int n = DynamicArray_size(da);
+        ASSERT_EQ(CompressedArray_size(ca), n);
+        ASSERT_EQ(ca->num_blocks, n / COMPRESSED_ARRAY_BLOCK_SIZE);
+        ASSERT_LT(CompressedArray_bytes(ca), n * sizeof(double) / 2);
+        for ( int i=0; i<n; i++ ) {
+            double x = DynamicArray_get(da, i), y = CompressedArray_get(ca, i);
+            ASSERT_EQ(memcmp(&x, &y, sizeof(double)), 0);
+        }
+        ASSERT_EQ(CompressedArray_get(ca, n), 0);
+        /* Iterating visits the same values in order */
+        CompressedArrayIterator it = CompressedArray_blocks(ca);
+        const double * data;
+        int length, total = 0;
+        while ( CompressedArrayIterator_next(&it, &data, &length) ) {
+            for ( int i=0; i<length; i++ ) {
+                ASSERT_EQ(data[i], DynamicArray_get(da, total + i));
+            }
+            total += length;
+        }
+        ASSERT_EQ(total, n);
+        DynamicArray_destroy(rest);
+        DynamicArray_destroy(da);
+        CompressedArray_destroy(ca);
+    }
+
+    TEST(CompressedArray, Summaries) {
+        CompressedArray * ca = CompressedArray_new();
+        for ( int i=0; i<5000; i++ ) {
+            CompressedArray_push(ca, i % 100);
+        }
+        ASSERT_EQ(CompressedArray_sum(ca), 50 * 99 * 50);
+        ASSERT_EQ(CompressedArray_min(ca), 0);
+        ASSERT_EQ(CompressedArray_max(ca), 99);
+        ASSERT_DOUBLE_EQ(CompressedArray_mean(ca), 49.5);
+        /* Partial blocks at both ends, whole blocks, and the tail */
+        CompressedSummary s = CompressedArray_summarize(ca, 1010, 4990);
+        double sum = 0;
+        for ( int i=1010; i<4990; i++ ) {
+            sum += i % 100;
+        }
+        ASSERT_EQ(s.count, 3980);
+        ASSERT_EQ(s.sum, sum);
+        ASSERT_EQ(s.min, 0);
+        ASSERT_EQ(s.max, 99);
+        s = CompressedArray_summarize(ca, 1030, 1040);
+        ASSERT_EQ(s.count, 10);
+        ASSERT_EQ(s.min, 30);
+        ASSERT_EQ(s.max, 39);
+        s = CompressedArray_summarize(ca, 4999, 10000);
+        ASSERT_EQ(s.count, 1);
+        ASSERT_EQ(s.sum, 99);
+        s = CompressedArray_summarize(ca, 10, 10);
+        ASSERT_EQ(s.count, 0);
+        ASSERT_EQ(s.sum, 0);
+        CompressedArray_destroy(ca);
+    }
+
+    TEST(DynamicArray, Arena) {
+        Arena * arena = arena_new(1024);
+        int live = DynamicArray_num_arrays();
+        for ( int round=0; round<3; round++ ) {
+            DynamicArray * a = DynamicArray_new_in(arena),
+                         * b = DynamicArray_new_in(arena);
+            for ( int i=0; i<1000; i++ ) {
+                DynamicArray_push(a, i);
+                DynamicArray_push_front(b, -i);
+            }
+            DynamicArray_set(a, 1500, 1);
+            ASSERT_EQ(DynamicArray_size(a), 1501);
+            ASSERT_EQ(DynamicArray_get(a, 999), 999);
+            ASSERT_EQ(DynamicArray_get(a, 1200), 0);
+            ASSERT_EQ(DynamicArray_get(b, 0), -999);
+            /* Buffers keep the alignment the SIMD kernels expect */
+            ASSERT_EQ((uintptr_t) a->buffer % ARRAY_MEMORY_ALIGNMENT, 0u);
+            ASSERT_EQ((uintptr_t) b->buffer % ARRAY_MEMORY_ALIGNMENT, 0u);
+            /* Views, cached stats and moves stay in the arena */
+            DynamicArray * view = DynamicArray_subarray(a, 10, 20);
+            DynamicArray_cache_stats(view, 1);
+            ASSERT_EQ(DynamicArray_sum(view), 145);
+            DynamicArray_set(view, 0, 100);
+            ASSERT_EQ(DynamicArray_get(a, 10), 10);
+            DynamicArray_append_move(a, b);
+            ASSERT_EQ(DynamicArray_size(a), 2501);
+            ASSERT_EQ(DynamicArray_size(b), 0);
+            ASSERT_EQ(DynamicArray_num_arrays(), live);
+            DynamicArray_destroy(view);
+            arena_reset(arena);
+        }
+        /* Only the most recent allocation grows in place */
+        void * p = arena_alloc(arena, 100),
+             * q = arena_realloc(arena, p, 100, 200);
+        ASSERT_EQ(p, q);
+        ASSERT_EQ((uintptr_t) arena_alloc(arena, 16) % ARRAY_MEMORY_ALIGNMENT, 0u);
+        ASSERT_NE(arena_realloc(arena, q, 200, 300), q);
+        arena_destroy(arena);
+    }
+
+}
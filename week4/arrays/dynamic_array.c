@@ -21,25 +21,28 @@ static int out_of_buffer ( DynamicArray * da, int offset ) {
     return offset < 0 || offset >= da->capacity;
 }
 
-/* Makes a new buffer that is twice the size of the old buffer,
-   copies the old information into the new buffer, and deletes
-   the old buffer */
-static void extend_buffer ( DynamicArray * da ) {
-
-    double * temp = (double *) calloc ( 2 * da->capacity, sizeof(double) );
-    int new_origin = da->capacity - (da->end - da->origin)/2,
-           new_end = new_origin + (da->end - da->origin);
-
-    for ( int i=0; i<DynamicArray_size(da); i++ ) {
-        temp[new_origin+i] = DynamicArray_get(da,i);
-    }
+/* Makes a new buffer with at least 'front' free slots before the first
+   element and 'back' free slots after the last one, copies the old
+   information into the middle of it, and deletes the old buffer. The new
+   buffer is twice the size of the old one, or as large as needed if that
+   is more, so a far index costs a single regrowth, and the elements move
+   with one memcpy. */
+static void extend_buffer ( DynamicArray * da, int front, int back ) {
+
+    int size = DynamicArray_size(da),
+        needed = front + size + back,
+        capacity = 2 * da->capacity > needed ? 2 * da->capacity : needed,
+        new_origin = front + (capacity - needed) / 2;
+    double * temp = (double *) calloc ( capacity, sizeof(double) );
+
+    memcpy(temp + new_origin, da->buffer + da->origin, size * sizeof(double));
 
     free(da->buffer);
     da->buffer = temp;
 
-    da->capacity = 2 * da->capacity;
+    da->capacity = capacity;
     da->origin = new_origin;
-    da->end = new_end;
+    da->end = new_origin + size;
 
     return;
 
@@ -109,8 +112,8 @@ void DynamicArray_print_debug_info(const DynamicArray * da) {
 void DynamicArray_set(DynamicArray * da, int index, double value) {
     assert(da->buffer != NULL);
     assert ( index >= 0 );
-    while ( out_of_buffer(da, index_to_offset(da, index) ) ) {
-        extend_buffer(da);
+    if ( out_of_buffer(da, index_to_offset(da, index) ) ) {
+        extend_buffer(da, 0, index + 1 - DynamicArray_size(da));
     }
     da->buffer[index_to_offset(da, index)] = value;
     if ( index >= DynamicArray_size(da) ) {
@@ -135,8 +138,8 @@ void DynamicArray_push(DynamicArray * da, double value ) {
 
 void DynamicArray_push_front(DynamicArray * da, double value) {
     assert(da->buffer != NULL);
-    while ( da->origin == 0 ) {
-        extend_buffer(da);
+    if ( da->origin == 0 ) {
+        extend_buffer(da, 1, 0);
     }
     da->origin--;
     DynamicArray_set(da,0,value);
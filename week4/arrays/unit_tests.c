@@ -47,6 +47,19 @@ namespace {
         DynamicArray_destroy(da);              
     }  
 
+    TEST(DynamicArray, FarIndexGrowsOnce) {
+        DynamicArray * da = DynamicArray_new();
+        DynamicArray_push(da, X);
+        DynamicArray_push_front(da, -X);
+        DynamicArray_set(da, 100000, X);
+        ASSERT_EQ(da->capacity, 100001);
+        ASSERT_EQ(DynamicArray_get(da,0), -X);
+        ASSERT_EQ(DynamicArray_get(da,1), X);
+        ASSERT_EQ(DynamicArray_get(da,500), 0);
+        ASSERT_EQ(DynamicArray_get(da,100000), X);
+        DynamicArray_destroy(da);
+    }
+
     TEST(DynamicArray, Push) {
         DynamicArray * da = DynamicArray_new();
         double x = 0;
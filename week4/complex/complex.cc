@@ -11,4 +11,29 @@ bool operator<(const Complex& a, const Complex& b) {
 
     return a.magnitude() < b.magnitude();
 
+}
+
+bool operator==(const Complex& a, const Complex& b) {
+
+    return a.real() == b.real() && a.imag() == b.imag();
+
+}
+
+Complex operator+(const Complex& a, const Complex& b) {
+
+    return Complex(a.real() + b.real(), a.imag() + b.imag());
+
+}
+
+Complex operator*(const Complex& a, const Complex& b) {
+
+    return Complex(a.real() * b.real() - a.imag() * b.imag(),
+                   a.real() * b.imag() + a.imag() * b.real());
+
+}
+
+Complex operator-(const Complex& a) {
+
+    return Complex(-a.real(), -a.imag());
+
 }
\ No newline at end of file
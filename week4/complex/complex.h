@@ -7,13 +7,20 @@ class Complex {
     public:
     Complex(double x, double y) : re(x), im(y) {}
     Complex(double a) : re(a), im(0) {};
+    Complex() : re(0), im(0) {};
 
     double magnitude() const;
+    double real() const { return re; }
+    double imag() const { return im; }
 
     private:
     double re, im;
 }; 
 
 bool operator<(const Complex& a, const Complex& b);
+bool operator==(const Complex& a, const Complex& b);
+Complex operator+(const Complex& a, const Complex& b);
+Complex operator*(const Complex& a, const Complex& b);
+Complex operator-(const Complex& a);
 
 #endif
\ No newline at end of file
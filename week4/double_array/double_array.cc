@@ -1,10 +1,23 @@
 #include <assert.h>
+#include <string.h>
 #include <stdexcept>
+#include <new>
 #include "double_array.h"
+#include "array_memory.h"
+
+/* A buffer of n doubles, aligned and, for large buffers, on huge pages. It is
+   zeroed unless the caller fills it anyway. */
+static double * allocate(int n, bool zero = true) {
+    auto buffer = (double *) array_memory_alloc(n * sizeof(double), zero);
+    if ( buffer == nullptr ) {
+        throw std::bad_alloc();
+    }
+    return buffer;
+}
 
 // Default constructor
 DoubleArray::DoubleArray() {
-    buffer = new double[INITIAL_CAPACITY]();
+    buffer = allocate(INITIAL_CAPACITY);
     capacity = INITIAL_CAPACITY;    
     origin = capacity / 2;
     end = origin;
@@ -27,8 +40,8 @@ DoubleArray::DoubleArray(const DoubleArray& other) : DoubleArray() {
 // Assignment operator: i.e DoubleArray b = a 
 DoubleArray& DoubleArray::operator=(const DoubleArray& other) {
     if ( this != &other) {
-        delete[] buffer; // don't forget this or you'll get a memory leak!
-        buffer = new double[other.capacity]();
+        array_memory_free(buffer, capacity * sizeof(double)); // don't forget this or you'll get a memory leak!
+        buffer = allocate(other.capacity);
         capacity = other.capacity;
         origin = other.origin;
         end = origin;
@@ -58,7 +71,7 @@ bool operator!=(const DoubleArray& a, const DoubleArray& b) {
 
 // Destructor
 DoubleArray::~DoubleArray() {
-    delete[] buffer;
+    array_memory_free(buffer, capacity * sizeof(double));
 }
 
 // Getters
@@ -108,19 +121,19 @@ bool DoubleArray::out_of_buffer ( int offset ) const {
 }
 
 /* Makes a new buffer that is twice the size of the old buffer,
-   copies the old information into the new buffer, and deletes
-   the old buffer */
+   copies the elements into the middle of it with one memcpy, and deletes
+   the old buffer. Only the slots around the elements are cleared. */
 void DoubleArray::extend_buffer() {
 
-    double * temp = new double[2 * capacity]();
+    double * temp = allocate(2 * capacity, false);
     int new_origin = capacity - (end - origin)/2,
            new_end = new_origin + (end - origin);
 
-    for ( int i=0; i<size(); i++ ) {
-        temp[new_origin+i] = get(i);
-    }
+    memset(temp, 0, new_origin * sizeof(double));
+    memcpy(temp + new_origin, buffer + origin, size() * sizeof(double));
+    memset(temp + new_end, 0, (2 * capacity - new_end) * sizeof(double));
 
-    delete[] buffer;
+    array_memory_free(buffer, capacity * sizeof(double));
     buffer = temp;
 
     capacity = 2 * capacity;
@@ -53,4 +53,16 @@ namespace {
         }
     }
 
-}
\ No newline at end of file
+    TEST(DoubleArray, LargeBuffers) {
+        DoubleArray a;
+        a.set(1 << 20, 1);
+        a.set(3, 2);
+        ASSERT_EQ(a.size(), (1 << 20) + 1);
+        ASSERT_EQ(a.get(3), 2);
+        ASSERT_EQ(a.get(1000), 0);
+        ASSERT_EQ(a.get(1 << 20), 1);
+        DoubleArray b(a);
+        ASSERT_EQ(a, b);
+    }
+
+}
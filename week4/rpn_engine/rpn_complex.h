@@ -0,0 +1,61 @@
+#ifndef RPN_COMPLEX
+#define RPN_COMPLEX
+
+#include <stdlib.h>
+#include "complex.h"
+#include "rpn_engine.h"
+
+/*! @file
+ *  Complex evaluation with the Complex class of week 4. An add or multiply
+ *  overflows when either part of its result is infinite.
+ */
+
+template <>
+struct RpnOperators<Complex> {
+
+    static bool infinite(const Complex& x) {
+        return isinf(x.real()) || isinf(x.imag());
+    }
+
+    static Complex add(const Complex& a, const Complex& b, bool& overflow) {
+        Complex x = a + b;
+        overflow = infinite(x);
+        return x;
+    }
+
+    static Complex multiply(const Complex& a, const Complex& b, bool& overflow) {
+        Complex x = a * b;
+        overflow = infinite(x);
+        return x;
+    }
+
+    static Complex negate(const Complex& a, bool& /*overflow*/) {
+        return -a;
+    }
+
+    // Reads a, bi, or a+bi and a-bi, with no spaces
+    static bool parse(const char * token, int length, Complex& x) {
+        char * end;
+        double re = strtod(token, &end), im = 0;
+        if ( end == token ) {
+            return false;
+        }
+        if ( *end == 'i' ) {
+            im = re;
+            re = 0;
+            end++;
+        } else if ( *end == '+' || *end == '-' ) {
+            const char * start = end;
+            im = strtod(start, &end);
+            if ( end == start || *end != 'i' ) {
+                return false;
+            }
+            end++;
+        }
+        x = Complex(re, im);
+        return end == token + length;
+    }
+
+};
+
+#endif
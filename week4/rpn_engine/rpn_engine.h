@@ -0,0 +1,188 @@
+#ifndef RPN_ENGINE
+#define RPN_ENGINE
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <vector>
+#include "rpn.h"
+
+/*! @file
+ *  An RPN calculator for any value type, with the operations and error codes of
+ *  the double-only RpnContext in week 2. The operations come from an operator
+ *  table: a class given as a template argument, whose static functions the
+ *  engine calls directly. The compiler sees which function every operation
+ *  calls and can inline it, so there is no virtual call or function pointer
+ *  per operation. An operator table has
+ *
+ *      static Value add(const Value& a, const Value& b, bool& overflow);
+ *      static Value multiply(const Value& a, const Value& b, bool& overflow);
+ *      static Value negate(const Value& a, bool& overflow);
+ *
+ *  each of which sets overflow if its result could not be represented, and, to
+ *  evaluate formulas from text,
+ *
+ *      static bool parse(const char * token, int length, Value& x);
+ *
+ *  RpnOperators<Value> is the default table. The general one uses the type's
+ *  own +, * and unary -, and never overflows; the one for double overflows
+ *  as rpn_add and rpn_multiply do. rpn_fraction.h and rpn_complex.h add
+ *  tables for Fraction and Complex, and a program can write its own. Values
+ *  must have a default constructor, which gives what pop returns on an error.
+ */
+
+template <typename Value>
+struct RpnOperators {
+    static Value add(const Value& a, const Value& b, bool& /*overflow*/) { return a + b; }
+    static Value multiply(const Value& a, const Value& b, bool& /*overflow*/) { return a * b; }
+    static Value negate(const Value& a, bool& /*overflow*/) { return -a; }
+};
+
+template <>
+struct RpnOperators<double> {
+
+    static double add(double a, double b, bool& overflow) {
+        double x = a + b;
+        overflow = x == INFINITY;
+        return x;
+    }
+
+    static double multiply(double a, double b, bool& overflow) {
+        double x = a * b;
+        overflow = x == INFINITY || x == -INFINITY;
+        return x;
+    }
+
+    static double negate(double a, bool& /*overflow*/) {
+        return -a;
+    }
+
+    static bool parse(const char * token, int length, double& x) {
+        char * end;
+        x = strtod(token, &end);
+        return end == token + length;
+    }
+
+};
+
+template <typename Value, typename Operators = RpnOperators<Value>>
+class RpnEngine {
+
+public:
+
+    RpnEngine() : status(OK) {}
+
+    void push(const Value& x) {
+        stack.push_back(x);
+    }
+
+    // The second operand is the one on top, so a b + gives Operators::add(a, b)
+    void add() {
+        if ( stack.size() < 2 ) {
+            status = BINARY_ERROR;
+        } else {
+            bool overflow = false;
+            Value x = Operators::add(stack[stack.size()-2], stack.back(), overflow);
+            finish_binary(x, overflow);
+        }
+    }
+
+    void multiply() {
+        if ( stack.size() < 2 ) {
+            status = BINARY_ERROR;
+        } else {
+            bool overflow = false;
+            Value x = Operators::multiply(stack[stack.size()-2], stack.back(), overflow);
+            finish_binary(x, overflow);
+        }
+    }
+
+    void negate() {
+        if ( stack.empty() ) {
+            status = UNARY_ERROR;
+        } else {
+            bool overflow = false;
+            stack.back() = Operators::negate(stack.back(), overflow);
+            if ( overflow ) {
+                status = OVERFLOW_ERROR;
+            }
+        }
+    }
+
+    // Returns the top of the stack, or sets POP_ERROR and returns Value() if it is empty
+    Value pop() {
+        if ( stack.empty() ) {
+            status = POP_ERROR;
+            return Value();
+        }
+        Value x = stack.back();
+        stack.pop_back();
+        return x;
+    }
+
+    int size() const {
+        return (int) stack.size();
+    }
+
+    // As with RpnContext, an error stays set until reset
+    RPN_ERROR error() const {
+        return status;
+    }
+
+    // Empties the stack and clears the error, keeping the memory for reuse
+    void reset() {
+        stack.clear();
+        status = OK;
+    }
+
+    // Runs a formula of values, the operators +, * and neg (or ~), separated by white
+    // space, on the current stack, and returns the value it leaves on top. Sets
+    // SYNTAX_ERROR if a token is neither an operator nor a value Operators::parse
+    // accepts. Stops at the first error.
+    Value evaluate(const char * formula) {
+        const char * s = formula;
+        while ( status == OK ) {
+            while ( isspace((unsigned char) *s) ) {
+                s++;
+            }
+            if ( *s == '\0' ) {
+                return pop();
+            }
+            const char * start = s;
+            while ( *s != '\0' && !isspace((unsigned char) *s) ) {
+                s++;
+            }
+            int length = (int) ( s - start );
+            Value x;
+            if ( length == 1 && *start == '+' ) {
+                add();
+            } else if ( length == 1 && *start == '*' ) {
+                multiply();
+            } else if ( ( length == 1 && *start == '~' ) || ( length == 3 && strncmp(start, "neg", 3) == 0 ) ) {
+                negate();
+            } else if ( Operators::parse(start, length, x) ) {
+                push(x);
+            } else {
+                status = SYNTAX_ERROR;
+            }
+        }
+        return Value();
+    }
+
+private:
+
+    std::vector<Value> stack;
+    RPN_ERROR status;
+
+    void finish_binary(const Value& x, bool overflow) {
+        if ( overflow ) {
+            status = OVERFLOW_ERROR;
+        }
+        stack.pop_back();
+        stack.back() = x;
+    }
+
+};
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef RPN_FRACTION
+#define RPN_FRACTION
+
+#include <stdlib.h>
+#include "fraction.h"
+#include "rpn_engine.h"
+
+/*! @file
+ *  Exact rational evaluation with the Fraction struct of week 2. Results are
+ *  kept in lowest terms with a positive denominator, so a formula only
+ *  overflows when a reduced numerator or denominator no longer fits in an int,
+ *  which is checked on every step rather than left to wrap around.
+ */
+
+template <>
+struct RpnOperators<Fraction> {
+
+    // Reduces num/den, computed in 64 bits, to lowest terms
+    static Fraction reduce(long long num, long long den, bool& overflow) {
+        if ( den < 0 ) {
+            num = -num;
+            den = -den;
+        }
+        long long a = llabs(num), b = den;
+        while ( b != 0 ) {
+            long long r = a % b;
+            a = b;
+            b = r;
+        }
+        if ( a > 1 ) {
+            num /= a;
+            den /= a;
+        }
+        overflow = num != (int) num || den != (int) den;
+        Fraction x = { (int) num, (int) den };
+        return x;
+    }
+
+    // The products of two ints fit in 64 bits, and so does a sum of two of them
+    static Fraction add(const Fraction& a, const Fraction& b, bool& overflow) {
+        return reduce((long long) a.num * b.den + (long long) b.num * a.den,
+                      (long long) a.den * b.den, overflow);
+    }
+
+    static Fraction multiply(const Fraction& a, const Fraction& b, bool& overflow) {
+        return reduce((long long) a.num * b.num, (long long) a.den * b.den, overflow);
+    }
+
+    static Fraction negate(const Fraction& a, bool& overflow) {
+        return reduce(-(long long) a.num, a.den, overflow);
+    }
+
+    // Reads p/q or p, with q not 0
+    static bool parse(const char * token, int length, Fraction& x) {
+        char * end;
+        long long num = strtoll(token, &end, 10), den = 1;
+        if ( end == token ) {
+            return false;
+        }
+        if ( *end == '/' ) {
+            const char * d = end + 1;
+            den = strtoll(d, &end, 10);
+            if ( end == d || den == 0 ) {
+                return false;
+            }
+        }
+        bool overflow;
+        x = reduce(num, den, overflow);
+        return end == token + length && !overflow;
+    }
+
+};
+
+#endif
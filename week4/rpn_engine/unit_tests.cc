@@ -0,0 +1,129 @@
+#include <math.h>
+#include <float.h> /* defines DBL_MAX */
+#include <limits.h>
+#include "rpn_engine.h"
+#include "rpn_fraction.h"
+#include "rpn_complex.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+    // A user-defined table: the max-plus semiring on ints, where "add" takes the
+    // larger value and "multiply" adds, as in longest path problems
+    struct MaxPlus {
+        static int add(int a, int b, bool& /*overflow*/) { return a > b ? a : b; }
+        static int multiply(int a, int b, bool& overflow) {
+            int x;
+            overflow = __builtin_add_overflow(a, b, &x);
+            return x;
+        }
+        static int negate(int a, bool& /*overflow*/) { return -a; }
+        static bool parse(const char * token, int length, int& x) {
+            char * end;
+            x = (int) strtol(token, &end, 10);
+            return end == token + length;
+        }
+    };
+
+    TEST(RpnEngine, Double) {
+
+        RpnEngine<double> rpn;
+        rpn.push(0.5);
+        rpn.push(2);
+        rpn.push(1);
+        rpn.add();
+        rpn.multiply();
+        rpn.negate();
+        EXPECT_EQ(rpn.pop(), -1.5);
+        EXPECT_EQ(rpn.error(), OK);
+
+        EXPECT_EQ(rpn.evaluate("0.5 2 1 + * neg"), -1.5);
+        EXPECT_EQ(rpn.size(), 0);
+
+        // The same errors as RpnContext, which stay set until reset
+        rpn.add();
+        EXPECT_EQ(rpn.error(), BINARY_ERROR);
+        rpn.reset();
+        rpn.negate();
+        EXPECT_EQ(rpn.error(), UNARY_ERROR);
+        rpn.reset();
+        rpn.pop();
+        EXPECT_EQ(rpn.error(), POP_ERROR);
+        rpn.reset();
+        rpn.evaluate("1 2 -");
+        EXPECT_EQ(rpn.error(), SYNTAX_ERROR);
+        rpn.reset();
+        rpn.evaluate("1.7e308 1.7e308 ~ *");
+        EXPECT_EQ(rpn.error(), OVERFLOW_ERROR);
+        rpn.reset();
+
+        // Adds only report an overflow to +INF, as rpn_add does
+        EXPECT_EQ(rpn.evaluate("-1.7e308 -1.7e308 +"), -INFINITY);
+        EXPECT_EQ(rpn.error(), OK);
+
+    }
+
+    TEST(RpnEngine, Fraction) {
+
+        RpnEngine<Fraction> rpn;
+        Fraction x = rpn.evaluate("1/3 1/6 + 3/4 *");
+        EXPECT_EQ(rpn.error(), OK);
+        EXPECT_EQ(x.num, 3);
+        EXPECT_EQ(x.den, 8);
+
+        x = rpn.evaluate("2/-4 neg 1/2 neg +");
+        EXPECT_EQ(x.num, 0);
+        EXPECT_EQ(x.den, 1);
+
+        // Exact where doubles are not: 1/10 added ten times is 1
+        rpn.push((Fraction) { 0, 1 });
+        for ( int i=0; i<10; i++ ) {
+            rpn.push((Fraction) { 1, 10 });
+            rpn.add();
+        }
+        x = rpn.pop();
+        EXPECT_EQ(x.num, 1);
+        EXPECT_EQ(x.den, 1);
+
+        // Reduced terms that no longer fit in an int overflow
+        rpn.evaluate("65536 65536 *");
+        EXPECT_EQ(rpn.error(), OVERFLOW_ERROR);
+        rpn.reset();
+        x = rpn.evaluate("65536/3 3/65536 *");
+        EXPECT_EQ(rpn.error(), OK);
+        EXPECT_EQ(x.num, 1);
+        rpn.evaluate("1/2 1.5 +");
+        EXPECT_EQ(rpn.error(), SYNTAX_ERROR);
+
+    }
+
+    TEST(RpnEngine, Complex) {
+
+        RpnEngine<Complex> rpn;
+        EXPECT_EQ(rpn.evaluate("1+2i 3-1i *"), Complex(5, 5));
+        EXPECT_EQ(rpn.evaluate("2i 2i * 4 +"), Complex(0, 0));
+        EXPECT_EQ(rpn.evaluate("1.5 -0.5i + neg"), Complex(-1.5, 0.5));
+        EXPECT_EQ(rpn.error(), OK);
+
+        rpn.push(Complex(0, DBL_MAX));
+        rpn.push(Complex(0, DBL_MAX));
+        rpn.add();
+        EXPECT_EQ(rpn.error(), OVERFLOW_ERROR);
+        rpn.reset();
+        rpn.evaluate("1+i");
+        EXPECT_EQ(rpn.error(), SYNTAX_ERROR);
+
+    }
+
+    TEST(RpnEngine, OperatorTables) {
+
+        RpnEngine<int, MaxPlus> rpn;
+        // The longest of the paths 3 then 4, or 5 then 1
+        EXPECT_EQ(rpn.evaluate("3 4 * 5 1 * +"), 7);
+        EXPECT_EQ(rpn.error(), OK);
+        rpn.evaluate("2147483647 1 *");
+        EXPECT_EQ(rpn.error(), OVERFLOW_ERROR);
+
+    }
+
+}
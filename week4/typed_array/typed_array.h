@@ -4,6 +4,9 @@
 #include <assert.h>
 #include <iostream>
 #include <stdexcept>
+#include <new>
+#include <type_traits>
+#include "array_memory.h"
 
 template <typename ElementType>
 class TypedArray {
@@ -42,11 +45,14 @@ private:
     bool out_of_buffer(int offset) const;
     void extend_buffer(void);    
 
+    static ElementType * allocate(int n);
+    static void release(ElementType * buffer, int n);
+
 };
 
 template <typename ElementType>
 TypedArray<ElementType>::TypedArray() {
-    buffer = new ElementType[INITIAL_CAPACITY]();
+    buffer = allocate(INITIAL_CAPACITY);
     capacity = INITIAL_CAPACITY;    
     origin = capacity / 2;
     end = origin;    
@@ -62,8 +68,8 @@ TypedArray<ElementType>::TypedArray(const TypedArray& other) : TypedArray() {
 template <typename ElementType>
 TypedArray<ElementType>& TypedArray<ElementType>::operator=(const TypedArray<ElementType>& other) {
     if ( this != &other) {
-        delete[] buffer; // don't forget this or you'll get a memory leak!
-        buffer = new ElementType[other.capacity]();
+        release(buffer, capacity); // don't forget this or you'll get a memory leak!
+        buffer = allocate(other.capacity);
         capacity = other.capacity;
         origin = other.origin;
         end = origin;
@@ -77,7 +83,7 @@ TypedArray<ElementType>& TypedArray<ElementType>::operator=(const TypedArray<Ele
 // Destructor
 template <typename ElementType>
 TypedArray<ElementType>::~TypedArray() {
-    delete[] buffer;
+    release(buffer, capacity);
 }
 
 // Getters
@@ -162,7 +168,7 @@ bool TypedArray<ElementType>::out_of_buffer ( int offset ) const {
 template <typename ElementType>
 void TypedArray<ElementType>::extend_buffer() {
 
-    auto temp = new ElementType[2 * capacity]();
+    auto temp = allocate(2 * capacity);
     int new_origin = capacity - (end - origin)/2,
            new_end = new_origin + (end - origin);
 
@@ -170,7 +176,7 @@ void TypedArray<ElementType>::extend_buffer() {
         temp[new_origin+i] = get(i);
     }
 
-    delete[] buffer;
+    release(buffer, capacity);
     buffer = temp;
 
     capacity = 2 * capacity;
@@ -181,4 +187,33 @@ void TypedArray<ElementType>::extend_buffer() {
 
 }
 
-#endif
\ No newline at end of file
+/* Makes a buffer of n value-initialized elements, like new ElementType[n](), but
+   aligned and, for large buffers, on huge pages. Types that value-initialize to
+   zeros are just cleared, which is free for large buffers. */
+template <typename ElementType>
+ElementType * TypedArray<ElementType>::allocate(int n) {
+    bool trivial = std::is_trivially_default_constructible<ElementType>::value;
+    auto buffer = (ElementType *) array_memory_alloc(n * sizeof(ElementType), trivial);
+    if ( buffer == nullptr ) {
+        throw std::bad_alloc();
+    }
+    if ( !trivial ) {
+        for ( int i=0; i<n; i++ ) {
+            new (buffer + i) ElementType();
+        }
+    }
+    return buffer;
+}
+
+/* Destroys the n elements of a buffer from allocate and frees it */
+template <typename ElementType>
+void TypedArray<ElementType>::release(ElementType * buffer, int n) {
+    if ( !std::is_trivially_destructible<ElementType>::value ) {
+        for ( int i=0; i<n; i++ ) {
+            buffer[i].~ElementType();
+        }
+    }
+    array_memory_free(buffer, n * sizeof(ElementType));
+}
+
+#endif
@@ -62,6 +62,20 @@ namespace {
                                                // then we would expect m[0][0]
                                                // to be x[0], which we changed 
                                                // to -1.
-    }    
+    }
+
+    TEST(TypedArray, LargeBuffers) {
+        TypedArray<Point> a;
+        a.set(1 << 20, Point(1,2,3));
+        EXPECT_EQ(a.size(), (1 << 20) + 1);
+        EXPECT_EQ(a.get(1 << 20).y, 2);
+        EXPECT_EQ(a.get(1000).x, 0);
+        TypedArray<TypedArray<double>> m;
+        for ( int i=0; i<1000; i++ ) {
+            m.get(i).set(i, i);
+        }
+        EXPECT_EQ(m.get(999).get(999), 999);
+        EXPECT_EQ(m.get(999).get(3), 0);
+    }
 
-}
\ No newline at end of file
+}